@@ -0,0 +1,35 @@
+# Find the zstd libraries
+#
+# The following variables are optionally searched for defaults
+#  ZSTD_ROOT_DIR: Base directory where all zstd components are found
+#  ZSTD_INCLUDE_DIR: Directory where zstd headers are found
+#  ZSTD_LIB_DIR: Directory where zstd libraries are found
+
+# The following are set after configuration is done:
+#  ZSTD_FOUND
+#  ZSTD_INCLUDE_DIRS
+#  ZSTD_LIBRARIES
+
+find_path(ZSTD_INCLUDE_DIRS
+    NAMES zstd.h
+    HINTS
+    ${ZSTD_INCLUDE_DIR}
+    ${ZSTD_ROOT_DIR}
+    ${ZSTD_ROOT_DIR}/include)
+if(NOT ZSTD_INCLUDE_DIRS)
+    message(FATAL_ERROR "Fail to find zstd header")
+endif()
+
+find_library(ZSTD_LIBRARIES
+    NAMES zstd
+    HINTS
+    ${ZSTD_LIB_DIR}
+    ${ZSTD_ROOT_DIR}
+    ${ZSTD_ROOT_DIR}/lib)
+if(NOT ZSTD_LIBRARIES)
+    message(FATAL_ERROR "Fail to find zstd lib")
+endif()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(zstd DEFAULT_MSG ZSTD_INCLUDE_DIRS ZSTD_LIBRARIES)
+mark_as_advanced(ZSTD_INCLUDE_DIRS ZSTD_LIBRARIES)
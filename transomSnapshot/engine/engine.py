@@ -110,13 +110,26 @@ def load(f, map_location=None, pickle_module=pickle, **pickle_load_args) -> Any:
     helper._check_dill_version(pickle_module)
 
     filename = str(f)
-    checkpointstate, pid, memfd = LoadMetaRequest(filename)
+    checkpointstate, pid, memfd, size = LoadMetaRequest(filename)
     logger.debug("checkpointstate: {}".format(CheckpointState(checkpointstate).name))
     mem_checkpoint = f"/proc/{pid}/fd/{memfd}"
+    if not Path(mem_checkpoint).exists():
+        # memory is released since, ask again and the server restores it from its persisted form,
+        # which may be a manifest, compressed or striped file beside the path
+        logger.debug("in-memory checkpoint of {} is gone, ask server to restore it".format(filename))
+        try:
+            checkpointstate, pid, memfd, size = LoadMetaRequest(filename)
+            mem_checkpoint = f"/proc/{pid}/fd/{memfd}"
+        except RuntimeError as e:
+            logger.warning("failed to restore {} by server: {}".format(filename, e))
     if Path(mem_checkpoint).exists():
         logger.debug(
             "load from in-memory: {} pid:{} memfd:{}".format(filename, pid, memfd)
         )
+        if size and os.path.getsize(mem_checkpoint) > size:
+            # memfd on hugetlbfs is padded to whole huge pages
+            with open(mem_checkpoint, "rb") as fp:
+                return torch.load(io.BytesIO(fp.read(size)), map_location)
         return torch.load(mem_checkpoint, map_location)
     elif Path(f).exists():
         logger.debug("load from persistent checkpoint: {}".format(f))
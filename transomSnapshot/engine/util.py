@@ -36,7 +36,11 @@ def SaveMetaRequest(
         "iteration": iteration,
         "checkpointstate": checkpointstate.value,
         "size": size,
+        "pid": os.getpid(),
     }
+    # memory is placed on NUMA node of this process, which is derived from its cpu affinity if not set
+    if os.getenv("CKPT_ENGINE_NUMA_NODE") is not None:
+        metadata["numanode"] = int(os.getenv("CKPT_ENGINE_NUMA_NODE"))
     # logger.debug("SaveMetaRequest params: {}", metadata)
     response = requests.get(
         ENGINE_SERVER_URL + "/createMetadata", data=json.dumps(metadata)
@@ -87,4 +91,4 @@ def LoadMetaRequest(filename: str):
     logger.debug(resp["message"])
     if resp["status"] == "ERROR":
         raise RuntimeError(resp["message"])
-    return resp["checkpointstate"], resp["pid"], resp["memfd"]
+    return resp["checkpointstate"], resp["pid"], resp["memfd"], resp.get("size", 0)
@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <thread>
@@ -104,15 +105,22 @@ bool transom_memcpy(char *Pyshared_mem_name, char *Pymetadata_ptr, size_t Pymeta
     fstat(fd, &sb);
     size_t file_size = sb.st_size;
     // printf("C++> proc_file:%s size %ld shm_size %ld\n", proc_file.c_str(), file_size, shm_size);
-    if (file_size != shm_size) {
-        printf("C++> error: %s size != shm_size %ld != %ld\n", proc_file.c_str(), file_size, shm_size);
+    // hugetlb memfd is rounded up to whole huge pages
+    if (file_size < shm_size) {
+        printf("C++> error: %s size < shm_size %ld < %ld\n", proc_file.c_str(), file_size, shm_size);
         return false;
     }
-    char *shm_addr = reinterpret_cast<char *>(mmap(nullptr, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    char *shm_addr = reinterpret_cast<char *>(mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
     if (shm_addr == reinterpret_cast<char *>(MAP_FAILED)) {
         perror("error: Failed to mmap");
         return false;
     }
+    // pages are faulted through this mapping on first write, advise THP as the server does unless it is off,
+    // otherwise they are 4K whatever the server advised on its own mapping
+    const char *huge_page = getenv("CKPT_ENGINE_HUGE_PAGE");
+    if (huge_page == nullptr || strcmp(huge_page, "off") != 0) {
+        madvise(shm_addr, file_size, MADV_HUGEPAGE);
+    }
     auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::high_resolution_clock::now() - start_time);
     printf("C++> remove-create-set shm: %s elapsed time: %ld ms, shm_size: %ld tensor_addr: 0x%lx\n",
@@ -224,8 +232,8 @@ bool transom_memcpy(char *Pyshared_mem_name, char *Pymetadata_ptr, size_t Pymeta
             CudaSafeCall(cudaFreeHost(pin_buffer[i]));
         }
     }
-    std::thread([shm_addr, shm_size]() {
-        if (munmap(shm_addr, shm_size) != 0) {
+    std::thread([shm_addr, file_size]() {
+        if (munmap(shm_addr, file_size) != 0) {
             perror("error: munmap failed");
         }
     }).detach();
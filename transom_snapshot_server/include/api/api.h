@@ -238,6 +238,7 @@ public:
         address = entry.address;
         pid = entry.pid;
         memfd = entry.memfd;
+        numa_node = entry.numa_node;
     }
 
     void Marshal(Buffer &buffer) override;
@@ -259,6 +260,12 @@ public:
      * @details to know more about `memfd`, refer to [memfd](https://man7.org/linux/man-pages/man2/memfd_create.2.html)
      */
     int memfd = 0;
+
+    /**
+     * @brief NUMA node memory is placed on, -1 if not bound
+     * @details set by requester before allocation, it's local and not marshaled
+     */
+    int numa_node = -1;
 };
 
 /**
@@ -399,6 +406,11 @@ public:
     void Unmarshal(Buffer &buffer) override;
     std::string String() override;
 
+    /**
+     * @brief return true if metadata passes the filter, same as querying database
+     */
+    bool Match(const Metadata &metadata) const;
+
     /**
      * @brief -1 for unspecified, otherwise filter result with given node rank
      */
@@ -25,11 +25,18 @@
 #include "communicator/http/remote_file_loader.h"
 #include "config/iteration_manager.h"
 #include "config/world.h"
+#include "coordinator/restorer.h"
 #include "logger/logger.h"
 #include "monitor/monitor.h"
+#include "operator/bandwidth_limiter.h"
 #include "operator/operator.h"
+#include "operator/persist_queue.h"
+#include "storage/cold_tier.h"
+#include "storage/eviction.h"
+#include "storage/metadata_batcher.h"
 #include "storage/storage.h"
 #include "util/channel.h"
+#include "util/numa.h"
 #include "util/util.h"
 
 #define return_resp(status, message, state)     \
@@ -61,17 +68,15 @@ private:
      */
     std::shared_ptr<std::atomic<bool>> ready_;
 
-    /**
-     * @brief read-write lock to make sure that there is only one request to delete the old Checkpoint
-     */
-    inline static std::shared_mutex rw_mutex_ = {};
-
 public:
     HttpServiceImpl() = default;
     HttpServiceImpl(std::shared_ptr<operators::Operator> controller,
                     std::shared_ptr<std::atomic<bool>> ready) {
         controller_ = controller;
         ready_ = ready;
+        storage::Evictor::Instance().SetHandler([this](size_t iteration) {
+            return deleteIteration(iteration);
+        });
     }
 
     void getMetadata(google::protobuf::RpcController *cntl_base,
@@ -87,13 +92,6 @@ public:
 
         std::string file_name = req->filename();
         // LOG_DEBUG("FileName {}", raw_filename);
-        // check whether bootstrap is completed
-        if (wait_ready() == false) {
-            std::string message = "bootstrap timed out in "
-                                  + std::to_string(config::CHECK_BOOTSTRAP_RETRY_INTERVAL_SECONDS)
-                                  + "s and did not complete. Please check the server";
-            return_resp("ERROR", message, -1);
-        }
         /* try get metadata */
         api::Metadata metadata(WorldState::Instance().JobName(), file_name);
         auto meta_client = storage::MetadataClientFactory::GetClient();
@@ -105,6 +103,19 @@ public:
             return_resp("ERROR", "get metadata failed from database, Please check if the file exists", -1);
         }
 
+        // check whether bootstrap is completed, a file restored already is served without waiting for the rest
+        if (!ready_->load() && !Storage::Instance().Restored(file_name) && wait_ready() == false) {
+            std::string message = "bootstrap timed out in "
+                                  + std::to_string(config::CHECK_BOOTSTRAP_RETRY_INTERVAL_SECONDS)
+                                  + "s and did not complete. Please check the server";
+            return_resp("ERROR", message, -1);
+        }
+        // with lazy restore, a file may not be restored yet, restore it ahead of the others. A failure may be
+        // transient, the file is restored on demand again below if it's still not in memory
+        if (!coordinator::Restorer::Instance().Fetch(file_name)) {
+            LOG_WARN("lazy restore of {} failed, restore it on demand", file_name);
+        }
+
         /* unless file is obsolescent or broken or pending, it should be in shm or memory already */
         if (metadata.state == api::CheckpointState::BROKEN || metadata.state == api::CheckpointState::OBSOLESCENT
             || metadata.state == api::CheckpointState::PENDING) {
@@ -127,12 +138,23 @@ public:
     found_metadata:
         api::DataEntry entry;
         if (!storage::Storage::Instance().Load(std::ref(metadata), std::ref(entry))) {
-            LOG_ERROR("load storage failed");
-            return_resp("ERROR", "in-memory checkpoint does not exist in local or backup", metadata.state);
+            /* memory of a persisted checkpoint of this node is gone, restore it from file system on demand */
+            if (metadata.node_rank != WorldState::Instance().NodeRank()
+                || metadata.state != api::CheckpointState::PERSISTENT) {
+                LOG_ERROR("load storage failed");
+                return_resp("ERROR", "in-memory checkpoint does not exist in local or backup", metadata.state);
+            }
+            LOG_INFO("{} is not in memory, restore it from file system", file_name);
+            if (!coordinator::Restorer::Restore(metadata)
+                || !storage::Storage::Instance().Load(std::ref(metadata), std::ref(entry))) {
+                return_resp("ERROR", "failed to restore checkpoint from file system", metadata.state);
+            }
         }
         LOG_DEBUG("entry: {}", entry.String());
         res->set_pid(entry.pid);
         res->set_memfd(entry.memfd);
+        /* hugetlb memfd is larger than checkpoint */
+        res->set_size(metadata.size);
         return_resp("OK", "Metadata was successfully got", metadata.state);
     }
 
@@ -162,34 +184,32 @@ public:
                                static_cast<CheckpointState>(state), size);
         auto meta_client = storage::MetadataClientFactory::GetClient();
 
-        // check whether max_iteration has been reached
-        std::string delete_min_iteration_msg = "";
+        // a new iteration may exceed max iterations or memory budget, old ones are evicted in background
         if (iteration != "unknown") {
             const auto iter = std::stoul(iteration);
-            rw_mutex_.lock();
             if (!IterationManager::Instance().isExist(iter)) {
-                if (IterationManager::Instance().totalIteration() >= IterationManager::Instance().maxIteration()) {
-                    delete_min_iteration_msg = " exceed max iteration: "
-                                               + std::to_string(IterationManager::Instance().maxIteration())
-                                               + ", delete only the oldest iteration: "
-                                               + std::to_string(IterationManager::Instance().oldestIteration())
-                                               + " in-memory, we do not delete persistent checkpoints!";
-                    LOG_WARN("Exceed max iteration: {} totalIteration: {}",
-                             IterationManager::Instance().maxIteration(), IterationManager::Instance().totalIteration());
-                    if (!deleteOldestIteration(std::to_string(IterationManager::Instance().oldestIteration()))) {
-                        rw_mutex_.unlock();
-                        return_resp("ERROR", "deleteMinIteration failed", -1);
-                    }
-                }
                 IterationManager::Instance().pushIteration(iter);
+                storage::Evictor::Instance().Notify();
             }
-            rw_mutex_.unlock();
         }
 
         api::DataEntry entry;
         if (!storage::Storage::Instance().Load(std::ref(metadata), std::ref(entry))) {
             LOG_DEBUG("{} doesn't exists, memfdCalloc", metadata.file_name);
-            auto rc = MemoryMonitor::Instance().TryMemfdMalloc(std::ref(metadata), std::ref(entry));
+            /* place memory on the node of the rank, told by client or learnt from its cpu affinity */
+            if (req->has_numanode()) {
+                entry.numa_node = req->numanode();
+            } else if (req->has_pid()) {
+                entry.numa_node = util::Numa::NodeOfPid(req->pid());
+            }
+            auto &monitor = MemoryMonitor::Instance();
+            auto rc = monitor.TryMemfdMalloc(std::ref(metadata), std::ref(entry), monitor::MEMORY_OWN);
+            if (api::IsOOM(rc)) {
+                /* spill to cold tier, then wait for memory being released by others */
+                Storage::Instance().Reclaim(metadata.size);
+                rc = monitor.TryMemfdMalloc(std::ref(metadata), std::ref(entry), monitor::MEMORY_OWN,
+                                            monitor.WaitMs());
+            }
             if (api::IsOOM(rc)) {
                 return_resp("ERROR", "memfdCalloc failed: out of memory", state);
             }
@@ -216,7 +236,7 @@ public:
         if (!api::IsSuccess(rc)) {
             return_resp("ERROR", "save Metadata failed", state);
         }
-        return_resp("OK", "Metadata was successfully created." + delete_min_iteration_msg, state);
+        return_resp("OK", "Metadata was successfully created.", state);
     }
 
     void updateMetadata(google::protobuf::RpcController *cntl_base,
@@ -232,9 +252,8 @@ public:
 
         std::string file_name = req->filename();
         int state = req->checkpointstate();
-        /* try update metadata state */
-        auto meta_client = storage::MetadataClientFactory::GetClient();
-        auto rc = meta_client->UpdateState(file_name, static_cast<CheckpointState>(state));
+        /* try update metadata state, batched with local ranks updating their files meanwhile */
+        auto rc = storage::MetadataBatcher::Instance().UpdateState(file_name, static_cast<CheckpointState>(state));
         if (!api::IsSuccess(rc)) {
             return_resp("ERROR", "update metadata state failed", state - 1);
         }
@@ -304,6 +323,115 @@ public:
         LOG_DEBUG("dict size {} backup_dict size {}", res->cli_dict_size(), res->cli_backup_dict_size());
     }
 
+    void getBandwidth(google::protobuf::RpcController *cntl_base,
+                      const BandwidthRequest *, BandwidthResponse *res,
+                      google::protobuf::Closure *done) {
+        brpc::ClosureGuard done_guard(done);
+
+        brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
+        cntl->http_response().set_content_type("application/json");
+
+        fill_budgets(res);
+        res->set_status("OK");
+    }
+
+    /**
+     * @brief change bandwidth budget at runtime, e.g. {"stage": "persist", "bytes_per_second": 104857600},
+     * 0 means unlimited
+     */
+    void setBandwidth(google::protobuf::RpcController *cntl_base,
+                      const BandwidthRequest *req, BandwidthResponse *res,
+                      google::protobuf::Closure *done) {
+        brpc::ClosureGuard done_guard(done);
+
+        brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
+        cntl->http_response().set_content_type("application/json");
+
+        operators::TrafficStage stage;
+        if (!operators::ParseTrafficStage(req->stage(), std::ref(stage))) {
+            LOG_ERROR("unknown bandwidth stage {}", req->stage());
+            res->set_status("ERROR");
+            res->set_message("server: unknown stage " + req->stage() + ", expect node, persist or backup");
+            return;
+        }
+        operators::BandwidthLimiter::Instance().SetRate(stage, req->bytes_per_second());
+        fill_budgets(res);
+        res->set_status("OK");
+    }
+
+    void getPins(google::protobuf::RpcController *cntl_base,
+                 const PinRequest *, PinResponse *res,
+                 google::protobuf::Closure *done) {
+        brpc::ClosureGuard done_guard(done);
+
+        brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
+        cntl->http_response().set_content_type("application/json");
+
+        fill_pins(res);
+        res->set_status("OK");
+    }
+
+    /**
+     * @brief keep an iteration from eviction, e.g. {"tag": "best", "iteration": "1000"}. A tag pins one iteration,
+     * pinning it again moves the pin
+     */
+    void pinIteration(google::protobuf::RpcController *cntl_base,
+                      const PinRequest *req, PinResponse *res,
+                      google::protobuf::Closure *done) {
+        brpc::ClosureGuard done_guard(done);
+
+        brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
+        cntl->http_response().set_content_type("application/json");
+
+        auto iteration = operators::PersistTask::ParseIteration(req->iteration());
+        if (iteration == operators::PersistTask::UNKNOWN_ITERATION) {
+            LOG_ERROR("cannot pin iteration {}", req->iteration());
+            res->set_status("ERROR");
+            res->set_message("server: invalid iteration " + req->iteration());
+            return;
+        }
+        /* tag defaults to iteration itself */
+        auto tag = req->tag().empty() ? req->iteration() : req->tag();
+        storage::Evictor::Instance().Pin(tag, static_cast<size_t>(iteration));
+        fill_pins(res);
+        res->set_status("OK");
+    }
+
+    void unpinIteration(google::protobuf::RpcController *cntl_base,
+                        const PinRequest *req, PinResponse *res,
+                        google::protobuf::Closure *done) {
+        brpc::ClosureGuard done_guard(done);
+
+        brpc::Controller *cntl = static_cast<brpc::Controller *>(cntl_base);
+        cntl->http_response().set_content_type("application/json");
+
+        auto tag = req->tag().empty() ? req->iteration() : req->tag();
+        if (!storage::Evictor::Instance().Unpin(tag)) {
+            res->set_status("ERROR");
+            res->set_message("server: pin " + tag + " not found");
+            return;
+        }
+        fill_pins(res);
+        res->set_status("OK");
+    }
+
+    void fill_pins(PinResponse *res) {
+        for (auto &[tag, iteration] : storage::Evictor::Instance().Pins()) {
+            auto pin = res->add_pins();
+            pin->set_tag(tag);
+            pin->set_iteration(std::to_string(iteration));
+        }
+    }
+
+    void fill_budgets(BandwidthResponse *res) {
+        for (auto stage : {operators::TrafficStage::NODE, operators::TrafficStage::PERSIST,
+                           operators::TrafficStage::BACKUP}) {
+            auto budget = res->add_budgets();
+            budget->set_stage(operators::TrafficStageString(stage));
+            budget->set_bytes_per_second(operators::BandwidthLimiter::Instance().GetRate(stage));
+        }
+    }
+
     void make_resp(HttpResponse *res, std::string status, std::string message, const int32_t &state) {
         if (status == "ERROR") {
             LOG_ERROR(message);
@@ -329,51 +457,89 @@ public:
         return true;
     }
 
-    // Delete the oldest iteration of this node
-    bool deleteOldestIteration(std::string oldest_itreration) {
-        api::BatchLoadFilter filter(WorldState::Instance().NodeRank(), oldest_itreration);
+    // Evict an iteration of this node from memory, called by evictor
+    bool deleteIteration(size_t iteration) {
+        api::BatchLoadFilter filter(WorldState::Instance().NodeRank(), std::to_string(iteration));
         std::vector<api::Metadata> vec;
         auto meta_client = storage::MetadataClientFactory::GetClient();
         auto rc = meta_client->BatchLoad(filter, vec);
         if (!api::IsSuccess(rc)) {
-            LOG_ERROR("get oldestItreration metadata failed");
+            LOG_ERROR("get metadata of iteration {} failed", iteration);
             return false;
         }
         if (vec.size() == 0) {
-            LOG_ERROR("get 0 oldestItreration Metadata");
+            LOG_ERROR("get 0 metadata of iteration {}", iteration);
             return false;
         }
+        auto &persist_queue = operators::PersistQueue::Instance();
+        bool persistent = util::Util::GetEnv(config::IS_PERSISTENT, "on") == "on";
         for (auto &meta : vec) {
             // wait for the previous state to complete
             int wait_time = config::BOOTSTRAP_MIN_RETRY_INTERVAL_SECONDS;
-            while ((meta.state == api::CheckpointState::CACHED && WorldState::Instance().WorldSize() > 1)
-                   || (meta.state == api::CheckpointState::BACKED_UP
-                       && util::Util::GetEnv(config::IS_PERSISTENT, "on") == "on")) {
-                LOG_INFO("wait for the previous state of {} to complete, wait {}s...", meta.file_name, wait_time);
+            while (meta.state == api::CheckpointState::CACHED && WorldState::Instance().WorldSize() > 1) {
+                LOG_INFO("wait for backup of {} to complete, wait {}s...", meta.file_name, wait_time);
                 std::this_thread::sleep_for(std::chrono::seconds(wait_time));
-                wait_time *= 2;
+                wait_time = std::min(wait_time * 2, config::BOOTSTRAP_MAX_RETRY_INTERVAL_SECONDS);
                 auto rc = meta_client->Load(meta);
                 if (!api::IsSuccess(rc)) {
                     LOG_ERROR("get Metadata failed");
                     return false;
                 }
             }
-            // mark as OBSOLESCENT state
-            auto rc = meta_client->UpdateState(meta.file_name, api::CheckpointState::OBSOLESCENT);
+        }
+        for (auto &meta : vec) {
+            // with policy "all", wait for persistence while it's queued or in flight, a failed one never completes
+            int wait_time = config::BOOTSTRAP_MIN_RETRY_INTERVAL_SECONDS;
+            for (int round = 0; persistent && !persist_queue.SkipSuperseded(); round++) {
+                // right after backup the file may not be queued yet, look again after a round
+                if ((meta.state != api::CheckpointState::CACHED && meta.state != api::CheckpointState::BACKED_UP)
+                    || (round > 0 && !persist_queue.Contains(meta.file_name))) {
+                    break;
+                }
+                persist_queue.Expedite(iteration);
+                LOG_INFO("wait for persistence of {} to complete, wait {}s...", meta.file_name, wait_time);
+                std::this_thread::sleep_for(std::chrono::seconds(wait_time));
+                wait_time = std::min(wait_time * 2, config::BOOTSTRAP_MAX_RETRY_INTERVAL_SECONDS);
+                auto rc = meta_client->Load(meta);
+                if (!api::IsSuccess(rc)) {
+                    LOG_ERROR("get Metadata failed");
+                    return false;
+                }
+            }
+        }
+        // with cold tier, skip or abort what is left of the iteration and spill it instead of deletion
+        std::vector<api::Metadata> obsolete;
+        if (storage::ColdTier::Instance().Enabled()) {
+            persist_queue.Evict(iteration);
+        }
+        std::vector<std::string> obsolete_names;
+        for (auto &meta : vec) {
+            if (storage::Storage::Instance().Spill(meta)) {
+                continue;
+            }
+            obsolete.push_back(meta);
+            obsolete_names.push_back(meta.file_name);
+        }
+        // mark as OBSOLESCENT state, so that it's no longer queued for persistence
+        if (!obsolete_names.empty()) {
+            auto rc = meta_client->BatchUpdateState(obsolete_names, api::CheckpointState::OBSOLESCENT);
             if (!api::IsSuccess(rc)) {
                 LOG_ERROR("update metadata state failed");
                 return false;
             }
+        }
+        // skip or abort what is left of the iteration, memory is freed afterwards
+        persist_queue.Evict(iteration);
+        for (auto &meta : obsolete) {
             controller_->AddRateLimited(meta.file_name);
             // Waiting for deletion to complete
-            api::DataEntry entry;
-            while (storage::Storage::Instance().Load(std::ref(meta), std::ref(entry))) {
+            while (storage::Storage::Instance().Contains(meta)) {
                 LOG_INFO("Waiting for deletion to complete {}, wait 0.1s...", meta.file_name);
-                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
             }
         }
-        IterationManager::Instance().deleteOldestIteration();
-        LOG_DEBUG("deleted oldestItreration:{} ckpt nums:{}", oldest_itreration, vec.size());
+        LOG_DEBUG("deleted iteration:{} ckpt nums:{} spilled:{}", iteration, vec.size(),
+                  vec.size() - obsolete.size());
         return true;
     }
 };
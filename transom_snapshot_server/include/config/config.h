@@ -117,6 +117,81 @@ constexpr auto ENV_KEY_META_CLIENT = "CKPT_ENGINE_META_CLIENT";
  */
 constexpr auto META_CLIENT_MYSQL = "mysql";
 
+/**
+ * @brief metadata client of embedded store on local disk, for single node jobs without mysql
+ */
+constexpr auto META_CLIENT_LOCAL = "local";
+
+/**
+ * @brief environment variable key to configure directory of embedded metadata store
+ */
+constexpr auto ENV_KEY_META_LOCAL_DIR = "CKPT_ENGINE_META_LOCAL_DIR";
+
+/**
+ * @brief default directory of embedded metadata store, it should be on disk to survive host failure
+ */
+constexpr auto DEFAULT_META_LOCAL_DIR = "/var/lib/ckpt_engine";
+
+/**
+ * @brief embedded metadata store compacts its log once it has this many records more than live rows
+ */
+constexpr size_t META_LOCAL_COMPACT_RECORDS = 4096;
+
+/**
+ * @brief metadata client of standalone metadata service, see metadata_server
+ */
+constexpr auto META_CLIENT_TRANSOM = "transom";
+
+/**
+ * @brief environment variable key to configure address of metadata service, like "127.0.0.1:15346"
+ */
+constexpr auto ENV_KEY_META_SERVICE_ADDR = "CKPT_ENGINE_META_SERVICE_ADDR";
+
+/**
+ * @brief default address of metadata service
+ */
+constexpr auto DEFAULT_META_SERVICE_ADDR = "127.0.0.1:15346";
+
+/**
+ * @brief environment variable key to configure port metadata service listens on
+ */
+constexpr auto ENV_KEY_META_SERVICE_PORT = "CKPT_ENGINE_META_SERVICE_PORT";
+
+/**
+ * @brief default port metadata service listens on
+ */
+constexpr auto DEFAULT_META_SERVICE_PORT = "15346";
+
+/**
+ * @brief environment variable key to configure directory of metadata service, a store per shard of a job
+ */
+constexpr auto ENV_KEY_META_SERVICE_DIR = "CKPT_ENGINE_META_SERVICE_DIR";
+
+/**
+ * @brief default directory of metadata service
+ */
+constexpr auto DEFAULT_META_SERVICE_DIR = "/var/lib/ckpt_engine/service";
+
+/**
+ * @brief environment variable key to configure shards of a job in metadata service, rows are sharded by node rank
+ */
+constexpr auto ENV_KEY_META_SERVICE_SHARDS = "CKPT_ENGINE_META_SERVICE_SHARDS";
+
+/**
+ * @brief default shards of a job in metadata service
+ */
+constexpr auto DEFAULT_META_SERVICE_SHARDS = "16";
+
+/**
+ * @brief timeout of a metadata service request
+ */
+constexpr int META_SERVICE_TIMEOUT_MS = 10 * 1000;
+
+/**
+ * @brief max ops of a metadata service write request, concurrent writes of a process are batched up to it
+ */
+constexpr size_t META_SERVICE_BATCH_OPS = 1024;
+
 /**
  * @brief mysql table name
  */
@@ -147,6 +222,63 @@ constexpr auto ENV_KEY_MYSQL_PASSWORD = "CKPT_ENGINE_MYSQL_PASSWORD";
  */
 constexpr auto ENV_KEY_MYSQL_FLUSH_TABLE = "CKPT_ENGINE_MYSQL_FLUSH";
 
+/**
+ * @brief environment variable key of max mysql connections
+ */
+constexpr auto ENV_KEY_MYSQL_POOL_SIZE = "CKPT_ENGINE_MYSQL_POOL_SIZE";
+
+/**
+ * @brief default max mysql connections
+ */
+constexpr auto DEFAULT_MYSQL_POOL_SIZE = "16";
+
+/**
+ * @brief a pooled connection idle for longer is pinged before use
+ */
+constexpr auto MYSQL_PING_IDLE_SECONDS = 30;
+
+/**
+ * @brief timeout of connecting, reading and writing mysql
+ */
+constexpr auto MYSQL_TIMEOUT_SECONDS = 10;
+
+/**
+ * @brief rows of a multi-row statement, shorter batches are padded with their last row
+ */
+constexpr auto MYSQL_BATCH_ROWS = 64;
+
+/**
+ * @brief environment variable key to enable write-behind metadata cache. If enabled, metadata of current node is
+ * served from memory, and writes are logged locally and flushed to database in batches
+ */
+constexpr auto ENV_KEY_META_CACHE = "CKPT_ENGINE_META_CACHE";
+
+/**
+ * @brief environment variable key to configure interval of flushing metadata cache to database, unit is ms
+ */
+constexpr auto ENV_KEY_META_FLUSH_MS = "CKPT_ENGINE_META_FLUSH_MS";
+
+/**
+ * @brief default interval of flushing metadata cache to database, unit is ms
+ */
+constexpr auto DEFAULT_META_FLUSH_MS = "100";
+
+/**
+ * @brief environment variable key to configure directory of metadata log, writes not flushed yet are replayed from
+ * it at startup
+ */
+constexpr auto ENV_KEY_META_LOG_DIR = "CKPT_ENGINE_META_LOG_DIR";
+
+/**
+ * @brief default directory of metadata log, it survives restart of server but not of host, like checkpoints in memory
+ */
+constexpr auto DEFAULT_META_LOG_DIR = "/dev/shm/ckpt_engine";
+
+/**
+ * @brief max files of a batched state update, concurrent state updates of a server are merged up to it
+ */
+constexpr size_t META_BATCH_UPDATE_ROWS = 1024;
+
 /**
  * @brief communicator type, http
  */
@@ -217,26 +349,558 @@ constexpr auto ENV_MAX_ITERATION_IN_CACHE = "CKPT_ENGINE_MAX_ITERATION_IN_CACHE"
  */
 constexpr auto DEFAULT_MAX_ITERATION_IN_CACHE = "999";
 
+/**
+ * @brief environment variable key of max memory of cached iterations in GB, oldest ones are evicted beyond it
+ */
+constexpr auto ENV_KEY_EVICTION_BUDGET_GB = "CKPT_ENGINE_EVICTION_BUDGET_GB";
+
+/**
+ * @brief environment variable key of how to choose an iteration to evict
+ */
+constexpr auto ENV_KEY_EVICTION_POLICY = "CKPT_ENGINE_EVICTION_POLICY";
+
+/**
+ * @brief evict the oldest iteration first
+ */
+constexpr auto EVICTION_POLICY_FIFO = "fifo";
+
+/**
+ * @brief evict by score of iteration age, size and persistence state
+ */
+constexpr auto EVICTION_POLICY_COST = "cost";
+
+/**
+ * @brief interval to check cached iterations if nothing wakes evictor up
+ */
+constexpr auto EVICTION_PERIOD_SECONDS = 10;
+
+/**
+ * @brief score of cost-aware eviction per iteration older than the latest one
+ */
+constexpr double EVICTION_WEIGHT_AGE = 1.0;
+
+/**
+ * @brief score of cost-aware eviction per GB of memory held
+ */
+constexpr double EVICTION_WEIGHT_GB = 0.5;
+
+/**
+ * @brief score of cost-aware eviction if all files are persistent, they can be restored from file system
+ */
+constexpr double EVICTION_WEIGHT_PERSISTENT = 2.0;
+
 /**
  * @brief cgroup directory to read memory state
  */
 constexpr auto MEM_CGROUP_DIR = "/sys/fs/cgroup/memory/";
 
 /**
- * @brief interval to re-collect cgroup stat
+ * @brief mount point of cgroup v2 unified hierarchy
+ */
+constexpr auto MEM_CGROUP_V2_DIR = "/sys/fs/cgroup/";
+
+/**
+ * @brief interval to re-collect cgroup stat if no memory event arrives
+ */
+constexpr auto MEM_WATCH_PERIOD_SECONDS = 5;
+
+/**
+ * @brief psi trigger of memory pressure, 150ms stall in 2s window. Unprivileged triggers need window in whole seconds
+ */
+constexpr auto MEM_PSI_TRIGGER = "some 150000 2000000";
+
+/**
+ * @brief level of cgroup v1 memory.pressure_level to be notified
  */
-constexpr auto MEM_WATCH_PERIOD_SECONDS = 1000000;
+constexpr auto MEM_PRESSURE_LEVEL = "low";
 
 /**
  * @brief environment variable key to configure cache memory consumption limit
  */
 constexpr auto ENV_KEY_MEMORY_LIMIT_GB = "CKPT_ENGINE_MEM_LIMIT_GB";
 
+/**
+ * @brief environment variable key to configure memory budget of checkpoints saved by local ranks, in GB, unset
+ * means bounded by memory limit only
+ */
+constexpr auto ENV_KEY_MEMORY_BUDGET_OWN_GB = "CKPT_ENGINE_MEM_BUDGET_OWN_GB";
+
+/**
+ * @brief environment variable key to configure memory budget of backups for previous node, in GB
+ */
+constexpr auto ENV_KEY_MEMORY_BUDGET_BACKUP_GB = "CKPT_ENGINE_MEM_BUDGET_BACKUP_GB";
+
+/**
+ * @brief environment variable key to configure memory budget of checkpoints restored from file system or peer, in GB
+ */
+constexpr auto ENV_KEY_MEMORY_BUDGET_RESTORE_GB = "CKPT_ENGINE_MEM_BUDGET_RESTORE_GB";
+
+/**
+ * @brief environment variable key to configure how long a save or backup waits for memory before failing, in
+ * milliseconds
+ */
+constexpr auto ENV_KEY_MEMORY_WAIT_MS = "CKPT_ENGINE_MEM_WAIT_MS";
+
+/**
+ * @brief default memory wait time, fail at once
+ */
+constexpr auto DEFAULT_MEMORY_WAIT_MS = "0";
+
 /**
  * @brief **Just for debugging**, environment variable key to configure whether to skip persistence
  */
 constexpr auto IS_PERSISTENT = "CKPT_ENGINE_ENABLE_PERSISTENT";
 
+/**
+ * @brief environment variable key to configure the engine used to write checkpoint files to disk
+ */
+constexpr auto ENV_KEY_PERSIST_ENGINE = "CKPT_ENGINE_PERSIST_ENGINE";
+
+/**
+ * @brief persistence engine, buffered write through stdio
+ */
+constexpr auto PERSIST_ENGINE_STDIO = "stdio";
+
+/**
+ * @brief persistence engine, direct write through io_uring, bypassing page cache
+ */
+constexpr auto PERSIST_ENGINE_URING = "uring";
+
+/**
+ * @brief environment variable key to configure max in-flight writes of io_uring engine
+ */
+constexpr auto ENV_KEY_URING_QUEUE_DEPTH = "CKPT_ENGINE_URING_QUEUE_DEPTH";
+
+/**
+ * @brief default max in-flight writes of io_uring engine
+ */
+constexpr auto DEFAULT_URING_QUEUE_DEPTH = "8";
+
+/**
+ * @brief environment variable key to configure size of a single io_uring write, unit is MB
+ */
+constexpr auto ENV_KEY_URING_BLOCK_MB = "CKPT_ENGINE_URING_BLOCK_MB";
+
+/**
+ * @brief default size of a single io_uring write, unit is MB
+ */
+constexpr auto DEFAULT_URING_BLOCK_MB = "8";
+
+/**
+ * @brief O_DIRECT requires buffer, offset and length aligned to logical block size, 4k covers common devices
+ */
+constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+/**
+ * @brief persistence engine, split a file into stripes and pwrite them concurrently
+ */
+constexpr auto PERSIST_ENGINE_STRIPED = "striped";
+
+/**
+ * @brief persistence engine, transfer from memfd to file inside kernel by copy_file_range or sendfile
+ */
+constexpr auto PERSIST_ENGINE_ZEROCOPY = "zerocopy";
+
+/**
+ * @brief environment variable key to configure default stripe size of striped engine, unit is MB
+ */
+constexpr auto ENV_KEY_STRIPE_MB = "CKPT_ENGINE_STRIPE_MB";
+
+/**
+ * @brief default stripe size of striped engine, unit is MB
+ */
+constexpr auto DEFAULT_STRIPE_MB = "64";
+
+/**
+ * @brief environment variable key to configure default concurrent stripes of a file in striped engine
+ */
+constexpr auto ENV_KEY_STRIPE_CONCURRENCY = "CKPT_ENGINE_STRIPE_CONCURRENCY";
+
+/**
+ * @brief default concurrent stripes of a file in striped engine
+ */
+constexpr auto DEFAULT_STRIPE_CONCURRENCY = "8";
+
+/**
+ * @brief environment variable key to override stripe setting per mount point,
+ * format is "mount:stripe_mb:concurrency" separated by comma, e.g. "/mnt/lustre:128:16,/mnt/nvme:32:4".
+ * The longest mount point prefixing the file path wins.
+ */
+constexpr auto ENV_KEY_STRIPE_MOUNTS = "CKPT_ENGINE_STRIPE_MOUNTS";
+
+/**
+ * @brief suffix of the temporary file written before renamed to the target, so readers never see a half-written file
+ */
+constexpr auto PERSIST_TMP_SUFFIX = ".tmp";
+
+/**
+ * @brief environment variable key to configure directory of content-addressed chunk store.
+ * If set, checkpoint files are persisted incrementally: only chunks absent from the store are written,
+ * and a small manifest referencing chunks is written beside the checkpoint path
+ */
+constexpr auto ENV_KEY_CHUNK_STORE_DIR = "CKPT_ENGINE_CHUNK_STORE_DIR";
+
+/**
+ * @brief suffix of the manifest written beside checkpoint path, the path itself is left for plain checkpoints
+ */
+constexpr auto PERSIST_MANIFEST_SUFFIX = ".manifest";
+
+/**
+ * @brief interval of collecting chunks no longer referenced by any manifest, e.g. of checkpoints deleted by users
+ */
+constexpr int CHUNK_GC_INTERVAL_SECONDS = 600;
+
+/**
+ * @brief environment variable key to configure chunk size of incremental persistence, unit is MB
+ */
+constexpr auto ENV_KEY_CHUNK_MB = "CKPT_ENGINE_CHUNK_MB";
+
+/**
+ * @brief default chunk size of incremental persistence, unit is MB
+ */
+constexpr auto DEFAULT_CHUNK_MB = "4";
+
+/**
+ * @brief threads to hash, compress and read chunks or frames concurrently
+ */
+constexpr size_t PERSIST_CONCURRENT_THREADS = 8;
+
+/**
+ * @brief environment variable key to configure compression of persisted files
+ */
+constexpr auto ENV_KEY_COMPRESSION = "CKPT_ENGINE_COMPRESSION";
+
+/**
+ * @brief no compression
+ */
+constexpr auto COMPRESSION_NONE = "none";
+
+/**
+ * @brief compress into zstd seekable format
+ */
+constexpr auto COMPRESSION_ZSTD = "zstd";
+
+/**
+ * @brief environment variable key to configure zstd compression level
+ */
+constexpr auto ENV_KEY_COMPRESSION_LEVEL = "CKPT_ENGINE_COMPRESSION_LEVEL";
+
+/**
+ * @brief default zstd compression level, favor speed since storage bandwidth is the bottleneck
+ */
+constexpr auto DEFAULT_COMPRESSION_LEVEL = "1";
+
+/**
+ * @brief environment variable key to configure bytes compressed into an independent frame, unit is MB
+ */
+constexpr auto ENV_KEY_COMPRESSION_FRAME_MB = "CKPT_ENGINE_COMPRESSION_FRAME_MB";
+
+/**
+ * @brief default bytes compressed into an independent frame, unit is MB
+ */
+constexpr auto DEFAULT_COMPRESSION_FRAME_MB = "4";
+
+/**
+ * @brief suffix of the compressed file written beside checkpoint path, e.g. decompressed by `zstd -d rank0.pt.zst`
+ */
+constexpr auto PERSIST_COMPRESSED_SUFFIX = ".zst";
+
+/**
+ * @brief magic at the beginning of a manifest, distinguishes it from a plain checkpoint file
+ */
+constexpr char CHUNK_MANIFEST_MAGIC[8] = {'T', 'C', 'E', 'C', 'H', 'U', 'N', 'K'};
+
+/**
+ * @brief environment variable key to configure bandwidth budget of the node, unit is MB/s
+ */
+constexpr auto ENV_KEY_NODE_BANDWIDTH_MB = "CKPT_ENGINE_NODE_BANDWIDTH_MB";
+
+/**
+ * @brief environment variable key to configure bandwidth budget of persistence, unit is MB/s
+ */
+constexpr auto ENV_KEY_PERSIST_BANDWIDTH_MB = "CKPT_ENGINE_PERSIST_BANDWIDTH_MB";
+
+/**
+ * @brief environment variable key to configure bandwidth budget of inter-node backup, unit is MB/s
+ */
+constexpr auto ENV_KEY_BACKUP_BANDWIDTH_MB = "CKPT_ENGINE_BACKUP_BANDWIDTH_MB";
+
+/**
+ * @brief default bandwidth budget, 0 means unlimited
+ */
+constexpr auto DEFAULT_BANDWIDTH_MB = "0";
+
+/**
+ * @brief throttled transfer is split into chunks of this size, so that budget changes take effect in time
+ */
+constexpr size_t BANDWIDTH_CHUNK_SIZE = 64 * 1024 * 1024;
+
+/**
+ * @brief max rdma writes in flight when throttled, keep far below RDMA_CQ_SIZE
+ */
+constexpr int RDMA_MAX_INFLIGHT_WRITES = 16;
+
+/**
+ * @brief environment variable key to configure S3-compatible object store endpoint as host:port, checkpoints are
+ * persisted to object store instead of disk if set
+ */
+constexpr auto ENV_KEY_SSO_ENDPOINT = "CKPT_ENGINE_SSO_ENDPOINT";
+
+/**
+ * @brief environment variable key to configure object store region
+ */
+constexpr auto ENV_KEY_SSO_REGION = "CKPT_ENGINE_SSO_REGION";
+
+/**
+ * @brief default object store region
+ */
+constexpr auto DEFAULT_SSO_REGION = "us-east-1";
+
+/**
+ * @brief environment variable key to configure object store bucket
+ */
+constexpr auto ENV_KEY_SSO_BUCKET = "CKPT_ENGINE_SSO_BUCKET";
+
+/**
+ * @brief environment variable key to configure object store access key
+ */
+constexpr auto ENV_KEY_SSO_ACCESS_KEY = "CKPT_ENGINE_SSO_ACCESS_KEY";
+
+/**
+ * @brief environment variable key to configure object store secret key
+ */
+constexpr auto ENV_KEY_SSO_SECRET_KEY = "CKPT_ENGINE_SSO_SECRET_KEY";
+
+/**
+ * @brief environment variable key to configure prefix of object keys, file name is appended to it
+ */
+constexpr auto ENV_KEY_SSO_PREFIX = "CKPT_ENGINE_SSO_PREFIX";
+
+/**
+ * @brief environment variable key to configure size of a part in multipart upload and ranged download, unit is MB
+ */
+constexpr auto ENV_KEY_SSO_PART_MB = "CKPT_ENGINE_SSO_PART_MB";
+
+/**
+ * @brief default part size, S3 requires at least 5MB and at most 10000 parts
+ */
+constexpr auto DEFAULT_SSO_PART_MB = "64";
+
+/**
+ * @brief environment variable key to configure concurrent parts of an object
+ */
+constexpr auto ENV_KEY_SSO_CONCURRENCY = "CKPT_ENGINE_SSO_CONCURRENCY";
+
+/**
+ * @brief default concurrent parts
+ */
+constexpr auto DEFAULT_SSO_CONCURRENCY = "8";
+
+/**
+ * @brief attempts of a single object store request
+ */
+constexpr int SSO_MAX_RETRY = 4;
+
+/**
+ * @brief timeout of a single object store request, enough for a part on a slow link
+ */
+constexpr int SSO_TIMEOUT_MS = 120 * 1000;
+
+/**
+ * @brief environment variable key to configure which files persistence may skip when it falls behind
+ */
+constexpr auto ENV_KEY_PERSIST_POLICY = "CKPT_ENGINE_PERSIST_POLICY";
+
+/**
+ * @brief persist every file, newest iteration first
+ */
+constexpr auto PERSIST_POLICY_ALL = "all";
+
+/**
+ * @brief skip or abort files of iterations older than a fully persisted one
+ */
+constexpr auto PERSIST_POLICY_LATEST = "latest";
+
+/**
+ * @brief environment variable key to configure files persisted concurrently
+ */
+constexpr auto ENV_KEY_PERSIST_THREADS = "CKPT_ENGINE_PERSIST_THREADS";
+
+/**
+ * @brief default files persisted concurrently, each engine is parallel inside a file already
+ */
+constexpr auto DEFAULT_PERSIST_THREADS = "2";
+
+/**
+ * @brief environment variable key to configure directories on different devices, separated by ','. If set, files
+ * are split into stripes of CKPT_ENGINE_STRIPE_MB spread across them, and a placement index is written beside file name
+ */
+constexpr auto ENV_KEY_PERSIST_DIRS = "CKPT_ENGINE_PERSIST_DIRS";
+
+/**
+ * @brief environment variable key to configure concurrent stripes read or written per directory
+ */
+constexpr auto ENV_KEY_PERSIST_DIR_CONCURRENCY = "CKPT_ENGINE_PERSIST_DIR_CONCURRENCY";
+
+/**
+ * @brief default concurrent stripes per directory
+ */
+constexpr auto DEFAULT_PERSIST_DIR_CONCURRENCY = "4";
+
+/**
+ * @brief magic at the beginning of a placement index
+ */
+constexpr char PLACEMENT_INDEX_MAGIC[8] = {'T', 'C', 'E', 'P', 'L', 'A', 'C', 'E'};
+
+/**
+ * @brief suffix of the placement index written beside checkpoint path
+ */
+constexpr auto PERSIST_PLACEMENT_SUFFIX = ".placement";
+
+/**
+ * @brief environment variable key to configure directory of cold tier on local NVMe. If set, cold checkpoints are
+ * spilled there and their memory is released, instead of being deleted or failing allocations with OOM
+ */
+constexpr auto ENV_KEY_COLD_TIER_DIR = "CKPT_ENGINE_COLD_TIER_DIR";
+
+/**
+ * @brief environment variable key to configure capacity of cold tier, 90% of available space if unset
+ */
+constexpr auto ENV_KEY_COLD_TIER_GB = "CKPT_ENGINE_COLD_TIER_GB";
+
+/**
+ * @brief file suffix of spilled checkpoints, files with it in cold tier directory are removed at startup
+ */
+constexpr auto COLD_TIER_SUFFIX = ".cold";
+
+/**
+ * @brief checkpoint accessed within this interval is not spilled to make room for others
+ */
+constexpr auto COLD_TIER_MIN_IDLE_SECONDS = 30;
+
+/**
+ * @brief environment variable key to configure files restored from file system concurrently during bootstrap
+ */
+constexpr auto ENV_KEY_RESTORE_THREADS = "CKPT_ENGINE_RESTORE_THREADS";
+
+/**
+ * @brief default files restored concurrently
+ */
+constexpr auto DEFAULT_RESTORE_THREADS = "4";
+
+/**
+ * @brief environment variable key to configure whether bootstrap waits for checkpoints restored from file system
+ */
+constexpr auto ENV_KEY_RESTORE_MODE = "CKPT_ENGINE_RESTORE_MODE";
+
+/**
+ * @brief bootstrap completes after all checkpoints are restored
+ */
+constexpr auto RESTORE_MODE_EAGER = "eager";
+
+/**
+ * @brief bootstrap completes once checkpoints are registered, they are restored in background, or on demand if
+ * requested before their turn
+ */
+constexpr auto RESTORE_MODE_LAZY = "lazy";
+
+/**
+ * @brief environment variable key to configure size of each concurrent pread when loading a plain file, in MB
+ */
+constexpr auto ENV_KEY_RESTORE_CHUNK_MB = "CKPT_ENGINE_RESTORE_CHUNK_MB";
+
+/**
+ * @brief default size of each concurrent pread
+ */
+constexpr auto DEFAULT_RESTORE_CHUNK_MB = "16";
+
+/**
+ * @brief environment variable key to configure max memory held by pool of pre-faulted memfd segments, in GB, 0
+ * disables pool
+ */
+constexpr auto ENV_KEY_MEMFD_POOL_GB = "CKPT_ENGINE_MEMFD_POOL_GB";
+
+/**
+ * @brief default memfd pool size, disabled
+ */
+constexpr auto DEFAULT_MEMFD_POOL_GB = "0";
+
+/**
+ * @brief environment variable key to configure huge pages backing checkpoint memory, one of HUGE_PAGE_*
+ */
+constexpr auto ENV_KEY_HUGE_PAGE = "CKPT_ENGINE_HUGE_PAGE";
+
+/**
+ * @brief 4K pages only
+ */
+constexpr auto HUGE_PAGE_OFF = "off";
+
+/**
+ * @brief advise transparent huge pages on shmem, file size is kept as is
+ */
+constexpr auto HUGE_PAGE_THP = "thp";
+
+/**
+ * @brief hugetlbfs memfd if enough huge pages are reserved, thp otherwise. File size is rounded up to huge page size
+ */
+constexpr auto HUGE_PAGE_HUGETLB = "hugetlb";
+
+/**
+ * @brief default huge page mode
+ */
+constexpr auto DEFAULT_HUGE_PAGE = HUGE_PAGE_THP;
+
+/**
+ * @brief environment variable key to configure threads prefaulting a newly allocated checkpoint in parallel while
+ * client prepares data, 0 disables prefault
+ */
+constexpr auto ENV_KEY_PREFAULT_THREADS = "CKPT_ENGINE_PREFAULT_THREADS";
+
+/**
+ * @brief default prefault threads, disabled
+ */
+constexpr auto DEFAULT_PREFAULT_THREADS = "0";
+
+/**
+ * @brief environment variable key to configure cgroup version for memory accounting, one of CGROUP_VERSION_*
+ */
+constexpr auto ENV_KEY_CGROUP_VERSION = "CKPT_ENGINE_CGROUP_VERSION";
+
+/**
+ * @brief detect cgroup version by files present, v1 memory controller wins on hybrid hierarchy
+ */
+constexpr auto CGROUP_VERSION_AUTO = "auto";
+
+/**
+ * @brief cgroup v1, memory.usage_in_bytes and memory.limit_in_bytes under MEM_CGROUP_DIR
+ */
+constexpr auto CGROUP_VERSION_V1 = "v1";
+
+/**
+ * @brief cgroup v2, memory.current and memory.max under MEM_CGROUP_V2_DIR
+ */
+constexpr auto CGROUP_VERSION_V2 = "v2";
+
+/**
+ * @brief environment variable key of NUMA memory policy of checkpoints
+ */
+constexpr auto ENV_KEY_NUMA_POLICY = "CKPT_ENGINE_NUMA_POLICY";
+
+/**
+ * @brief do not care about NUMA
+ */
+constexpr auto NUMA_POLICY_OFF = "off";
+
+/**
+ * @brief allocate on node of the requesting rank, fall back to other nodes if it's full
+ */
+constexpr auto NUMA_POLICY_PREFERRED = "preferred";
+
+/**
+ * @brief allocate on node of the requesting rank only
+ */
+constexpr auto NUMA_POLICY_BIND = "bind";
+
 /**
  * @brief environment variable key to configure transom job key
  */
@@ -10,16 +10,18 @@
  */
 #pragma once
 
+#include <climits>
 #include <memory>
+#include <mutex>
+#include <set>
 
-#include "util/dequeue.h"
 #include "util/util.h"
 
 namespace config {
 using util::Util;
 
 /**
- * @brief record totalIteration, lastIteration, minIteration
+ * @brief record iterations cached in memory of this node, evicted ones are removed in any order
  */
 class IterationManager {
 public:
@@ -35,47 +37,67 @@ public:
     }
 
     /**
-     * @brief return total iterations recorded in queue
+     * @brief return total iterations recorded
      */
     size_t totalIteration() {
-        return q_.size();
+        std::lock_guard<std::mutex> lock(mut_);
+        return iterations_.size();
     }
 
     /**
-     * @brief return the latest iteration recorded in queue
+     * @brief return the latest iteration recorded
      */
     size_t lastIteration() {
-        if (!q_.empty())
-            return q_.back();
+        std::lock_guard<std::mutex> lock(mut_);
+        if (!iterations_.empty())
+            return *iterations_.rbegin();
         return -1;
     }
 
     /**
-     * @brief delete the first element in queue
+     * @brief delete the oldest iteration
      */
     void deleteOldestIteration() {
-        if (!q_.empty())
-            q_.try_pop();
+        std::lock_guard<std::mutex> lock(mut_);
+        if (!iterations_.empty())
+            iterations_.erase(iterations_.begin());
     }
 
     /**
-     * @brief return the oldest(first) element in queue
-     * @return
+     * @brief delete given iteration, it may not be the oldest one
+     */
+    void deleteIteration(size_t iter) {
+        std::lock_guard<std::mutex> lock(mut_);
+        iterations_.erase(iter);
+    }
+
+    /**
+     * @brief return the oldest iteration
      */
     size_t oldestIteration() {
-        if (!q_.empty())
-            return q_.front();
+        std::lock_guard<std::mutex> lock(mut_);
+        if (!iterations_.empty())
+            return *iterations_.begin();
         return ULONG_MAX;
     }
 
     /**
-     * @brief add an iteration indicator to queue
+     * @brief add an iteration indicator, nothing happens if it exists
      * @param iter iteration indicator
      */
     void pushIteration(size_t iter) {
-        LOG_DEBUG("pushIteration {} totalIteration {} minIteration {} lastIteration {}",
-                  iter, totalIteration(), oldestIteration(), lastIteration());
-        q_.push(iter);
+        std::lock_guard<std::mutex> lock(mut_);
+        if (iterations_.insert(iter).second) {
+            LOG_DEBUG("pushIteration {} totalIteration {}", iter, iterations_.size());
+        }
+    }
+
+    /**
+     * @brief return all iterations, oldest first
+     */
+    std::set<size_t> iterations() {
+        std::lock_guard<std::mutex> lock(mut_);
+        return iterations_;
     }
 
     /**
@@ -86,15 +108,17 @@ public:
     }
 
     /**
-     * @brief check if given iteration exists in queue
+     * @brief check if given iteration exists
      */
     bool isExist(const size_t &iter) {
-        return q_.isExist(iter);
+        std::lock_guard<std::mutex> lock(mut_);
+        return iterations_.count(iter) > 0;
     }
 
 private:
-    util::SafeDeque<size_t> q_;
+    std::mutex mut_;
+    std::set<size_t> iterations_;
     const size_t max_iteration_ = std::stoul(util::Util::GetEnv(config::ENV_MAX_ITERATION_IN_CACHE,
                                                                 config::DEFAULT_MAX_ITERATION_IN_CACHE));
 };
-} // namespace config
\ No newline at end of file
+} // namespace config
@@ -37,6 +37,7 @@ public:
      * @brief backup local checkpoint to next node. Note data is prepared outside of this function.
      * if overwrite, data will be transferred to remote, otherwise only update metadata.
      * @details Detailed procedure:
+     *  0. flush cached metadata writes, next node reads state of the checkpoint from database
      *  1. get next node IP, if world size is 1, skip
      *  2. connect to peer node
      *  3. send routine 1, which is INTER_NODE_BACKUP
@@ -78,6 +79,8 @@ public:
 
     /**
      * @brief load target checkpoint from FileSystem in case cache is lost
+     * @details checkpoints are restored by Restorer newest iteration first. In lazy restore mode it returns once
+     * they are queued
      *
      * @return true success
      */
@@ -20,6 +20,7 @@
 #include "coordinator/client.h"
 #include "coordinator/server.h"
 #include "operator/operator.h"
+#include "operator/persist_queue.h"
 #include "storage/persistence.h"
 
 namespace coordinator {
@@ -64,6 +65,19 @@ public:
      */
     static bool Reconcile(std::string key);
 
+    /**
+     * @brief the persistence handler, to be registered to persist queue
+     *
+     * @param task file to persist
+     * @return true success or skipped, false failed
+     */
+    static bool Persist(const operators::PersistTask &task);
+
+    /**
+     * @brief return true if every file of iteration on this node is persisted
+     */
+    static bool IterationPersisted(int64_t iteration);
+
     /**
      * @brief start the coordinator. This function must be called
      */
@@ -0,0 +1,93 @@
+/**
+ * @file restorer.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief restore checkpoints from file system in background
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "api/api.h"
+
+namespace coordinator {
+/**
+ * @brief restore checkpoints from file system by a bounded number of threads, newest iteration first
+ * @details A checkpoint requested before its turn jumps the queue and the requester waits for it alone, so in lazy
+ * mode bootstrap only registers checkpoints and training loads what it needs while the rest is prefetched.
+ */
+class Restorer {
+public:
+    Restorer() = default;
+    Restorer(const Restorer &) = delete;
+    Restorer(Restorer &&) = delete;
+    Restorer &operator=(const Restorer &) = delete;
+    Restorer &operator=(Restorer &&) = delete;
+
+    /**
+     * @brief singleton instance
+     * @return reference of singleton instance, cannot be copied or deleted
+     */
+    static Restorer &Instance() {
+        static std::unique_ptr<Restorer> instance_ptr_(new Restorer());
+        return *instance_ptr_;
+    }
+
+    /**
+     * @brief queue checkpoints, newest iteration first, and start restoring them
+     * @param threads checkpoints restored concurrently
+     */
+    void Start(std::vector<api::Metadata> files, size_t threads);
+
+    /**
+     * @brief restore file_name first if it's queued, and wait until it's restored
+     * @return bool false if restoring fails, true if it's restored or not managed by restorer
+     */
+    bool Fetch(const std::string &file_name);
+
+    /**
+     * @brief wait until all queued checkpoints are restored
+     * @return bool false if any fails
+     */
+    bool Wait();
+
+    /**
+     * @brief load a checkpoint from file system into storage, also used when its memory is gone after bootstrap
+     * @return bool true if it's loaded, or skipped since it's obsolescent or created again
+     */
+    static bool Restore(api::Metadata &metadata);
+
+private:
+    void run();
+
+    /**
+     * @brief return true if file_name is queued or being restored, lock must be held
+     */
+    bool pending(const std::string &file_name);
+
+    std::deque<api::Metadata> queue_;
+    std::set<std::string> inflight_;
+    std::set<std::string> failed_;
+
+    /* threads not exited yet */
+    size_t running_ = 0;
+    size_t total_ = 0;
+    size_t restored_ = 0;
+    size_t restored_bytes_ = 0;
+    std::chrono::high_resolution_clock::time_point start_time_;
+    std::mutex mut_;
+    std::condition_variable done_cv_;
+};
+} // namespace coordinator
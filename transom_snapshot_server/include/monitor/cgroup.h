@@ -0,0 +1,108 @@
+/**
+ * @file cgroup.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief memory accounting of cgroup v1 and v2
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace monitor {
+/**
+ * @brief memory accounting files of the cgroup this process belongs to
+ */
+class CgroupBackend {
+public:
+    /**
+     * @param dir cgroup directory of memory controller, ending with '/'
+     */
+    explicit CgroupBackend(const std::string &dir) :
+        dir_(dir) {
+    }
+    virtual ~CgroupBackend() = default;
+
+    const std::string &Dir() const {
+        return dir_;
+    }
+
+    /**
+     * @brief return "v1" or "v2"
+     */
+    virtual std::string Version() const = 0;
+
+    /**
+     * @brief read current usage
+     * @param usage memory charged to cgroup, page cache included
+     * @param max_usage peak usage, 0 if unknown
+     * @param reclaimable clean page cache which kernel drops before OOM, shmem excluded
+     * @return bool false if files cannot be read
+     */
+    virtual bool Usage(size_t &usage, size_t &max_usage, size_t &reclaimable) = 0;
+
+    /**
+     * @brief read memory limit, SIZE_MAX if unlimited
+     * @return bool false if file cannot be read
+     */
+    virtual bool Limit(size_t &limit) = 0;
+
+protected:
+    /**
+     * @brief read a single number of file under dir, "max" means SIZE_MAX
+     */
+    bool readValue(const std::string &file_name, size_t &value);
+
+    /**
+     * @brief read key value pairs of memory.stat
+     */
+    std::map<std::string, size_t> readStat();
+
+    /**
+     * @brief cache - shmem - dirty - writeback, clamped to 0
+     */
+    static size_t reclaimable(size_t cache, size_t shmem, size_t dirty, size_t writeback);
+
+    std::string dir_;
+};
+
+class CgroupV1 : public CgroupBackend {
+public:
+    explicit CgroupV1(const std::string &dir) :
+        CgroupBackend(dir) {
+    }
+
+    std::string Version() const override {
+        return "v1";
+    }
+    bool Usage(size_t &usage, size_t &max_usage, size_t &reclaimable) override;
+    bool Limit(size_t &limit) override;
+};
+
+class CgroupV2 : public CgroupBackend {
+public:
+    explicit CgroupV2(const std::string &dir) :
+        CgroupBackend(dir) {
+    }
+
+    std::string Version() const override {
+        return "v2";
+    }
+    bool Usage(size_t &usage, size_t &max_usage, size_t &reclaimable) override;
+    bool Limit(size_t &limit) override;
+};
+
+/**
+ * @brief create cgroup backend by config, auto-detected by default
+ */
+class CgroupBackendFactory {
+public:
+    static std::unique_ptr<CgroupBackend> Create();
+};
+} // namespace monitor
@@ -0,0 +1,104 @@
+/**
+ * @file memfd_pool.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief pool of pre-faulted memfd segments
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <bvar/bvar.h>
+
+#include "api/api.h"
+
+namespace monitor {
+/**
+ * @brief pool of memfd segments whose pages are allocated already, keyed by exact checkpoint size. Pooled bytes
+ * and capacity count mapped size, which is rounded up to whole huge pages on hugetlbfs
+ * @details Checkpoints of a model come in the same sizes every iteration, so the pool aims at holding as many
+ * segments of each size as were requested in the previous iteration. Segments come from background allocation and
+ * from deleted checkpoints. A reused segment keeps stale content, callers overwrite the whole file anyway.
+ */
+class MemfdPool {
+public:
+    /**
+     * @param capacity max bytes held by pool, 0 disables pool
+     */
+    explicit MemfdPool(size_t capacity);
+    ~MemfdPool();
+    MemfdPool(const MemfdPool &) = delete;
+    MemfdPool(MemfdPool &&) = delete;
+    MemfdPool &operator=(const MemfdPool &) = delete;
+    MemfdPool &operator=(MemfdPool &&) = delete;
+
+    bool Enabled() const {
+        return capacity_ > 0;
+    }
+
+    /**
+     * @brief take a segment of metadata.size, demand of the size is recorded no matter hit or miss
+     * @param entry memfd, address and pid are recorded into entry on hit
+     * @return bool true: hit
+     */
+    bool Acquire(const api::Metadata &metadata, api::DataEntry &entry);
+
+    /**
+     * @brief give back a segment of a deleted checkpoint, filed under metadata.size so Acquire of the same size
+     * takes it
+     * @return bool false if pool does not need it, caller frees it then
+     */
+    bool Release(const api::Metadata &metadata, const api::DataEntry &entry);
+
+    /**
+     * @brief put a newly allocated segment of checkpoint size into pool
+     */
+    void Add(size_t size, const api::DataEntry &entry);
+
+    /**
+     * @brief sizes of segments to allocate to meet recent demand without exceeding capacity
+     */
+    std::vector<size_t> Shortage();
+
+    /**
+     * @brief remove segments until at least bytes are taken out, caller frees them
+     * @return removed segments and their sizes
+     */
+    std::vector<std::pair<size_t, api::DataEntry>> Trim(size_t bytes);
+
+    /**
+     * @brief block until demand changes or timeout
+     */
+    void WaitDemand(int timeout_ms);
+
+private:
+    size_t capacity_;
+    size_t pooled_bytes_ = 0;
+
+    /* size -> segments */
+    std::map<size_t, std::vector<api::DataEntry>> segments_;
+
+    /* size -> requests in current and previous iteration */
+    int64_t iteration_ = -1;
+    std::map<size_t, size_t> demand_;
+    std::map<size_t, size_t> last_demand_;
+
+    std::mutex mut_;
+    std::condition_variable demand_cv_;
+
+    bvar::Adder<int64_t> hit_{"ckpt_engine_memfd_pool", "hit"};
+    bvar::Adder<int64_t> miss_{"ckpt_engine_memfd_pool", "miss"};
+    bvar::Adder<int64_t> pooled_bytes_var_{"ckpt_engine_memfd_pool", "pooled_bytes"};
+    bvar::Adder<int64_t> recycled_{"ckpt_engine_memfd_pool", "recycled"};
+};
+} // namespace monitor
@@ -0,0 +1,69 @@
+/**
+ * @file memory_events.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief kernel notifications of memory state changes
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace monitor {
+/**
+ * @brief wait for kernel to report memory pressure or cgroup memory events
+ * @details Sources are set up best effort, any of them may be unavailable:
+ * - PSI trigger on memory.pressure of cgroup, or /proc/pressure/memory
+ * - modification of memory.events of cgroup v2
+ * - memory.pressure_level of cgroup v1 through cgroup.event_control
+ */
+class MemoryEvents {
+public:
+    /**
+     * @param cgroup_dir cgroup directory of memory controller, ending with '/'
+     */
+    explicit MemoryEvents(const std::string &cgroup_dir);
+    ~MemoryEvents();
+    MemoryEvents(const MemoryEvents &) = delete;
+    MemoryEvents(MemoryEvents &&) = delete;
+    MemoryEvents &operator=(const MemoryEvents &) = delete;
+    MemoryEvents &operator=(MemoryEvents &&) = delete;
+
+    /**
+     * @brief block until an event arrives or timeout
+     * @return bool true if any event arrived
+     */
+    bool Wait(int timeout_ms);
+
+    /**
+     * @brief return number of event sources set up
+     */
+    size_t Sources() const {
+        return fds_.size();
+    }
+
+private:
+    /**
+     * @brief an fd to poll and how to consume its event
+     */
+    struct Source {
+        int fd;
+        short events;
+        bool readable;
+    };
+
+    void watchPressure(const std::string &file);
+    void watchEvents(const std::string &file);
+    void watchPressureLevel(const std::string &cgroup_dir);
+
+    std::vector<Source> fds_;
+
+    /* fds opened to keep notifications alive but not polled */
+    std::vector<int> holders_;
+};
+} // namespace monitor
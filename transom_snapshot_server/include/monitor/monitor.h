@@ -15,19 +15,77 @@
 #include <sys/vfs.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <fstream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <vector>
+
+#include <bvar/bvar.h>
 
 #include "config/config.h"
+#include "monitor/cgroup.h"
+#include "monitor/memfd_pool.h"
+#include "util/thread_pool.h"
 #include "util/util.h"
 
 namespace monitor {
 constexpr double gb = 1073741824;
 
+/**
+ * @brief class of memory a reservation is charged to, each class may have its own budget
+ */
+enum MemoryClass {
+    /**
+     * @brief checkpoints saved by local ranks
+     */
+    MEMORY_OWN = 0,
+
+    /**
+     * @brief backups of checkpoints of previous node
+     */
+    MEMORY_BACKUP = 1,
+
+    /**
+     * @brief checkpoints restored from file system or peer node
+     */
+    MEMORY_RESTORE = 2,
+
+    MEMORY_CLASS_NUM = 3,
+};
+
+/**
+ * @brief name of memory class for logging
+ */
+std::string MemoryClassString(MemoryClass cls);
+
+/**
+ * @brief memory of a NUMA node
+ */
+struct NodeMemoryStat {
+    int node = 0;
+
+    /**
+     * @brief MemTotal of node
+     */
+    size_t capacity = 0;
+
+    /**
+     * @brief MemFree of node
+     */
+    size_t idle = 0;
+
+    /**
+     * @brief memory of checkpoint cache bound to node
+     */
+    size_t self_usage = 0;
+};
+
 /**
  * @brief memory stat struct, containing capcity, idle, usage, etc
  */
@@ -38,7 +96,7 @@ struct MemoryStat {
     size_t total_capacity;
 
     /**
-     * @brief capacity - usage
+     * @brief capacity - (usage - reclaimable)
      */
     size_t total_idle;
 
@@ -52,16 +110,27 @@ struct MemoryStat {
      */
     size_t total_max_usage;
 
+    /**
+     * @brief clean page cache in usage, which kernel drops before OOM
+     */
+    size_t total_reclaimable;
+
     /**
      * @brief memory usage by checkpoint cache
      */
     size_t self_total_usage;
 
+    /**
+     * @brief per NUMA node statistics, empty if NUMA is disabled
+     */
+    std::vector<NodeMemoryStat> nodes;
+
     MemoryStat() {
         total_capacity = 0;
         total_idle = 0;
         total_usage = 0;
         total_max_usage = 0;
+        total_reclaimable = 0;
         self_total_usage = 0;
     }
 
@@ -70,7 +139,9 @@ struct MemoryStat {
         total_idle = stat.total_idle;
         total_usage = stat.total_usage;
         total_max_usage = stat.total_max_usage;
+        total_reclaimable = stat.total_reclaimable;
         self_total_usage = stat.self_total_usage;
+        nodes = stat.nodes;
     }
 
     /**
@@ -91,7 +162,13 @@ struct MemoryStat {
            << "mem_idle " << MemoryStat::toGB(total_idle) << " GB, "
            << "mem_self_usage " << MemoryStat::toGB(self_total_usage) << " GB, "
            << "mem_usage " << MemoryStat::toGB(total_usage) << " GB, "
-           << "mem_max_usage " << MemoryStat::toGB(total_max_usage) << " GB";
+           << "mem_max_usage " << MemoryStat::toGB(total_max_usage) << " GB, "
+           << "mem_reclaimable " << MemoryStat::toGB(total_reclaimable) << " GB";
+        for (auto &node : nodes) {
+            ss << ", node" << node.node << " total " << MemoryStat::toGB(node.capacity) << " GB"
+               << " idle " << MemoryStat::toGB(node.idle) << " GB"
+               << " self_usage " << MemoryStat::toGB(node.self_usage) << " GB";
+        }
         return ss.str();
     }
 };
@@ -103,24 +180,121 @@ struct MemoryStat {
  */
 class MemoryMonitor {
 private:
-    /* internal buffer for reading from file */
-    char *buffer_;
+    /* cgroup v1 or v2 */
+    std::unique_ptr<CgroupBackend> cgroup_;
 
     /* user specified total memory for checkpoint */
     size_t user_limit_;
 
-    MemoryStat stat_;
+    /* snapshot read by allocations without lock, refreshed on memory events */
+    std::atomic<size_t> capacity_{0};
+    std::atomic<size_t> usage_{0};
+    std::atomic<size_t> max_usage_{0};
+    std::atomic<size_t> reclaimable_{0};
+    std::atomic<size_t> self_usage_{0};
+    std::atomic<size_t> idle_{0};
+
+    /* serializes collection */
     std::mutex mu_;
 
     void collectMetric(bool);
 
+    /* per class budget, 0 means bounded by capacity only */
+    size_t budgets_[MEMORY_CLASS_NUM] = {0};
+
+    /* reserved and committed bytes per class */
+    std::atomic<size_t> class_used_[MEMORY_CLASS_NUM] = {};
+    std::atomic<size_t> class_committed_[MEMORY_CLASS_NUM] = {};
+
+    /* default time to wait for memory */
+    int wait_ms_;
+
+    /* waiters for memory */
+    std::mutex space_mu_;
+    std::condition_variable space_cv_;
+
     /**
-     * @brief check if next malloc operator will fail
-     *
-     * @param to_alloc size to alloc
-     * @return
+     * @brief what memfdFree gives back
+     */
+    struct Allocation {
+        MemoryClass cls;
+
+        /* mapped size */
+        size_t size;
+
+        /* NUMA node bound to, -1 if not bound */
+        int node;
+    };
+
+    /* address -> memfd allocated */
+    std::map<size_t, Allocation> allocations_;
+    std::mutex alloc_mu_;
+
+    /**
+     * @brief memory bound to a NUMA node
      */
-    bool enough(size_t to_alloc);
+    struct NodeUsage {
+        std::atomic<size_t> bytes{0};
+        bvar::Adder<int64_t> var;
+    };
+
+    /* node -> usage, empty if NUMA is disabled */
+    std::map<int, std::unique_ptr<NodeUsage>> node_usage_;
+
+    void chargeNode(int node, int64_t delta);
+
+    /**
+     * @brief bind memory of entry to node, recorded in entry and allocation
+     * @param move migrate pages faulted already
+     */
+    void bindNode(api::DataEntry &entry, size_t size, int node, bool move);
+
+    bvar::Adder<int64_t> own_bytes_{"ckpt_engine_memory", "own_bytes"};
+    bvar::Adder<int64_t> backup_bytes_{"ckpt_engine_memory", "backup_bytes"};
+    bvar::Adder<int64_t> restore_bytes_{"ckpt_engine_memory", "restore_bytes"};
+
+    /**
+     * @brief take size from budget of cls and idle memory at once, so that concurrent allocations do not overcommit
+     * @return bool false if either is insufficient, nothing is taken then
+     */
+    bool tryReserve(MemoryClass cls, size_t size);
+
+    /**
+     * @brief wake up waiters of memory
+     */
+    void notifySpace();
+
+    /**
+     * @brief reserve memory and create memfd for metadata.size, only what is mapped stays accounted
+     * @return int status_code, non-zero value indicates failure
+     */
+    int allocate(const api::Metadata &metadata, api::DataEntry &entry, MemoryClass cls, int wait_ms);
+
+    /* pre-faulted segments, charged to MEMORY_OWN while pooled */
+    std::unique_ptr<MemfdPool> pool_;
+
+    /**
+     * @brief allocate and pre-fault segments the pool is short of, as long as memory allows
+     */
+    void refill();
+
+    /**
+     * @brief free segments trimmed from pool until at least bytes are released
+     * @return bool true if anything is freed
+     */
+    bool shrinkPool(size_t bytes);
+
+    /* reported apart from copy time of client */
+    bvar::Adder<int64_t> prefault_bytes_{"ckpt_engine_prefault", "bytes"};
+    bvar::Adder<int64_t> prefault_ms_{"ckpt_engine_prefault", "ms"};
+
+    /* workers prefaulting new checkpoints, nullptr if disabled */
+    std::unique_ptr<util::ThreadPool> prefault_pool_;
+
+    /**
+     * @brief fault in pages of a new checkpoint by prefault workers in background, without touching its content
+     */
+    void prefaultAsync(const api::Metadata &metadata, const api::DataEntry &entry);
 
 public:
     MemoryMonitor();
@@ -140,7 +314,7 @@ public:
     }
 
     /**
-     * @brief watch memory usage periodically
+     * @brief refresh memory statistics on memory pressure events, or periodically if no event arrives
      */
     void Start();
 
@@ -150,29 +324,67 @@ public:
      */
     MemoryStat GetMemoryStat();
 
+    /**
+     * @brief reserve size bytes of class cls. Snapshot is re-collected only if it looks insufficient
+     *
+     * @param wait_ms time to wait for others to release memory if insufficient, 0 not to wait
+     * @return bool false if memory or budget of class is insufficient
+     */
+    bool Reserve(MemoryClass cls, size_t size, int wait_ms = 0);
+
+    /**
+     * @brief mark reserved bytes as allocated
+     */
+    void Commit(MemoryClass cls, size_t size);
+
+    /**
+     * @brief give back reserved or committed bytes
+     */
+    void Release(MemoryClass cls, size_t size, bool committed);
+
+    /**
+     * @brief configured time callers wait for memory, in milliseconds
+     */
+    int WaitMs() const {
+        return wait_ms_;
+    }
+
     /**
      * @brief try malloc memory with given size using memfd mechanism
      *
      * @param metadata metadata of checkpoint file
-     * @param entry memfd and pid is recorded into entry
+     * @param entry memfd and pid is recorded into entry, memory is bound to entry.numa_node if it's set
+     * @param cls memory class charged
+     * @param wait_ms time to wait for memory if insufficient
      * @return int status_code, non-zero value indicates failure
      */
-    int TryMemfdMalloc(const api::Metadata &metadata, api::DataEntry &entry);
+    int TryMemfdMalloc(const api::Metadata &metadata, api::DataEntry &entry, MemoryClass cls = MEMORY_OWN,
+                       int wait_ms = 0);
 
     /**
-     * @brief free allocated memfd memory
+     * @brief close memfd and free its memory
      *
      * @param metadata metadata of checkpoint file
      * @param entry memfd and pid is recorded into entry
+     * @param wait unmap before return, so that memory is released when it returns
+     */
+    void memfdFree(const api::Metadata &metadata, api::DataEntry &entry, bool wait = false);
+
+    /**
+     * @brief hand memfd memory of a deleted checkpoint back to pool instead of freeing it, only own checkpoints are
+     * taken
+     *
+     * @param metadata checkpoint of entry, its size keys the pool
+     * @return bool false if pool does not take it, caller should free it
      */
-    void memfdFree(api::Metadata &metadata, api::DataEntry &entry);
+    bool Recycle(const api::Metadata &metadata, const api::DataEntry &entry);
 
     /**
      * @brief load checkpoint from FileSystem
      *
      * @param metadata metadata of checkpoint file
-     * @return int status_code, non-zero value indicates failure
+     * @return int status_code, non-zero value indicates failure, memory allocated for it is freed then
      */
-    int TryLoadFromFile(const api::Metadata &metadata, api::DataEntry &entry);
+    int TryLoadFromFile(const api::Metadata &metadata, api::DataEntry &entry, MemoryClass cls = MEMORY_RESTORE);
 };
 } // namespace monitor
\ No newline at end of file
@@ -0,0 +1,127 @@
+/**
+ * @file bandwidth_limiter.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief byte-denominated hierarchical token bucket
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <bvar/bvar.h>
+
+namespace operators {
+/**
+ * @brief traffic that can be throttled
+ */
+enum class TrafficStage {
+    /* budget of the whole node, every stage also consumes it */
+    NODE = 0,
+    /* write checkpoint files to filesystem */
+    PERSIST = 1,
+    /* rdma write checkpoint to the next node */
+    BACKUP = 2,
+};
+
+/**
+ * @brief convert stage to string
+ */
+std::string TrafficStageString(TrafficStage stage);
+
+/**
+ * @brief parse stage from string, return false if unknown
+ */
+bool ParseTrafficStage(const std::string &str, TrafficStage &stage);
+
+/**
+ * @brief a token bucket counting bytes, allowing debt
+ * @details A consumer always takes tokens immediately and sleeps until the debt is paid back, so that a large
+ * request is not starved by small ones. Burst is one second of rate.
+ */
+class ByteTokenBucket {
+public:
+    ByteTokenBucket() = default;
+    ByteTokenBucket(const ByteTokenBucket &) = delete;
+    ByteTokenBucket(ByteTokenBucket &&) = delete;
+    ByteTokenBucket &operator=(const ByteTokenBucket &) = delete;
+    ByteTokenBucket &operator=(ByteTokenBucket &&) = delete;
+
+    /**
+     * @brief take bytes from bucket without blocking
+     * @return std::chrono::microseconds time to wait before the bytes may be sent
+     */
+    std::chrono::microseconds Reserve(size_t bytes);
+
+    /**
+     * @brief bytes per second, 0 means unlimited
+     */
+    uint64_t GetRate() const {
+        return rate_;
+    }
+
+    /**
+     * @brief set bytes per second, 0 means unlimited. Tokens are refilled to burst.
+     */
+    void SetRate(uint64_t rate);
+
+private:
+    std::atomic<uint64_t> rate_{0};
+    double tokens_ = 0;
+    std::chrono::steady_clock::time_point last_;
+    std::mutex mut_;
+};
+
+/**
+ * @brief hierarchical bandwidth limiter, a stage consumes both its own budget and the node budget
+ */
+class BandwidthLimiter {
+public:
+    BandwidthLimiter();
+    BandwidthLimiter(const BandwidthLimiter &) = delete;
+    BandwidthLimiter(BandwidthLimiter &&) = delete;
+    BandwidthLimiter &operator=(const BandwidthLimiter &) = delete;
+    BandwidthLimiter &operator=(BandwidthLimiter &&) = delete;
+
+    static BandwidthLimiter &Instance() {
+        static std::unique_ptr<BandwidthLimiter> instance_ptr_(new BandwidthLimiter());
+        return *instance_ptr_;
+    }
+
+    /**
+     * @brief blocking method, wait until bytes of stage are allowed. Callers should split large transfer into
+     * chunks of config::BANDWIDTH_CHUNK_SIZE so that budget changes take effect in time
+     * @param stage PERSIST or BACKUP
+     * @param bytes bytes to send
+     */
+    void Acquire(TrafficStage stage, size_t bytes);
+
+    /**
+     * @brief bytes per second of stage, 0 means unlimited
+     */
+    uint64_t GetRate(TrafficStage stage);
+
+    /**
+     * @brief change budget at runtime
+     * @param stage NODE, PERSIST or BACKUP
+     * @param rate bytes per second, 0 means unlimited
+     */
+    void SetRate(TrafficStage stage, uint64_t rate);
+
+private:
+    static constexpr int N_STAGES = 3;
+
+    ByteTokenBucket buckets_[N_STAGES];
+
+    /* time spent throttled per stage, unit is microseconds */
+    std::unique_ptr<bvar::Adder<int64_t>> throttled_us_[N_STAGES];
+};
+} // namespace operators
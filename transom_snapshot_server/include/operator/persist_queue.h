@@ -0,0 +1,197 @@
+/**
+ * @file persist_queue.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief priority queue of persistence, newest iteration first
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+#include <bvar/bvar.h>
+
+namespace operators {
+/**
+ * @brief a file waiting to be persisted
+ */
+struct PersistTask {
+    /* file name */
+    std::string key;
+
+    /* iteration parsed from metadata, UNKNOWN_ITERATION if it's not a number */
+    int64_t iteration;
+
+    size_t size;
+
+    /* order of arrival, breaks ties inside an iteration */
+    uint64_t seq;
+
+    /* sorts before all others, set when its iteration is about to be evicted */
+    bool expedited;
+
+    static constexpr int64_t UNKNOWN_ITERATION = -1;
+
+    /**
+     * @brief parse iteration of metadata, "unknown" or anything not a number gives UNKNOWN_ITERATION
+     */
+    static int64_t ParseIteration(const std::string &iteration);
+};
+
+/**
+ * @brief persistence stage of reconciliation
+ * @details Files are persisted by the newest iteration first, so that the iteration a job would restart from is not
+ * stuck behind older ones when persistence falls behind. Files of unknown iteration, e.g. the "latest" tag of
+ * DeepSpeed, are small and never superseded, they go first.
+ *
+ * Files of an iteration evicted from IterationManager are skipped. With policy "latest", once an iteration is fully
+ * persisted, queued files of older iterations are skipped and in-flight ones are aborted. With policy "all", every
+ * file is persisted, and an iteration about to be evicted is moved to the front.
+ */
+class PersistQueue {
+public:
+    PersistQueue();
+    PersistQueue(const PersistQueue &) = delete;
+    PersistQueue(PersistQueue &&) = delete;
+    PersistQueue &operator=(const PersistQueue &) = delete;
+    PersistQueue &operator=(PersistQueue &&) = delete;
+
+    static PersistQueue &Instance() {
+        static std::unique_ptr<PersistQueue> instance_ptr_(new PersistQueue());
+        return *instance_ptr_;
+    }
+
+    /**
+     * @brief register a handler to persist a file
+     * @param handler persist task.key, return false on failure. Failed files are not retried
+     */
+    void SetHandler(std::function<bool(const PersistTask &)> handler);
+
+    /**
+     * @brief register a handler to abort in-flight persistence of a file
+     * @param forget called when an aborted task ends, so an abort arriving before or after its write does not
+     * outlive it
+     */
+    void SetAbortHandler(std::function<void(const std::string &)> handler,
+                         std::function<void(const std::string &)> forget);
+
+    /**
+     * @brief register a checker called when the last queued file of an iteration is persisted
+     * @param checker return true if every file of the iteration is persisted
+     */
+    void SetIterationChecker(std::function<bool(int64_t)> checker);
+
+    /**
+     * @brief start worker threads
+     */
+    void Run();
+
+    /**
+     * @brief add a file, ignored if it's already queued or in flight
+     * @param iteration iteration of metadata
+     */
+    void Push(const std::string &key, const std::string &iteration, size_t size);
+
+    /**
+     * @brief return true if key is queued or in flight
+     */
+    bool Contains(const std::string &key);
+
+    /**
+     * @brief an iteration is fully persisted, supersede older ones if policy is "latest"
+     */
+    void Complete(int64_t iteration);
+
+    /**
+     * @brief an iteration is about to be evicted from memory. Queued files are dropped and in-flight ones are
+     * aborted, blocking until the handlers return, so that memory can be freed safely afterwards
+     */
+    void Evict(int64_t iteration);
+
+    /**
+     * @brief persist queued files of an iteration before any other
+     */
+    void Expedite(int64_t iteration);
+
+    /**
+     * @brief return true if policy is "latest"
+     */
+    bool SkipSuperseded() const {
+        return skip_superseded_;
+    }
+
+private:
+    /**
+     * @brief order of tasks, the first one is persisted first
+     */
+    struct Priority {
+        bool operator()(const PersistTask &a, const PersistTask &b) const;
+    };
+
+    /**
+     * @brief blocking: forever pop tasks and persist
+     */
+    void run();
+
+    /**
+     * @brief return true if key is queued or in flight, lock must be held
+     */
+    bool contains(const std::string &key);
+
+    /**
+     * @brief return number of queued and in-flight files of an iteration, lock must be held
+     */
+    size_t pending(int64_t iteration);
+
+    /**
+     * @brief drop queued tasks and abort in-flight ones matching pred, lock must be held
+     */
+    void cancel(const std::function<bool(int64_t)> &pred, const char *reason);
+
+    /**
+     * @brief return true if iteration has been evicted from IterationManager
+     */
+    static bool evicted(int64_t iteration);
+
+    std::function<bool(const PersistTask &)> handler_;
+    std::function<void(const std::string &)> abort_handler_;
+    std::function<void(const std::string &)> forget_handler_;
+    std::function<bool(int64_t)> iteration_checker_;
+
+    bool skip_superseded_;
+    int nthreads_;
+    uint64_t seq_ = 0;
+
+    /* queued tasks, ordered by Priority */
+    std::set<PersistTask, Priority> queue_;
+
+    /* key -> task being persisted */
+    std::map<std::string, PersistTask> inflight_;
+
+    /* in-flight keys asked to abort */
+    std::set<std::string> aborting_;
+
+    std::mutex mut_;
+    std::condition_variable cv_;
+
+    /* notified when an in-flight task finishes */
+    std::condition_variable done_cv_;
+
+    /* bytes of files never persisted since they are evicted or superseded */
+    bvar::Adder<int64_t> skipped_bytes_{"ckpt_engine_persist", "skipped_bytes"};
+
+    /* bytes of files whose persistence is aborted in flight */
+    bvar::Adder<int64_t> aborted_bytes_{"ckpt_engine_persist", "aborted_bytes"};
+};
+} // namespace operators
@@ -0,0 +1,114 @@
+/**
+ * @file cold_tier.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief spill cold checkpoints to local NVMe
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <bvar/bvar.h>
+
+namespace storage {
+/**
+ * @brief bounded store of spilled checkpoints on a local device
+ * @details A checkpoint is copied from its memfd in kernel, synced and dropped from page cache, so that it does not
+ * count against the cgroup memory it was spilled to release. Nothing survives restart, files left by the previous
+ * run are removed. When the tier is full, checkpoints of the oldest iteration, then least recently used, are
+ * evicted, but never for a checkpoint of an older iteration.
+ */
+class ColdTier {
+public:
+    ColdTier();
+    ColdTier(const ColdTier &) = delete;
+    ColdTier(ColdTier &&) = delete;
+    ColdTier &operator=(const ColdTier &) = delete;
+    ColdTier &operator=(ColdTier &&) = delete;
+
+    /**
+     * @brief singleton instance
+     * @return reference of singleton instance, cannot be copied or deleted
+     */
+    static ColdTier &Instance() {
+        static std::unique_ptr<ColdTier> instance_ptr_(new ColdTier());
+        return *instance_ptr_;
+    }
+
+    /**
+     * @brief return true if cold tier directory is configured
+     */
+    bool Enabled() const {
+        return !dir_.empty();
+    }
+
+    /**
+     * @brief copy size bytes of fd into tier, replacing previous copy of file_name
+     * @param iteration iteration of checkpoint, -1 if unknown, older ones are evicted first
+     * @param evicted file names evicted to make room, they are gone even if it fails
+     * @return bool true: success
+     */
+    bool Put(const std::string &file_name, int fd, size_t size, int64_t iteration,
+             std::vector<std::string> &evicted);
+
+    /**
+     * @brief read spilled checkpoint into memory, hugetlbfs memfd cannot be written as a file
+     * @param size expected size
+     * @return bool true: success
+     */
+    bool Get(const std::string &file_name, char *data, size_t size);
+
+    /**
+     * @brief return size of spilled checkpoint, 0 if not found
+     */
+    size_t Size(const std::string &file_name);
+
+    /**
+     * @brief remove spilled checkpoint if exists
+     */
+    void Remove(const std::string &file_name);
+
+private:
+    /**
+     * @brief a spilled checkpoint
+     */
+    struct Item {
+        size_t size;
+        int64_t iteration;
+
+        /* larger is more recent */
+        uint64_t access;
+    };
+
+    std::string path(const std::string &file_name);
+
+    /**
+     * @brief remove item and its file, lock must be held
+     */
+    void remove(std::map<std::string, Item>::iterator it);
+
+    std::string dir_;
+    size_t capacity_ = 0;
+
+    /* bytes of items and spills in progress */
+    size_t used_ = 0;
+    uint64_t clock_ = 0;
+    std::map<std::string, Item> items_;
+    std::mutex mut_;
+
+    bvar::Adder<int64_t> used_bytes_{"ckpt_engine_cold_tier", "used_bytes"};
+    bvar::Adder<int64_t> spill_bytes_{"ckpt_engine_cold_tier", "spill_bytes"};
+    bvar::Adder<int64_t> rehydrate_bytes_{"ckpt_engine_cold_tier", "rehydrate_bytes"};
+    bvar::Adder<int64_t> evict_bytes_{"ckpt_engine_cold_tier", "evict_bytes"};
+};
+} // namespace storage
@@ -0,0 +1,98 @@
+/**
+ * @file compression.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief seekable zstd compression of checkpoint files
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <bvar/bvar.h>
+
+#include "util/thread_pool.h"
+
+namespace storage {
+/**
+ * @brief compress data into independent zstd frames followed by a seek table
+ * @details The layout follows zstd seekable format, so files can be inspected by zstd contrib tools:
+ * frames, then a skippable frame holding (compressed size, decompressed size) of each frame and a footer of
+ * frame count, descriptor and magic 0x8F92EAB1. Frames are compressed and decompressed concurrently,
+ * and a byte range can be read by decompressing only the frames covering it.
+ */
+class SeekableZstd {
+public:
+    /**
+     * @param level zstd compression level
+     * @param frame_size bytes of data compressed into a frame, less than 4GB
+     */
+    SeekableZstd(int level, size_t frame_size);
+    SeekableZstd(const SeekableZstd &) = delete;
+    SeekableZstd(SeekableZstd &&) = delete;
+    SeekableZstd &operator=(const SeekableZstd &) = delete;
+    SeekableZstd &operator=(SeekableZstd &&) = delete;
+
+    /**
+     * @brief compress data into a temporary file and rename it to file_name
+     * @param pool workers to compress frames, writing overlaps with compressing the next batch
+     * @param throttle called before writing a frame with its size, return false to abort
+     * @return bool true: success
+     */
+    bool Write(const std::string &file_name, const void *data, size_t size, util::ThreadPool &pool,
+               const std::function<bool(size_t)> &throttle);
+
+    /**
+     * @brief return true if fd ends with seekable footer
+     */
+    static bool Detect(int fd);
+
+    /**
+     * @brief decompress [offset, offset + length) of original data, frame layout is read from seek table
+     * @param fd opened compressed file
+     * @param data where data stores, at least length bytes
+     * @param pool workers to decompress frames
+     * @return bool true: success
+     */
+    static bool Read(const std::string &file_name, int fd, size_t offset, size_t length, void *data, util::ThreadPool &pool);
+
+private:
+    /**
+     * @brief a frame in seek table
+     */
+    struct Frame {
+        uint64_t compressed_offset;
+        uint32_t compressed_size;
+        uint64_t decompressed_offset;
+        uint32_t decompressed_size;
+    };
+
+    /**
+     * @brief parse seek table at the end of fd
+     */
+    static bool readSeekTable(const std::string &file_name, int fd, std::vector<Frame> &frames);
+
+    /**
+     * @brief input bytes divided by output bytes since started
+     */
+    static double ratio(void *arg);
+
+    int level_;
+    size_t frame_size_;
+
+    /* bytes before compression */
+    bvar::Adder<int64_t> input_bytes_{"ckpt_engine_persist", "compress_input_bytes"};
+
+    /* bytes after compression */
+    bvar::Adder<int64_t> output_bytes_{"ckpt_engine_persist", "compress_output_bytes"};
+
+    bvar::PassiveStatus<double> ratio_{"ckpt_engine_persist", "compress_ratio", ratio, this};
+};
+} // namespace storage
@@ -0,0 +1,162 @@
+/**
+ * @file eviction.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief evict cached iterations by iteration count and memory budget
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <bvar/bvar.h>
+
+namespace storage {
+/**
+ * @brief what eviction policy knows about a cached iteration
+ */
+struct IterationStat {
+    size_t iteration = 0;
+
+    /* number of iterations after it up to the latest one */
+    size_t age = 0;
+
+    /* memory held by files of this node, spilled ones excluded */
+    size_t bytes = 0;
+    size_t files = 0;
+
+    /* all files are persistent, they can be restored from file system */
+    bool persistent = false;
+};
+
+/**
+ * @brief choose which iteration to evict, the one with highest score goes first
+ */
+class EvictionPolicy {
+public:
+    virtual ~EvictionPolicy() = default;
+
+    virtual std::string Name() const = 0;
+    virtual double Score(const IterationStat &stat) const = 0;
+};
+
+/**
+ * @brief oldest iteration first
+ */
+class FifoEvictionPolicy : public EvictionPolicy {
+public:
+    std::string Name() const override;
+    double Score(const IterationStat &stat) const override;
+};
+
+/**
+ * @brief weigh age of iteration, memory it holds and whether it's persistent
+ */
+class CostEvictionPolicy : public EvictionPolicy {
+public:
+    std::string Name() const override;
+    double Score(const IterationStat &stat) const override;
+};
+
+/**
+ * @brief create eviction policy by config
+ */
+class EvictionPolicyFactory {
+public:
+    static std::unique_ptr<EvictionPolicy> Create();
+};
+
+/**
+ * @brief evict cached iterations of this node in background once there are more iterations than
+ * ENV_MAX_ITERATION_IN_CACHE or they hold more memory than the budget
+ * @details An iteration is a candidate only if it's not the latest one, not pinned, and all of its files are backed
+ * up or persistent, i.e. nothing but a cached copy is lost. Pinning an iteration being evicted does not stop it.
+ */
+class Evictor {
+public:
+    Evictor(const Evictor &) = delete;
+    Evictor(Evictor &&) = delete;
+    Evictor &operator=(const Evictor &) = delete;
+    Evictor &operator=(Evictor &&) = delete;
+
+    static Evictor &Instance() {
+        static std::unique_ptr<Evictor> instance_ptr_(new Evictor());
+        return *instance_ptr_;
+    }
+
+    /**
+     * @brief set how an iteration is evicted, return false on failure
+     */
+    void SetHandler(std::function<bool(size_t)> handler);
+
+    /**
+     * @brief start background thread
+     */
+    void Start();
+
+    /**
+     * @brief wake evictor up, e.g. a new iteration is cached
+     */
+    void Notify();
+
+    /**
+     * @brief keep iteration in memory until the tag is unpinned, a tag pins one iteration at a time
+     */
+    void Pin(const std::string &tag, size_t iteration);
+
+    /**
+     * @return bool false if tag is not found
+     */
+    bool Unpin(const std::string &tag);
+
+    /**
+     * @brief return pinned iteration of each tag
+     */
+    std::map<std::string, size_t> Pins();
+
+private:
+    Evictor();
+
+    void run();
+
+    /**
+     * @brief evict until cached iterations are within limits or no candidate is left
+     * @return size_t number of iterations evicted
+     */
+    size_t evict();
+
+    /**
+     * @brief files and state of each iteration of this node in metadata
+     */
+    bool collect(std::map<size_t, IterationStat> &stats, std::map<size_t, bool> &settled);
+
+    bool pinned(size_t iteration);
+
+    std::unique_ptr<EvictionPolicy> policy_;
+    std::function<bool(size_t)> handler_;
+
+    /* in bytes, 0 means unlimited */
+    size_t budget_ = 0;
+
+    std::mutex mut_;
+    std::condition_variable cv_;
+    bool wake_ = false;
+    std::map<std::string, size_t> pins_;
+
+    bvar::Adder<int64_t> evicted_{"ckpt_engine_eviction", "iterations"};
+    bvar::Adder<int64_t> evicted_bytes_{"ckpt_engine_eviction", "bytes"};
+
+    /* over limits, but every iteration is pinned, unsettled or the latest one */
+    bvar::Adder<int64_t> blocked_{"ckpt_engine_eviction", "blocked"};
+};
+} // namespace storage
@@ -0,0 +1,87 @@
+/**
+ * @file local_metadata.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief embedded metadata store on local disk
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "api/api.h"
+#include "storage/metadata_log.h"
+
+namespace storage {
+/**
+ * @brief embedded metadata store, rows in memory indexed by file name, node rank, iteration and state
+ * @details Writes are synced to an append-only log before they are applied, so they survive crash once returned.
+ * The log is replayed at open, and compacted to live rows once it has META_LOCAL_COMPACT_RECORDS stale records.
+ * A log is locked by a single process. Semantics of status codes are the same as mysql client.
+ */
+class LocalMetadataStore {
+public:
+    explicit LocalMetadataStore(const std::string &path) : log_(path) {}
+    ~LocalMetadataStore();
+    LocalMetadataStore(const LocalMetadataStore &) = delete;
+    LocalMetadataStore &operator=(const LocalMetadataStore &) = delete;
+
+    /**
+     * @brief lock and replay log
+     * @return bool false if log is locked by others or cannot be opened
+     */
+    bool Open();
+
+    int Save(api::Metadata &metadata);
+    int Load(api::Metadata &metadata);
+    int UpdateState(const std::string &file_name, const api::CheckpointState &state);
+    int DeleteByFileName(const std::string &file_name);
+    int BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec);
+    int BatchSave(std::vector<api::Metadata> &vec);
+    int BatchDelete(const std::vector<std::string> &file_names);
+    int BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state);
+
+    /**
+     * @brief return true if there is a row of file
+     */
+    bool Contains(const std::string &file_name);
+
+    /**
+     * @brief number of rows
+     */
+    size_t Size();
+
+private:
+    /**
+     * @brief log records, then apply them. Caller holds mut_ exclusively
+     */
+    int write(const std::vector<MetadataLog::Record> &records);
+
+    void apply(MetadataLog::Op op, const api::Metadata &metadata);
+    void index(const api::Metadata &metadata);
+    void unindex(const api::Metadata &metadata);
+    void compact();
+
+    MetadataLog log_;
+    int lock_fd_ = -1;
+
+    /* records in log, compared with live rows to decide compaction */
+    size_t records_ = 0;
+
+    std::map<std::string, api::Metadata> rows_;
+
+    /* secondary indexes to file names */
+    std::map<int, std::set<std::string>> by_rank_;
+    std::map<std::string, std::set<std::string>> by_iteration_;
+    std::map<int, std::set<std::string>> by_state_;
+    std::shared_mutex mut_;
+};
+} // namespace storage
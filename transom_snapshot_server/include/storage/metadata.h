@@ -13,7 +13,6 @@
 
 #include <map>
 #include <memory>
-#include <shared_mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -76,45 +75,81 @@ public:
      * @return int status code, non-zero means failure
      */
     virtual int BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) = 0;
-};
 
-class MysqlClient : public MetaClient {
-private:
-    std::string db_addr_;
-    int db_port_;
-    std::string db_user_;
-    std::string db_password_;
-    std::string db_name_;
+    /**
+     * @brief insert or replace metadata in batch, by Save one by one unless overridden
+     *
+     * @param vec checkpoint file metadata
+     * @return int status code, non-zero means failure
+     */
+    virtual int BatchSave(std::vector<api::Metadata> &vec);
 
-    MYSQL *sql_;
-    inline static std::shared_mutex rw_mutex_ = {};
+    /**
+     * @brief delete checkpoint file records in batch, by DeleteByFileName one by one unless overridden
+     *
+     * @param file_names file names
+     * @return int status code, non-zero means failure
+     */
+    virtual int BatchDelete(const std::vector<std::string> &file_names);
 
+    /**
+     * @brief update state of checkpoint files in batch, by UpdateState one by one unless overridden
+     *
+     * @param file_names checkpoint file names
+     * @param state updated state
+     * @return int status code, non-zero means failure
+     */
+    virtual int BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state);
+};
+
+/**
+ * @brief metadata client of mysql, statements run on connections borrowed from MysqlConnectionPool, so it's cheap
+ * to create
+ */
+class MysqlClient : public MetaClient {
 public:
     MysqlClient();
-    ~MysqlClient();
 
     int Save(api::Metadata &metadata) override;
     int Load(api::Metadata &metadata) override;
     int UpdateState(const std::string &file_name, const api::CheckpointState &state) override;
     int DeleteByFileName(const std::string &file_name) override;
     int BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) override;
+    int BatchSave(std::vector<api::Metadata> &vec) override;
+    int BatchDelete(const std::vector<std::string> &file_names) override;
+    int BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) override;
 };
 
-class TransomServiceClient : public MetaClient {
-private:
-    std::string addr_;
-    int port_;
-    brpc::Channel chan_;
-
+/**
+ * @brief metadata client of embedded store on local disk, see LocalMetadataStore. Rows of other nodes are invisible,
+ * so it serves single node jobs only
+ */
+class LocalClient : public MetaClient {
 public:
-    TransomServiceClient();
-    ~TransomServiceClient();
+    int Save(api::Metadata &metadata) override;
+    int Load(api::Metadata &metadata) override;
+    int UpdateState(const std::string &file_name, const api::CheckpointState &state) override;
+    int DeleteByFileName(const std::string &file_name) override;
+    int BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) override;
+    int BatchSave(std::vector<api::Metadata> &vec) override;
+    int BatchDelete(const std::vector<std::string> &file_names) override;
+    int BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) override;
+};
 
+/**
+ * @brief metadata client of metadata service, see MetadataServiceImpl. Clients of a process share a long-lived
+ * channel where requests are pipelined, and their concurrent writes are sent in batches
+ */
+class TransomServiceClient : public MetaClient {
+public:
     int Save(api::Metadata &metadata) override;
     int Load(api::Metadata &metadata) override;
     int UpdateState(const std::string &file_name, const api::CheckpointState &state) override;
     int DeleteByFileName(const std::string &file_name) override;
     int BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) override;
+    int BatchSave(std::vector<api::Metadata> &vec) override;
+    int BatchDelete(const std::vector<std::string> &file_names) override;
+    int BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) override;
 };
 
 /**
@@ -123,9 +158,15 @@ public:
 class MetadataClientFactory {
 public:
     /**
-     * @brief return a new metadata client
+     * @brief return a new metadata client, which is served by MetadataCache once it's started
      * @return MetaClient
      */
     static std::shared_ptr<MetaClient> GetClient();
+
+    /**
+     * @brief return a new metadata client of database configured, bypassing MetadataCache
+     * @return MetaClient
+     */
+    static std::shared_ptr<MetaClient> GetDatabaseClient();
 };
 } // namespace storage
\ No newline at end of file
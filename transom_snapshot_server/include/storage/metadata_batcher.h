@@ -0,0 +1,74 @@
+/**
+ * @file metadata_batcher.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief batching of concurrent metadata state updates
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <bvar/bvar.h>
+
+#include "api/api.h"
+
+namespace storage {
+/**
+ * @brief merge state updates of concurrent threads into MetaClient::BatchUpdateState calls
+ * @details Files of an iteration change state together, updated by reconcilers, persistence workers and http
+ * handlers of local ranks at the same time. An update is sent by one of the callers at a time, taking all updates
+ * queued meanwhile into a BatchUpdateState per state, so that they share a round trip to database. No delay is
+ * added, an update alone is sent at once.
+ */
+class MetadataBatcher {
+public:
+    ~MetadataBatcher() = default;
+    MetadataBatcher(const MetadataBatcher &) = delete;
+    MetadataBatcher(MetadataBatcher &&) = delete;
+    MetadataBatcher &operator=(const MetadataBatcher &) = delete;
+    MetadataBatcher &operator=(MetadataBatcher &&) = delete;
+
+    static MetadataBatcher &Instance() {
+        static std::unique_ptr<MetadataBatcher> instance_ptr_(new MetadataBatcher());
+        return *instance_ptr_;
+    }
+
+    /**
+     * @brief update state of file, batched with concurrent updates
+     * @return int status code of the batch it's sent in
+     */
+    int UpdateState(const std::string &file_name, const api::CheckpointState &state);
+
+private:
+    MetadataBatcher() = default;
+
+    struct Pending {
+        const std::string *file_name;
+        api::CheckpointState state;
+        int code = api::STATUS_UNKNOWN_ERROR;
+        bool done = false;
+    };
+
+    /**
+     * @brief send a batch, one BatchUpdateState per state
+     */
+    void send(const std::deque<Pending *> &batch);
+
+    std::deque<Pending *> queue_;
+    bool sending_ = false;
+    std::mutex mut_;
+    std::condition_variable cv_;
+
+    bvar::Adder<int64_t> batches_{"ckpt_engine_meta_batcher", "batches"};
+    bvar::Adder<int64_t> updates_{"ckpt_engine_meta_batcher", "updates"};
+};
+} // namespace storage
@@ -0,0 +1,130 @@
+/**
+ * @file metadata_cache.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief write-behind metadata cache of current node
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include <bvar/bvar.h>
+
+#include "api/api.h"
+#include "storage/metadata.h"
+#include "storage/metadata_log.h"
+
+namespace storage {
+/**
+ * @brief write-behind cache of metadata, authoritative for rows of current node once started
+ * @details Rows of a node are only written by its own server, so they are loaded once at startup and served from
+ * memory afterwards. Writes update memory and are appended to a local log, then flushed to database in multi-row
+ * batches every ENV_KEY_META_FLUSH_MS. Writes not flushed yet are replayed from the log at startup.
+ * Rows of other nodes are read and written through, so they lag behind by a flush interval at most. Requests that
+ * make another node read rows of current node, i.e. backup and batch-load, flush first.
+ */
+class MetadataCache {
+public:
+    ~MetadataCache() = default;
+    MetadataCache(const MetadataCache &) = delete;
+    MetadataCache(MetadataCache &&) = delete;
+    MetadataCache &operator=(const MetadataCache &) = delete;
+    MetadataCache &operator=(MetadataCache &&) = delete;
+
+    static MetadataCache &Instance() {
+        static std::unique_ptr<MetadataCache> instance_ptr_(new MetadataCache());
+        return *instance_ptr_;
+    }
+
+    /**
+     * @brief replay log, load rows of current node and flush in background. Nothing happens if cache is disabled
+     */
+    void Start();
+
+    /**
+     * @brief return true once started, before that metadata clients go to database directly
+     */
+    bool Running() const {
+        return running_;
+    }
+
+    /**
+     * @brief flush writes to database synchronously
+     * @return bool false if database fails, writes are kept and retried next time
+     */
+    bool Flush();
+
+    int Save(api::Metadata &metadata);
+    int Load(api::Metadata &metadata);
+    int UpdateState(const std::string &file_name, const api::CheckpointState &state);
+    int DeleteByFileName(const std::string &file_name);
+    int BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec);
+    int BatchSave(std::vector<api::Metadata> &vec);
+    int BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state);
+    int BatchDelete(const std::vector<std::string> &file_names);
+
+private:
+    MetadataCache();
+
+    /**
+     * @brief apply writes to memory and log them by a single append. Caller holds mut_
+     */
+    void write(const std::vector<MetadataLog::Record> &records);
+
+    /**
+     * @brief read writes of log into dirty_, a torn record at tail is ignored
+     */
+    void replay(const std::string &path);
+
+    bool enabled_ = false;
+    std::atomic<bool> running_ = false;
+    int node_rank_;
+    int flush_ms_;
+
+    /* current log, and the one being flushed */
+    std::string log_path_;
+    std::string flushing_path_;
+    std::unique_ptr<MetadataLog> log_;
+
+    /* rows of current node, and writes not flushed yet */
+    std::map<std::string, api::Metadata> rows_;
+    std::map<std::string, std::optional<api::Metadata>> dirty_;
+    std::shared_mutex mut_;
+
+    /* a flush at a time */
+    std::mutex flush_mut_;
+
+    bvar::Adder<int64_t> hits_{"ckpt_engine_meta_cache", "hits"};
+    bvar::Adder<int64_t> misses_{"ckpt_engine_meta_cache", "misses"};
+    bvar::Adder<int64_t> flushed_{"ckpt_engine_meta_cache", "flushed_rows"};
+    bvar::Adder<int64_t> flush_failures_{"ckpt_engine_meta_cache", "flush_failures"};
+    bvar::LatencyRecorder flush_latency_{"ckpt_engine_meta_cache", "flush"};
+};
+
+/**
+ * @brief metadata client served by MetadataCache
+ */
+class CachedClient : public MetaClient {
+public:
+    int Save(api::Metadata &metadata) override;
+    int Load(api::Metadata &metadata) override;
+    int UpdateState(const std::string &file_name, const api::CheckpointState &state) override;
+    int DeleteByFileName(const std::string &file_name) override;
+    int BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) override;
+    int BatchSave(std::vector<api::Metadata> &vec) override;
+    int BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) override;
+    int BatchDelete(const std::vector<std::string> &file_names) override;
+};
+} // namespace storage
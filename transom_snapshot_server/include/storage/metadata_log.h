@@ -0,0 +1,74 @@
+/**
+ * @file metadata_log.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief append-only log of metadata writes
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "api/api.h"
+
+namespace storage {
+/**
+ * @brief append-only log of metadata writes. A record is its length, checksum, operation and marshaled metadata,
+ * so a torn or corrupted tail left by a crash is detected and ignored on replay
+ */
+class MetadataLog {
+public:
+    enum Op : char {
+        SAVE = 'S',
+        DELETE = 'D',
+    };
+    using Record = std::pair<Op, api::Metadata>;
+
+    explicit MetadataLog(std::string path) : path_(std::move(path)) {}
+    ~MetadataLog();
+    MetadataLog(const MetadataLog &) = delete;
+    MetadataLog &operator=(const MetadataLog &) = delete;
+
+    /**
+     * @brief open for appending, created if absent
+     */
+    bool Open();
+    void Close();
+
+    /**
+     * @brief append records by a single write, a failed append is truncated so the log ends at a complete record,
+     * and the log is closed if truncating fails
+     * @param sync fdatasync before return
+     */
+    bool Append(const std::vector<Record> &records, bool sync);
+
+    /**
+     * @brief replace log with records atomically, by writing a temporary file and renaming it. Log is reopened
+     */
+    bool Rewrite(const std::vector<Record> &records);
+
+    /**
+     * @brief call fn with records of file in order, until a torn or corrupted one, which is truncated with
+     * the rest
+     * @return size_t number of records replayed
+     */
+    static size_t Replay(const std::string &path, const std::function<void(Op, api::Metadata &)> &fn);
+
+    const std::string &Path() const {
+        return path_;
+    }
+
+private:
+    static std::string encode(const std::vector<Record> &records);
+
+    std::string path_;
+    int fd_ = -1;
+};
+} // namespace storage
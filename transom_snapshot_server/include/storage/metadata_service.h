@@ -0,0 +1,79 @@
+/**
+ * @file metadata_service.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief standalone metadata service
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <bvar/bvar.h>
+
+#include "api/api.h"
+#include "storage/local_metadata.h"
+#include "storage/metadata.pb.h"
+
+namespace storage {
+/**
+ * @brief convert between metadata and its message
+ */
+void ToRow(const api::Metadata &metadata, MetadataRow *row);
+void FromRow(const MetadataRow &row, api::Metadata &metadata);
+
+/**
+ * @brief metadata service serving TransomServiceClient
+ * @details Rows of a job are sharded by node rank into stores of LocalMetadataStore, opened on first use, so that
+ * a BatchLoad of a node scans a single shard. Writes of a request are coalesced per file and applied to each shard
+ * by a single synced append. Writes of a job are serialized, reads are not.
+ */
+class MetadataServiceImpl : public MetadataService {
+public:
+    MetadataServiceImpl(std::string dir, size_t shards);
+
+    void Write(google::protobuf::RpcController *cntl_base, const MetadataWriteRequest *request,
+               MetadataWriteResponse *response, google::protobuf::Closure *done) override;
+    void Load(google::protobuf::RpcController *cntl_base, const MetadataLoadRequest *request,
+              MetadataLoadResponse *response, google::protobuf::Closure *done) override;
+    void BatchLoad(google::protobuf::RpcController *cntl_base, const MetadataBatchLoadRequest *request,
+                   MetadataBatchLoadResponse *response, google::protobuf::Closure *done) override;
+
+private:
+    struct Job {
+        std::vector<std::unique_ptr<LocalMetadataStore>> shards;
+        std::mutex write_mut;
+    };
+
+    /**
+     * @brief shards of job, opened on first use
+     * @return nullptr if a shard cannot be opened
+     */
+    Job *job(const std::string &name);
+
+    LocalMetadataStore &shard(Job &job, int node_rank);
+
+    /**
+     * @brief shard holding row of file, nullptr if none
+     */
+    LocalMetadataStore *locate(Job &job, const std::string &file_name);
+
+    std::string dir_;
+    size_t shards_;
+    std::map<std::string, std::unique_ptr<Job>> jobs_;
+    std::mutex mut_;
+
+    bvar::Adder<int64_t> ops_{"ckpt_engine_meta_service", "write_ops"};
+    bvar::LatencyRecorder write_latency_{"ckpt_engine_meta_service", "write"};
+    bvar::LatencyRecorder load_latency_{"ckpt_engine_meta_service", "load"};
+    bvar::LatencyRecorder batch_load_latency_{"ckpt_engine_meta_service", "batch_load"};
+};
+} // namespace storage
@@ -0,0 +1,119 @@
+/**
+ * @file mysql_pool.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief bounded pool of mysql connections with prepared statements
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <bvar/bvar.h>
+
+#include "mysql/mysql.h"
+
+namespace storage {
+/**
+ * @brief statements prepared on every connection
+ */
+enum MysqlStatement {
+    STMT_SAVE = 0,
+    STMT_LOAD = 1,
+    STMT_UPDATE_STATE = 2,
+    STMT_DELETE = 3,
+    STMT_BATCH_LOAD = 4,
+    /* MYSQL_BATCH_ROWS rows */
+    STMT_BATCH_SAVE = 5,
+    STMT_BATCH_DELETE = 6,
+    STMT_BATCH_UPDATE_STATE = 7,
+    STMT_NUM = 8,
+};
+
+/**
+ * @brief a mysql connection with all statements prepared on it
+ */
+struct MysqlConnection {
+    MYSQL *sql = nullptr;
+    MYSQL_STMT *stmts[STMT_NUM] = {nullptr};
+
+    /* last time it was returned, a connection idle for long is pinged before use */
+    std::chrono::steady_clock::time_point last_used;
+
+    /* set when connection is lost, it's closed instead of being returned */
+    bool broken = false;
+};
+
+/**
+ * @brief thread-safe pool of at most ENV_KEY_MYSQL_POOL_SIZE connections, created on demand
+ * @details A connection idle for MYSQL_PING_IDLE_SECONDS is pinged before use, and reconnected if it's dead.
+ * Statements losing their connection are retried once on another one.
+ */
+class MysqlConnectionPool {
+public:
+    ~MysqlConnectionPool();
+    MysqlConnectionPool(const MysqlConnectionPool &) = delete;
+    MysqlConnectionPool(MysqlConnectionPool &&) = delete;
+    MysqlConnectionPool &operator=(const MysqlConnectionPool &) = delete;
+    MysqlConnectionPool &operator=(MysqlConnectionPool &&) = delete;
+
+    static MysqlConnectionPool &Instance() {
+        static std::unique_ptr<MysqlConnectionPool> instance_ptr_(new MysqlConnectionPool());
+        return *instance_ptr_;
+    }
+
+    /**
+     * @brief run fn with prepared statement on a pooled connection, latency is recorded per statement
+     * @param fn return status code, set connection broken if it's lost
+     * @return int status code of fn, STATUS_UNKNOWN_ERROR if no connection is available
+     */
+    int Run(MysqlStatement stmt, const std::function<int(MysqlConnection &, MYSQL_STMT *)> &fn);
+
+    /**
+     * @brief mark connection broken if last error of stmt means connection is lost
+     */
+    static void CheckLost(MysqlConnection &conn, MYSQL_STMT *stmt);
+
+private:
+    MysqlConnectionPool();
+
+    /**
+     * @brief take an idle connection or create one, blocking if the pool is exhausted
+     * @return nullptr if connecting fails
+     */
+    MysqlConnection *acquire();
+    void release(MysqlConnection *conn);
+
+    bool open(MysqlConnection *conn);
+    bool prepare(MysqlConnection *conn);
+    void close(MysqlConnection *conn);
+
+    void createTable(MysqlConnection *conn);
+
+    std::string db_addr_;
+    int db_port_;
+    std::string db_user_;
+    std::string db_password_;
+    std::string db_name_;
+
+    size_t capacity_;
+    size_t created_ = 0;
+    std::vector<MysqlConnection *> idle_;
+    std::mutex mut_;
+    std::condition_variable cv_;
+
+    std::unique_ptr<bvar::LatencyRecorder> latency_[STMT_NUM];
+    bvar::Adder<int64_t> reconnects_{"ckpt_engine_mysql", "reconnects"};
+    bvar::Adder<int64_t> waits_{"ckpt_engine_mysql", "pool_waits"};
+};
+} // namespace storage
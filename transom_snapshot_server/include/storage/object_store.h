@@ -0,0 +1,147 @@
+/**
+ * @file object_store.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief S3-compatible object store client
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "brpc/channel.h"
+
+#include "util/thread_pool.h"
+
+namespace storage {
+/**
+ * @brief connection and tuning of object store
+ */
+struct ObjectStoreConfig {
+    /* host:port, path-style addressing is used so that MinIO works without DNS */
+    std::string endpoint;
+    std::string region;
+    std::string bucket;
+    std::string access_key;
+    std::string secret_key;
+    size_t part_size;
+    size_t concurrency;
+};
+
+/**
+ * @brief S3 client on brpc http channel, requests are signed by AWS signature version 4
+ * @details Objects larger than a part are uploaded by multipart upload. Parts are sliced from caller's memory
+ * without copy and uploaded concurrently. Failed parts are retried, and if an upload still fails, its upload id and
+ * finished parts are kept, so that uploading the same key again only sends the missing parts and the parts whose
+ * content differs from their etag.
+ * Downloads are split into ranged GETs fetched concurrently.
+ */
+class S3Client {
+public:
+    /**
+     * @brief called before sending bytes, return false to abort
+     */
+    using Throttle = std::function<bool(size_t)>;
+
+    explicit S3Client(const ObjectStoreConfig &config);
+    virtual ~S3Client() = default;
+    S3Client(const S3Client &) = delete;
+    S3Client(S3Client &&) = delete;
+    S3Client &operator=(const S3Client &) = delete;
+    S3Client &operator=(S3Client &&) = delete;
+
+    /**
+     * @brief return false if channel cannot be initialized
+     */
+    bool Valid() const {
+        return valid_;
+    }
+
+    /**
+     * @brief upload data as an object
+     * @param key object key
+     * @param throttle called before sending a part with its size
+     * @return bool true: success
+     */
+    bool Upload(const std::string &key, const void *data, size_t size, const Throttle &throttle);
+
+    /**
+     * @brief download [offset, offset + size) of an object
+     * @param data where data stores, at least size bytes
+     * @return bool true: success
+     */
+    bool Download(const std::string &key, void *data, size_t size, size_t offset = 0);
+
+    /**
+     * @brief get object size
+     * @return bool false if object does not exist or request fails
+     */
+    bool Head(const std::string &key, size_t &size);
+
+    /**
+     * @brief delete an object
+     * @return bool true: success or not found
+     */
+    bool Delete(const std::string &key);
+
+protected:
+    /**
+     * @brief state of an unfinished multipart upload
+     */
+    struct MultipartUpload {
+        std::string upload_id;
+        size_t size;
+        size_t part_size;
+        /* etag of each part, empty if not uploaded yet */
+        std::vector<std::string> etags;
+    };
+
+    /**
+     * @brief send a part of multipart upload, overridden by tests to inject failures
+     * @param aborted set to true if throttle aborts the part
+     */
+    virtual bool uploadPart(const std::string &key, MultipartUpload &upload, size_t part, const char *data,
+                            const Throttle &throttle, bool &aborted);
+
+private:
+    /**
+     * @brief sign and send a request, response body is stored in cntl.response_attachment()
+     * @param query canonical query string without '?', keys must be sorted
+     * @return int http status code, 0 on network failure
+     */
+    int request(brpc::Controller &cntl, brpc::HttpMethod method, const std::string &key, const std::string &query);
+
+    /**
+     * @brief add AWS signature version 4 headers to request
+     */
+    void sign(brpc::Controller &cntl, const std::string &method, const std::string &path, const std::string &query);
+
+    bool putObject(const std::string &key, const void *data, size_t size, const Throttle &throttle);
+    bool createMultipartUpload(const std::string &key, MultipartUpload &upload);
+    bool completeMultipartUpload(const std::string &key, MultipartUpload &upload);
+
+    /**
+     * @brief return true if uploaded part has the same content as data, compared by md5 in its etag
+     */
+    static bool samePart(const MultipartUpload &upload, size_t part, const char *data);
+    void abortMultipartUpload(const std::string &key, const std::string &upload_id);
+
+    ObjectStoreConfig config_;
+    bool valid_ = false;
+    brpc::Channel channel_;
+    util::ThreadPool pool_;
+
+    /* unfinished uploads to resume, key -> upload */
+    std::map<std::string, MultipartUpload> pending_uploads_;
+    std::mutex mut_;
+};
+} // namespace storage
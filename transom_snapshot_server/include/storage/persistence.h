@@ -11,18 +11,56 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <vector>
 
+#include <bvar/bvar.h>
+
+#include "config/config.h"
 #include "logger/logger.h"
+#include "storage/compression.h"
+#include "storage/object_store.h"
+#include "storage/placement.h"
+#include "util/thread_pool.h"
 
 namespace storage {
+/**
+ * @brief stripe setting of files under a mount point
+ */
+struct StripeConfig {
+    std::string mount;
+    size_t stripe_size;
+    size_t concurrency;
+};
+
+/**
+ * @brief header of a manifest, followed by chunk_store_dir and SHA-256 digests of chunks
+ * @details a chunk is stored at chunk_store_dir/<first 2 hex of digest>/<hex of digest>, identical chunks
+ * across files and iterations are stored only once. The manifest of a checkpoint is written at
+ * <file name>.manifest. Chunks are reference counted by hard links in chunk_store_dir/refs/<hash of manifest path
+ * and content>, a chunk whose link count drops to 1 is referenced by no manifest and removed.
+ */
+struct ChunkManifestHeader {
+    char magic[8];
+    uint64_t size;
+    uint64_t chunk_size;
+    uint64_t chunk_count;
+    uint64_t dir_length;
+};
+
 /**
  * @brief persistent module
  */
 class Persistence {
 public:
-    Persistence() = default;
+    Persistence();
     Persistence(const Persistence &) = delete;
     Persistence(Persistence &&) = delete;
     Persistence &operator=(const Persistence &) = delete;
@@ -34,24 +72,277 @@ public:
     }
 
     /**
-     * @brief dump to file storage or local file system
+     * @brief dump to file storage or local file system, using engine configured by user
      * @param file_name file name to persistent
      * @param data binary data
      * @param size data size
+     * @param memfd memfd backing data, -1 if unknown. Required by zerocopy engine
      * @return bool true: success
      */
-    bool WriteToDisk(std::string &file_name, const void *data, size_t size);
+    bool WriteToDisk(std::string &file_name, const void *data, size_t size, int memfd = -1);
 
     /**
-     * @brief dump to SSO
+     * @brief load a persisted file into memory, from the newest of the plain file and the ones written beside it,
+     * e.g. reassembled from chunk store by its manifest
+     * @param file_name file name persisted
+     * @param data where data stores, at least size bytes
+     * @param size data size
+     * @return bool true: success
+     */
+    bool ReadFromDisk(const std::string &file_name, void *data, size_t size);
+
+    /**
+     * @brief load [offset, offset + length) of a persisted file, only frames covering the range are
+     * decompressed if it's compressed. Manifests of incremental persistence are not supported
+     * @param data where data stores, at least length bytes
      * @return bool true: success
      */
-    bool WriteToSSO() {
-        LOG_FATAL("persistent to SSO not implemented");
-        return true;
+    bool ReadRangeFromDisk(const std::string &file_name, size_t offset, size_t length, void *data);
+
+    /**
+     * @brief abort an in-flight WriteToDisk or WriteToSSO of file_name, the write returns false soon
+     * @return bool false if file_name is not being written, the abort is kept and the next write of file_name
+     * returns false at once, until Forget is called
+     */
+    bool Abort(const std::string &file_name);
+
+    /**
+     * @brief drop an abort of file_name kept for a write not begun, called when the task persisting it ends
+     */
+    void Forget(const std::string &file_name);
+
+    /**
+     * @brief return true if object store is configured, checkpoints should be persisted by WriteToSSO then
+     */
+    bool SSOEnabled() const {
+        return sso_client_ != nullptr;
     }
 
+    /**
+     * @brief dump to SSO as multipart upload, parts are sliced from data and uploaded concurrently. If it fails,
+     * writing the same file again resumes from the failed parts
+     * @param file_name file name to persistent, object key is prefix + file_name
+     * @param data binary data
+     * @param size data size
+     * @return bool true: success
+     */
+    bool WriteToSSO(std::string &file_name, const void *data, size_t size);
+
+    /**
+     * @brief load an object from SSO by concurrent ranged requests
+     * @param file_name file name persisted
+     * @param data where data stores, at least size bytes
+     * @param size data size
+     * @return bool true: success
+     */
+    bool ReadFromSSO(const std::string &file_name, void *data, size_t size);
+
 private:
-    /* user configuration, e.g. AK/SK */
+    /**
+     * @brief dispatch a write to engines
+     */
+    bool writeToDisk(std::string &file_name, const void *data, size_t size, int memfd);
+
+    /**
+     * @brief register file_name as being written, so that it can be aborted
+     * @return bool false if file_name has been aborted before
+     */
+    bool begin(const std::string &file_name);
+
+    /**
+     * @brief unregister file_name
+     */
+    void end(const std::string &file_name, bool ok);
+
+    /**
+     * @brief wait for bandwidth budget before writing len bytes of file_name
+     * @return bool false if the write is aborted
+     */
+    bool throttle(const std::string &file_name, size_t len);
+
+    /**
+     * @brief buffered write through stdio, data goes through page cache
+     */
+    bool writeStdio(std::string &file_name, const void *data, size_t size);
+
+    /**
+     * @brief write with O_DIRECT through io_uring, keeping at most uring_queue_depth_ writes in flight.
+     * The unaligned tail is padded to a full block and truncated afterwards.
+     * @param fallback set to true if io_uring or O_DIRECT is unavailable, caller should use buffered write instead
+     * @return bool true: success
+     */
+    bool writeUring(std::string &file_name, const void *data, size_t size, bool &fallback);
+
+    /**
+     * @brief copy from memfd to file inside kernel, try copy_file_range first and sendfile next
+     * @param fallback set to true if neither is supported, caller should use buffered write instead
+     * @return bool true: success
+     */
+    bool writeZeroCopy(std::string &file_name, int memfd, size_t size, bool &fallback);
+
+    /**
+     * @brief split data into stripes and pwrite them concurrently into a temporary file,
+     * then fsync and rename it to file_name, so readers never see a half-written file
+     * @return bool true: success
+     */
+    bool writeStriped(std::string &file_name, const void *data, size_t size);
+
+    /**
+     * @brief hash data by fixed-size chunks, write chunks absent from chunk store and then the manifest
+     * @return bool true: success
+     */
+    bool writeIncremental(std::string &file_name, const void *data, size_t size);
+
+    /**
+     * @brief paths file_name may be persisted as: plain, manifest or compressed
+     */
+    static std::vector<std::string> persistedForms(const std::string &file_name);
+
+    /**
+     * @brief path file_name is persisted as in current mode
+     */
+    std::string persistedPath(const std::string &file_name);
+
+    /**
+     * @brief path of the newest persisted form of file_name, either itself or a file written beside it
+     */
+    std::string locate(const std::string &file_name);
+
+    /**
+     * @brief remove persisted forms of file_name other than kept, so that none of them is stale
+     */
+    void retire(const std::string &file_name, const std::string &kept);
+
+    /**
+     * @brief flock chunk store, writers share it and collecting chunks takes it exclusively
+     * @return int fd holding the lock, -1 if it fails
+     */
+    int lockChunkStore(int operation);
+
+    /**
+     * @brief directory of hard links to chunks referenced by manifest content published at owner
+     */
+    std::string refDir(const std::string &owner, const std::string &manifest);
+
+    /**
+     * @brief drop hard links of ref directory and remove chunks referenced no more. Chunk store is locked exclusively
+     */
+    void releaseRefs(const std::string &dir);
+
+    /**
+     * @brief release refs not matching the manifest published at their owner, then remove unreferenced chunks
+     */
+    void collectChunks();
+
+    /**
+     * @brief read [offset, offset + length) of a plain file by concurrent preads of read_chunk_size_
+     * @param fd opened file
+     * @return bool true: success
+     */
+    bool readPlain(const std::string &file_name, int fd, size_t offset, size_t length, void *data);
+
+    /**
+     * @brief read chunks listed in manifest concurrently and verify their digests
+     * @param fd opened manifest
+     * @return bool true: success
+     */
+    bool readManifest(const std::string &file_name, int fd, void *data, size_t size);
+
+    /**
+     * @brief pool to hash, compress and load chunks or frames, created on first use
+     */
+    util::ThreadPool &workerPool();
+
+    /**
+     * @brief placement of configured directories, or a reader created on first use if not configured
+     */
+    DevicePlacement &placementReader();
+
+    /**
+     * @brief find stripe setting of the longest mount point prefixing file_name
+     */
+    const StripeConfig &stripeConfig(const std::string &file_name);
+
+    /**
+     * @brief log throughput of a finished write, so that engines are comparable on the same device
+     */
+    void report(const char *engine, std::string &file_name, size_t size,
+                std::chrono::high_resolution_clock::time_point start_time);
+
+    /**
+     * @brief object key of a persisted file
+     */
+    std::string objectKey(const std::string &file_name);
+
+    /* engine to write to disk */
+    std::string engine_;
+
+    /* max in-flight writes of io_uring engine */
+    unsigned uring_queue_depth_;
+
+    /* size of a single io_uring write, multiple of DIRECT_IO_ALIGNMENT */
+    size_t uring_block_size_;
+
+    /* per mount point stripe settings, the last one is the default matching any path */
+    std::vector<StripeConfig> stripe_configs_;
+
+    /* shared by all striped writes, sized by the max concurrency of stripe settings */
+    std::unique_ptr<util::ThreadPool> stripe_pool_;
+
+    /* directory of chunk store, empty means incremental persistence is disabled */
+    std::string chunk_store_dir_;
+
+    /* size of a chunk in incremental persistence */
+    size_t chunk_size_;
+
+    /* last time unreferenced chunks were collected, seconds of steady clock */
+    std::atomic<int64_t> last_collect_{0};
+    std::mutex collect_mut_;
+
+    /* size of each concurrent pread of a plain file */
+    size_t read_chunk_size_;
+
+    std::once_flag worker_pool_once_;
+    std::unique_ptr<util::ThreadPool> worker_pool_;
+
+    /* compress persisted files if configured */
+    std::unique_ptr<SeekableZstd> compressor_;
+
+    /* spread stripes across devices if configured */
+    std::unique_ptr<DevicePlacement> placement_;
+
+    std::once_flag placement_reader_once_;
+    std::unique_ptr<DevicePlacement> placement_reader_;
+
+    /* bytes of chunks written into store */
+    bvar::Adder<int64_t> chunk_new_bytes_{"ckpt_engine_persist", "chunk_new_bytes"};
+
+    /* bytes of chunks removed since referenced by no manifest */
+    bvar::Adder<int64_t> chunk_collected_bytes_{"ckpt_engine_persist", "chunk_collected_bytes"};
+
+    /* bytes of chunks already in store, skipped */
+    bvar::Adder<int64_t> chunk_dedup_bytes_{"ckpt_engine_persist", "chunk_dedup_bytes"};
+
+    /* bytes copied from user space buffer, by stdio and striped engine */
+    bvar::Adder<int64_t> user_copy_bytes_{"ckpt_engine_persist", "user_copy_bytes"};
+
+    /* bytes transferred inside kernel by zerocopy engine */
+    bvar::Adder<int64_t> kernel_copy_bytes_{"ckpt_engine_persist", "kernel_copy_bytes"};
+
+    /* bytes written by O_DIRECT, bypassing page cache */
+    bvar::Adder<int64_t> direct_io_bytes_{"ckpt_engine_persist", "direct_io_bytes"};
+
+    /* file being written -> abort requested */
+    std::map<std::string, bool> writing_;
+
+    /* files aborted before their writes begin */
+    std::set<std::string> aborted_;
+    std::mutex writing_mut_;
+
+    /* object store client, null if not configured */
+    std::unique_ptr<S3Client> sso_client_;
+
+    /* prefix of object keys */
+    std::string sso_prefix_;
 };
 } // namespace storage
\ No newline at end of file
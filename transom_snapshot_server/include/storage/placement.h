@@ -0,0 +1,140 @@
+/**
+ * @file placement.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief stripe files across directories on multiple devices
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <bvar/bvar.h>
+
+#include "util/thread_pool.h"
+
+namespace storage {
+/**
+ * @brief header of a placement index, followed by stripe name, directories and the directory index of each stripe
+ * @details stripe i is stored at <directory of stripe i>/<stripe name>.<i>. Directories are recorded in the index,
+ * so files stay readable after the configuration changes. Stripe name carries the generation of its write, so a
+ * rewrite never touches stripes of the published index
+ */
+struct PlacementIndexHeader {
+    char magic[8];
+    uint64_t size;
+    uint64_t stripe_size;
+    uint64_t stripe_count;
+    uint64_t name_length;
+    uint64_t dir_count;
+};
+
+/**
+ * @brief spread stripes of files across directories, each directory is expected to be on its own device
+ * @details Stripes of a file start from a directory chosen by hash of file name and go round robin, so small files
+ * are spread as well. Every directory has its own workers, so a slow device does not hold up the others.
+ */
+class DevicePlacement {
+public:
+    /**
+     * @param dirs directories on different devices, empty for a reader of indexes written before
+     * @param stripe_size bytes of a stripe
+     * @param concurrency concurrent stripes per directory
+     */
+    DevicePlacement(const std::vector<std::string> &dirs, size_t stripe_size, size_t concurrency);
+    DevicePlacement(const DevicePlacement &) = delete;
+    DevicePlacement(DevicePlacement &&) = delete;
+    DevicePlacement &operator=(const DevicePlacement &) = delete;
+    DevicePlacement &operator=(DevicePlacement &&) = delete;
+
+    /**
+     * @brief write stripes of a new generation and then the placement index at file_name, stripes of the previous
+     * index are removed once the new index replaces it
+     * @param throttle called before writing a stripe with its size, return false to abort
+     * @return bool true: success
+     */
+    bool Write(const std::string &file_name, const void *data, size_t size,
+               const std::function<bool(size_t)> &throttle);
+
+    /**
+     * @brief remove placement index at file_name and its stripes
+     * @return bool true: file_name was a placement index and is removed
+     */
+    static bool Remove(const std::string &file_name);
+
+    /**
+     * @brief return true if fd starts with placement index magic
+     */
+    static bool Detect(int fd);
+
+    /**
+     * @brief read [offset, offset + length) of original data, stripes are read from all devices concurrently
+     * @param fd opened placement index
+     * @param data where data stores, at least length bytes
+     * @return bool true: success
+     */
+    bool Read(const std::string &file_name, int fd, size_t offset, size_t length, void *data);
+
+private:
+    /**
+     * @brief a directory and its statistics
+     */
+    struct Device {
+        std::string dir;
+        std::unique_ptr<util::ThreadPool> pool;
+        bvar::Adder<int64_t> write_bytes;
+        bvar::Adder<int64_t> read_bytes;
+
+        /* stripes submitted and not finished */
+        bvar::Adder<int64_t> queue_depth;
+        std::unique_ptr<bvar::PerSecond<bvar::Adder<int64_t>>> write_throughput;
+        std::unique_ptr<bvar::PerSecond<bvar::Adder<int64_t>>> read_throughput;
+    };
+
+    /**
+     * @brief parsed placement index
+     */
+    struct Index {
+        uint64_t size;
+        uint64_t stripe_size;
+        std::string name;
+        std::vector<std::string> dirs;
+
+        /* directory index of each stripe */
+        std::vector<uint32_t> placement;
+
+        std::string StripePath(size_t i) const {
+            return dirs[placement[i]] + "/" + name + "." + std::to_string(i);
+        }
+    };
+
+    /**
+     * @brief parse placement index from fd
+     */
+    static bool readIndex(const std::string &file_name, int fd, Index &index);
+
+    /**
+     * @brief remove stripes of index, missing ones are skipped
+     */
+    static void removeStripes(const Index &index);
+
+    /**
+     * @brief device of directory, nullptr if it's not configured any more
+     */
+    Device *device(const std::string &dir);
+
+    size_t stripe_size_;
+    std::vector<std::unique_ptr<Device>> devices_;
+
+    /* reads stripes in directories not configured */
+    util::ThreadPool fallback_pool_;
+};
+} // namespace storage
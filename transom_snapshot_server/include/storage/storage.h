@@ -11,8 +11,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 
@@ -51,13 +55,39 @@ public:
     bool Save(api::Metadata metadata, api::DataEntry entry);
 
     /**
-     * @brief load data entry from storage
+     * @brief load data entry from storage, a spilled one is read back from cold tier into a new memfd
      * @param metadata file name is required
      * @param entry where queried data stores
      * @return bool true: success
      */
     bool Load(api::Metadata &metadata, api::DataEntry &entry);
 
+    /**
+     * @brief return true if data entry exists, no matter in memory or cold tier
+     * @param metadata file name is required
+     */
+    bool Contains(const api::Metadata &metadata);
+
+    /**
+     * @brief spill data entry to cold tier and release its memory, it stays in storage and is read back on next load
+     * @details caller makes sure nothing reads its memory, e.g. backup and persistence have finished
+     * @param metadata file name is required
+     * @return bool true: success
+     */
+    bool Spill(const api::Metadata &metadata);
+
+    /**
+     * @brief spill idle data entries of the oldest iteration first, then least recently used, until enough bytes of
+     * memory are released. Entries not backed up, being persisted or accessed recently are skipped
+     * @return size_t bytes released
+     */
+    size_t Reclaim(size_t bytes);
+
+    /**
+     * @brief bytes of memory held by primary data entries of each iteration, spilled ones excluded
+     */
+    std::map<int64_t, size_t> IterationBytes();
+
     /**
      * @brief delete record from storage, it it's a backup cache, free memory
      * @param metadata file name is required
@@ -65,6 +95,16 @@ public:
      */
     bool Delete(api::Metadata &metadata);
 
+    /**
+     * @brief mark a file as restored by bootstrap, it's served before bootstrap of other files completes
+     */
+    void MarkRestored(const std::string &file_name);
+
+    /**
+     * @brief return true if the file has been restored by bootstrap
+     */
+    bool Restored(const std::string &file_name);
+
     /**
      * @brief get _dict's constant reference
      */
@@ -76,8 +116,53 @@ public:
     const std::map<std::string, api::DataEntry> &getBackupDict() const;
 
 private:
+    /**
+     * @brief what cold tier needs to know about a data entry
+     */
+    struct Residency {
+        int64_t iteration = -1;
+
+        /* mapped size */
+        size_t size = 0;
+        bool primary = true;
+        bool spilling = false;
+
+        /* updated by loads under shared lock */
+        std::atomic<int64_t> access_ms{0};
+        std::atomic<uint64_t> accesses{0};
+    };
+
+    /**
+     * @brief spilled data entry keeps its place in dict with address 0
+     */
+    static bool cold(const api::DataEntry &entry) {
+        return entry.address == 0;
+    }
+
+    /**
+     * @brief data entry of file_name in dict or backup dict, nullptr if not found, lock must be held
+     */
+    api::DataEntry *find(const std::string &file_name);
+
+    void touch(const std::string &file_name);
+
+    /**
+     * @brief hand memory of a deleted entry to memfd pool, lock must be held
+     * @return bool false if pool does not take it
+     */
+    bool recycle(const api::Metadata &metadata, const api::DataEntry &entry);
+
+    /**
+     * @param idle_only skip entries accessed recently
+     */
+    bool spill(const std::string &file_name, bool idle_only);
+    bool rehydrate(api::Metadata &metadata, api::DataEntry &entry);
+
     std::map<std::string, api::DataEntry> dict_;
     std::map<std::string, api::DataEntry> backup_dict_;
+    std::map<std::string, Residency> residency_;
+    std::set<std::string> restored_;
+    std::mutex restored_mut_;
     inline static std::shared_mutex rw_mutex_ = {};
 };
 } // namespace storage
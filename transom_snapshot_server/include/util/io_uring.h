@@ -0,0 +1,108 @@
+/**
+ * @file io_uring.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief a minimal io_uring wrapper built on raw syscalls
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/types.h>
+
+#include <cstdint>
+
+namespace util {
+/**
+ * @brief a single-threaded io_uring instance, only read and write are supported
+ * @details liburing is not a dependency of this project, so rings are set up by syscalls directly.
+ * An instance must not be shared between threads, create one per task instead.
+ */
+class IoUring {
+public:
+    /**
+     * @brief setup ring with given depth, check Valid() afterwards since kernel may not support io_uring
+     * @param entries submission queue depth
+     */
+    explicit IoUring(unsigned entries);
+    ~IoUring();
+    IoUring(const IoUring &) = delete;
+    IoUring(IoUring &&) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+    IoUring &operator=(IoUring &&) = delete;
+
+    /**
+     * @brief return true if ring is successfully set up
+     */
+    bool Valid() const {
+        return ring_fd_ >= 0;
+    }
+
+    /**
+     * @brief queue a write request, it's not submitted until Submit() is called
+     * @param fd file descriptor
+     * @param buf data to write
+     * @param len bytes to write
+     * @param offset file offset
+     * @param user_data returned in completion to identify the request
+     * @return bool false if submission queue is full
+     */
+    bool PrepareWrite(int fd, const void *buf, unsigned len, off_t offset, uint64_t user_data);
+
+    /**
+     * @brief queue a read request, it's not submitted until Submit() is called
+     * @param fd file descriptor
+     * @param buf where read data stores
+     * @param len bytes to read
+     * @param offset file offset
+     * @param user_data returned in completion to identify the request
+     * @return bool false if submission queue is full
+     */
+    bool PrepareRead(int fd, void *buf, unsigned len, off_t offset, uint64_t user_data);
+
+    /**
+     * @brief submit all queued requests to kernel
+     * @return int number of submitted requests, negative errno on failure
+     */
+    int Submit();
+
+    /**
+     * @brief blocking method, wait for one completion
+     * @param user_data user_data of the completed request
+     * @param res result of the request, bytes transferred or negative errno
+     * @return int 0 on success, negative errno on failure
+     */
+    int WaitCompletion(uint64_t &user_data, int &res);
+
+private:
+    bool prepare(int opcode, int fd, const void *buf, unsigned len, off_t offset, uint64_t user_data);
+
+    int ring_fd_ = -1;
+    unsigned entries_ = 0;
+    unsigned to_submit_ = 0;
+
+    /* mapped regions */
+    void *sq_ptr_ = nullptr;
+    size_t sq_size_ = 0;
+    void *cq_ptr_ = nullptr;
+    size_t cq_size_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    /* submission queue */
+    unsigned *sq_head_ = nullptr;
+    unsigned *sq_tail_ = nullptr;
+    unsigned *sq_mask_ = nullptr;
+    unsigned *sq_array_ = nullptr;
+
+    /* completion queue */
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned *cq_mask_ = nullptr;
+    io_uring_cqe *cqes_ = nullptr;
+};
+} // namespace util
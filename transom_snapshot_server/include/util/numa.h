@@ -0,0 +1,81 @@
+/**
+ * @file numa.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief NUMA topology, memory policy and thread affinity
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <sched.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+namespace util {
+/**
+ * @brief NUMA helpers by syscalls and sysfs, libnuma is not required
+ */
+class Numa {
+public:
+    /**
+     * @brief return true unless policy is off or there is a single node
+     */
+    static bool Enabled();
+
+    /**
+     * @brief ids of online nodes, read once
+     */
+    static const std::vector<int> &Nodes();
+
+    /**
+     * @brief cpus of node, empty if unknown
+     */
+    static std::vector<int> Cpus(int node);
+
+    /**
+     * @brief node holding all cpus the process may run on, -1 if they span nodes or unknown
+     */
+    static int NodeOfPid(pid_t pid);
+
+    /**
+     * @brief set memory policy of [addr, addr + len) to node, shared memory applies it to the file itself
+     * @param move migrate pages faulted already
+     * @return bool false on failure or if disabled
+     */
+    static bool Bind(void *addr, size_t len, int node, bool move);
+
+    /**
+     * @brief read MemTotal and MemFree of node
+     */
+    static bool Meminfo(int node, size_t &total, size_t &free);
+
+    /**
+     * @brief parse cpu or node list like "0-3,8,10-11"
+     */
+    static std::vector<int> ParseList(const std::string &list);
+};
+
+/**
+ * @brief run calling thread on cpus of node and allocate its memory there, restored on destruction.
+ * Nothing happens if node is negative or NUMA is disabled
+ */
+class NumaAffinity {
+public:
+    explicit NumaAffinity(int node);
+    ~NumaAffinity();
+    NumaAffinity(const NumaAffinity &) = delete;
+    NumaAffinity(NumaAffinity &&) = delete;
+    NumaAffinity &operator=(const NumaAffinity &) = delete;
+    NumaAffinity &operator=(NumaAffinity &&) = delete;
+
+private:
+    bool pinned_ = false;
+    cpu_set_t saved_;
+};
+} // namespace util
@@ -0,0 +1,88 @@
+/**
+ * @file thread_pool.h
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief a fixed-size thread pool built on channel
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "util/channel.h"
+
+namespace util {
+/**
+ * @brief workers consume tasks from a shared channel until the pool is destroyed
+ */
+class ThreadPool {
+public:
+    /**
+     * @param threads number of workers, at least 1
+     */
+    explicit ThreadPool(size_t threads) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        for (size_t i = 0; i < threads; i++) {
+            workers_.emplace_back([this]() {
+                for (auto task : tasks_) {
+                    /* multiple consumers may wake up for one task, the loser gets an empty one */
+                    if (task) {
+                        task();
+                    }
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief close the channel and wait for queued tasks to finish
+     */
+    ~ThreadPool() {
+        tasks_.close();
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ThreadPool &operator=(ThreadPool &&) = delete;
+
+    /**
+     * @brief enqueue a task, never blocks
+     * @return std::future holding the result of task
+     */
+    template <typename F>
+    auto Submit(F &&f) -> std::future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        /* std::function requires copyable callable */
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        auto future = task->get_future();
+        std::function<void()>([task]() { (*task)(); }) >> tasks_;
+        return future;
+    }
+
+    /**
+     * @brief number of workers
+     */
+    size_t Size() const {
+        return workers_.size();
+    }
+
+private:
+    channel<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+};
+} // namespace util
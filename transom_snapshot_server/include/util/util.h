@@ -103,6 +103,39 @@ public:
      */
     static int memfdFtruncate(api::Metadata &metadata, api::DataEntry &entry);
 
+    /**
+     * @brief bytes memfdCalloc may take for size, rounded up to huge page size when hugetlb is configured
+     */
+    static size_t MemfdReserveSize(size_t size);
+
+    /**
+     * @brief bytes mapped for a memfd allocated for size, which is rounded up to huge page size on hugetlbfs
+     */
+    static size_t MemfdMappedSize(int memfd, size_t size);
+
+    /**
+     * @brief default huge page size, 0 if unknown
+     */
+    static size_t HugePageSize();
+
+    /**
+     * @brief madvise MADV_HUGEPAGE on a mapping of memfd unless huge pages are off. THP of shmem is decided by the
+     * mapping which faults a page, so every mapping faulting checkpoint memory must be advised
+     */
+    static void AdviseHugePage(void *address, size_t length);
+
+    /**
+     * @brief pwrite until all data is written, retry on EINTR
+     * @return bool false on failure, errno is set
+     */
+    static bool PwriteAll(int fd, const char *data, size_t size, off_t offset);
+
+    /**
+     * @brief pread until size bytes are read, retry on EINTR
+     * @return bool false on failure or reaching end of file, errno is set
+     */
+    static bool PreadAll(int fd, char *data, size_t size, off_t offset);
+
     /**
      * @brief base64 encode
      */
@@ -100,7 +100,8 @@ std::string DataEntry::String() {
     std::stringstream ss;
     ss << "Address " << reinterpret_cast<void *>(address)
        << " pid " << pid
-       << " memfd " << memfd;
+       << " memfd " << memfd
+       << " numa_node " << numa_node;
     return ss.str();
 }
 
@@ -187,6 +188,19 @@ void BatchLoadFilter::Unmarshal(Buffer &buffer) {
     state = buffer.Get<CheckpointState>();
 }
 
+bool BatchLoadFilter::Match(const Metadata &metadata) const {
+    if (node_rank >= 0 && node_rank != metadata.node_rank) {
+        return false;
+    }
+    if (!iteration.empty() && iteration != metadata.iteration) {
+        return false;
+    }
+    if (state >= api::CheckpointState::PENDING && state < api::CheckpointState::STATE_NUM && state != metadata.state) {
+        return false;
+    }
+    return true;
+}
+
 std::string BatchLoadFilter::String() {
     std::stringstream ss;
     if (node_rank >= 0) {
@@ -14,6 +14,8 @@
 #include "logger/logger.h"
 #include "monitor/monitor.h"
 #include "operator/operator.h"
+#include "storage/eviction.h"
+#include "storage/metadata_cache.h"
 
 int main(int argc, char **argv) {
     logger::Logger::InitLogger();
@@ -22,6 +24,9 @@ int main(int argc, char **argv) {
     /* start memory monitor */
     monitor::MemoryMonitor::Instance().Start();
 
+    /* serve metadata of current node from memory, before anyone reads it */
+    storage::MetadataCache::Instance().Start();
+
     /* start a operator for reconciliation */
     auto controller = std::make_shared<operators::Operator>();
     controller->SetHandler(coordinator::Coordinator::Reconcile);
@@ -36,6 +41,9 @@ int main(int argc, char **argv) {
 
     /* mark backend as ready, which means coordinator finishes bootstraping */
     backend->MarkReady();
+
+    /* evict cached iterations in background, after bootstrap restores them */
+    storage::Evictor::Instance().Start();
     backend->Serve();
     return 0;
 }
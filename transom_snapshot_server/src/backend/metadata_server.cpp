@@ -0,0 +1,40 @@
+/**
+ * @file metadata_server.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief standalone metadata service, serving metadata clients of type transom
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "brpc/server.h"
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "storage/metadata_service.h"
+#include "util/util.h"
+
+int main(int argc, char **argv) {
+    logger::Logger::InitLogger();
+    logging::SetMinLogLevel(logging::LOG_NUM_SEVERITIES);
+
+    auto port = std::atoi(util::Util::GetEnv(config::ENV_KEY_META_SERVICE_PORT,
+                                             config::DEFAULT_META_SERVICE_PORT).c_str());
+    auto dir = util::Util::GetEnv(config::ENV_KEY_META_SERVICE_DIR, config::DEFAULT_META_SERVICE_DIR);
+    auto shards = std::stoul(util::Util::GetEnv(config::ENV_KEY_META_SERVICE_SHARDS,
+                                                config::DEFAULT_META_SERVICE_SHARDS));
+    storage::MetadataServiceImpl service(dir, shards);
+
+    brpc::Server server;
+    if (server.AddService(&service, brpc::SERVER_DOESNT_OWN_SERVICE) != 0) {
+        LOG_FATAL("Fail to add metadata service: {}", strerror(errno));
+    }
+    if (server.Start(port, nullptr) != 0) {
+        LOG_FATAL("Fail to start metadata server: {}", strerror(errno));
+    }
+    LOG_INFO("metadata server listens on {}", port);
+    server.Join();
+    return 0;
+}
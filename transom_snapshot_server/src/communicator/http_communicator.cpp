@@ -42,7 +42,12 @@ HttpCommunicator::HttpCommunicator(Endpoint ep, std::shared_ptr<operators::Opera
                            "/updateMetadata   => updateMetadata,"
                            "/getMetadata      => getMetadata,"
                            "/getAllMetadata   => getAllMetadata,"
-                           "/getAllStorage    => getAllStorage,")
+                           "/getAllStorage    => getAllStorage,"
+                           "/getBandwidth     => getBandwidth,"
+                           "/setBandwidth     => setBandwidth,"
+                           "/getPins          => getPins,"
+                           "/pinIteration     => pinIteration,"
+                           "/unpinIteration   => unpinIteration,")
         != 0) {
         LOG_FATAL("Fail to add http_svc: {}", strerror(errno));
     }
@@ -13,6 +13,7 @@
 
 #include "api/api.h"
 #include "config/config.h"
+#include "operator/bandwidth_limiter.h"
 #include "util/nic_helper.h"
 #include "util/util.h"
 
@@ -758,11 +759,17 @@ bool RdmaCommunicator::rdma_write(const char *buffer, size_t local_addr_offset,
         memcpy(reinterpret_cast<void *>(local_addr), buffer, size);
     }
 
-    // write data by chunk
+    // write data by chunk, use smaller chunk when throttled
+    auto &limiter = operators::BandwidthLimiter::Instance();
+    bool throttled = limiter.GetRate(operators::TrafficStage::BACKUP) > 0
+                     || limiter.GetRate(operators::TrafficStage::NODE) > 0;
+    size_t chunk_size = throttled ? config::BANDWIDTH_CHUNK_SIZE : config::RDMA_CHUNK_SIZE;
     int completions = 0;
+    int polled = 0;
     size_t written = 0;
     while (written < size) {
-        auto to_write = size - written > config::RDMA_CHUNK_SIZE ? config::RDMA_CHUNK_SIZE : size - written;
+        auto to_write = size - written > chunk_size ? chunk_size : size - written;
+        limiter.Acquire(operators::TrafficStage::BACKUP, to_write);
         if (post_send(IBV_WR_RDMA_WRITE, local_addr + written, remote_addr + written, to_write) != 0) {
             LOG_ERROR("post_send IBV_WR_RDMA_WRITE failed");
             return false;
@@ -770,12 +777,21 @@ bool RdmaCommunicator::rdma_write(const char *buffer, size_t local_addr_offset,
         // LOG_TRACE("{}'the iter write {} data", completions, to_write);
         completions++;
         written += to_write;
+
+        // small chunks may overflow completion queue
+        while (completions - polled >= config::RDMA_MAX_INFLIGHT_WRITES) {
+            if (poll_completion() != 0) {
+                LOG_ERROR("{}'th poll completion failed", polled);
+                return false;
+            }
+            polled++;
+        }
     }
 
     // poll completions
-    for (auto i = 0; i < completions; i++) {
+    for (; polled < completions; polled++) {
         if (poll_completion() != 0) {
-            LOG_ERROR("{}'th poll completion failed", completions);
+            LOG_ERROR("{}'th poll completion failed", polled);
             return false;
         }
     }
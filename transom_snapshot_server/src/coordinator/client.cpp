@@ -11,8 +11,14 @@
 
 #include "coordinator/client.h"
 
+#include <algorithm>
+#include <set>
+
 #include "config/iteration_manager.h"
+#include "coordinator/restorer.h"
 #include "monitor/monitor.h"
+#include "operator/persist_queue.h"
+#include "storage/metadata_cache.h"
 #include "util/channel.h"
 #include "util/util.h"
 
@@ -26,11 +32,19 @@ using config::WorldState;
 using storage::Storage;
 using monitor::MemoryMonitor;
 using config::IterationManager;
+using coordinator::Restorer;
 
 bool ClientUtil::Backup(api::InterNodeBackupRequest &req, api::InterNodeBackupResponse &rsp) {
     LOG_TRACE("begin of inter-node backup request");
     buffer::Buffer buffer;
 
+    /* next node reads state of the file from database when it's notified, e.g. OBSOLESCENT, flush cached writes
+     * first or it acts on a stale row */
+    if (!storage::MetadataCache::Instance().Flush()) {
+        LOG_ERROR("flush metadata before backup of {} failed", req.metadata.file_name);
+        return false;
+    }
+
     /* init communicator */
     auto ep = EndpointFactory::getEndpoint(config::COMM_TYPE_RDMA);
     std::string nextHostAddr;
@@ -178,7 +192,8 @@ bool ClientUtil::LoadRemote(api::InterNodeLoadRequest &req, api::InterNodeLoadRe
 
     /* rdma handshake, now we have both local address and server side address */
     api::DataEntry entry;
-    if (auto rc = MemoryMonitor::Instance().TryMemfdMalloc(std::ref(rsp.metadata), std::ref(entry));
+    if (auto rc = MemoryMonitor::Instance().TryMemfdMalloc(std::ref(rsp.metadata), std::ref(entry),
+                                                           monitor::MEMORY_RESTORE);
         !api::IsSuccess(rc)) {
         LOG_ERROR("memfdCalloc failed");
         return false;
@@ -205,6 +220,7 @@ bool ClientUtil::LoadRemote(api::InterNodeLoadRequest &req, api::InterNodeLoadRe
         LOG_ERROR("notify server rdma_write finishes");
         return false;
     }
+    Storage::Instance().MarkRestored(rsp.metadata.file_name);
 
     LOG_TRACE("end of inter-node load request");
     return true;
@@ -214,6 +230,11 @@ bool ClientUtil::BatchLoadRemote(api::InterNodeBatchLoadRequest &req, api::Inter
     LOG_TRACE("begin of inter-node batch-load request");
     buffer::Buffer buffer;
 
+    /* next node lists files of current node from database */
+    if (!storage::MetadataCache::Instance().Flush()) {
+        LOG_WARN("flush metadata before batch-load failed, next node may see stale files");
+    }
+
     /* init communicator */
     auto ep = EndpointFactory::getEndpoint(config::COMM_TYPE_RDMA);
     std::string remoteIP;
@@ -336,28 +357,33 @@ bool ClientUtil::BatchLoadFromFileSystem() {
         LOG_ERROR("get AllMetadata failed");
         return false;
     }
+    vec.erase(std::remove_if(vec.begin(), vec.end(), [](const api::Metadata &metadata) {
+        return metadata.state == api::CheckpointState::OBSOLESCENT;
+    }), vec.end());
 
+    // recover _lastIteration and _totalIteration, oldest iteration at front
+    std::set<size_t> iterations;
     for (auto &metadata : vec) {
-        if (metadata.state == api::CheckpointState::OBSOLESCENT) {
-            continue;
+        auto iteration = operators::PersistTask::ParseIteration(metadata.iteration);
+        if (iteration != operators::PersistTask::UNKNOWN_ITERATION) {
+            iterations.insert(iteration);
         }
-        // recover _lastIteration and _totalIteration
-        auto iteration = metadata.iteration;
-        if (iteration != "unknown" && !IterationManager::Instance().isExist(std::stoul(iteration))) {
-            IterationManager::Instance().pushIteration(std::stoul(iteration));
-        }
-        api::DataEntry entry;
-        auto rc = MemoryMonitor::Instance().TryLoadFromFile(std::ref(metadata), std::ref(entry));
-        if (!api::IsSuccess(rc)) {
-            LOG_ERROR("memfdCalloc failed");
-            return false;
-        }
-        if (!storage::Storage::Instance().Save(std::ref(metadata), std::ref(entry))) {
-            LOG_ERROR("failed to add <{}> into storage", metadata.String());
-            return false;
+    }
+    for (auto iteration : iterations) {
+        if (!IterationManager::Instance().isExist(iteration)) {
+            IterationManager::Instance().pushIteration(iteration);
         }
     }
-    return true;
+
+    size_t threads = std::stoul(Util::GetEnv(config::ENV_KEY_RESTORE_THREADS, config::DEFAULT_RESTORE_THREADS));
+    auto mode = Util::GetEnv(config::ENV_KEY_RESTORE_MODE, config::RESTORE_MODE_EAGER);
+    auto &restorer = Restorer::Instance();
+    restorer.Start(std::move(vec), threads);
+    if (mode == config::RESTORE_MODE_LAZY) {
+        LOG_INFO("lazy restore, checkpoints are restored in background or on demand");
+        return true;
+    }
+    return restorer.Wait();
 }
 
 bool ClientUtil::NotifyBackup(api::InterNodeNotifyBackupResponse &rsp) {
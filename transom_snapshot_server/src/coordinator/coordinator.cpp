@@ -12,7 +12,9 @@
 #include "coordinator/coordinator.h"
 
 #include "api/api.h"
+#include "storage/metadata_batcher.h"
 #include "storage/storage.h"
+#include "util/numa.h"
 
 using coordinator::Coordinator;
 using coordinator::ClientUtil;
@@ -24,6 +26,14 @@ Coordinator::Coordinator(std::shared_ptr<operators::Operator> controller) {
 }
 
 void Coordinator::Run() {
+    /* persistence stage, newest iteration first */
+    auto &persist_queue = operators::PersistQueue::Instance();
+    persist_queue.SetHandler(Persist);
+    persist_queue.SetIterationChecker(IterationPersisted);
+    persist_queue.SetAbortHandler([](const std::string &key) { storage::Persistence::Instance().Abort(key); },
+                                  [](const std::string &key) { storage::Persistence::Instance().Forget(key); });
+    persist_queue.Run();
+
     std::thread([this]() { s_->Serve(); }).detach();
     LOG_INFO("coordinator server started");
     bootstrap();
@@ -158,12 +168,12 @@ bool Coordinator::Reconcile(std::string key) {
         return true;
     };
 
-    /* update state to given state */
-    auto updateState = [meta_client](api::Metadata metadata, api::CheckpointState state) -> bool {
+    /* update state to given state, batched with files of the iteration reconciled meanwhile */
+    auto updateState = [](api::Metadata metadata, api::CheckpointState state) -> bool {
         if (metadata.state == state) {
             return true;
         }
-        auto rc = meta_client->UpdateState(metadata.file_name, state);
+        auto rc = storage::MetadataBatcher::Instance().UpdateState(metadata.file_name, state);
         if (!api::IsSuccess(rc)) {
             LOG_ERROR("cannot update state of metadata {} to {}",
                       metadata.file_name, api::CheckpointStateString(state));
@@ -191,6 +201,8 @@ bool Coordinator::Reconcile(std::string key) {
 
     /* here we define handlers for different states */
     auto backUp = [](api::Metadata &metadata, api::DataEntry &entry, bool only_metadata) -> bool {
+        /* read memory from its own node */
+        util::NumaAffinity affinity(entry.numa_node);
         api::InterNodeBackupRequest req(metadata, entry, only_metadata);
         api::InterNodeBackupResponse rsp;
         ClientUtil remoteClient;
@@ -201,16 +213,12 @@ bool Coordinator::Reconcile(std::string key) {
         return true;
     };
 
-    /* write to disk. TODO: support AOSS */
-    auto persistence = [](api::Metadata &metadata, api::DataEntry &entry) -> bool {
+    /* persistence is done by its own queue, which updates state to PERSISTENT */
+    auto persistence = [](api::Metadata &metadata) {
         if (metadata.node_rank != WorldState::Instance().NodeRank()) { /* backup data only in memory */
-            return true;
-        }
-        if (!storage::Persistence::Instance().WriteToDisk(
-                metadata.file_name, (const void *)entry.address, metadata.size)) {
-            return false;
+            return;
         }
-        return true;
+        operators::PersistQueue::Instance().Push(metadata.file_name, metadata.iteration, metadata.size);
     };
 
     auto deleteCkpt = [](api::Metadata &metadata) -> bool {
@@ -257,12 +265,11 @@ bool Coordinator::Reconcile(std::string key) {
                 do_not_requeue = true;
                 break;
             }
-            LOG_INFO("start persistent {}", metadata.file_name);
+            LOG_INFO("queue persistent {}", metadata.file_name);
             /* just persistent ckpt */
-            if (!persistence(std::ref(metadata), std::ref(entry))) {
-                LOG_ERROR("persistence {} failed", metadata.file_name);
-                break;
-            }
+            persistence(std::ref(metadata));
+            do_not_requeue = true;
+            break;
         } else {
             LOG_INFO("start backup {} to other nodes", metadata.file_name);
             /* backup and update state to BACKED_UP */
@@ -274,8 +281,7 @@ bool Coordinator::Reconcile(std::string key) {
             }
         }
 
-        /* udpate state according to world size */
-        to_update_state = world_size > 1 ? api::CheckpointState::BACKED_UP : api::CheckpointState::PERSISTENT;
+        to_update_state = api::CheckpointState::BACKED_UP;
         if (!updateState(std::ref(metadata), to_update_state)) {
             LOG_ERROR("cannot update {} state to {}", metadata.file_name, to_update_state);
         }
@@ -284,7 +290,7 @@ bool Coordinator::Reconcile(std::string key) {
         break;
 
     case api::CheckpointState::BACKED_UP: /* persistent */
-        LOG_INFO("start persistent {}", metadata.file_name);
+        LOG_INFO("queue persistent {}", metadata.file_name);
         if (util::Util::GetEnv(config::IS_PERSISTENT, "on") == "off") {
             LOG_DEBUG("skip persistent {}", metadata.file_name);
             // If the user chooses not persistent, in order to compatible with DeepSpeed,
@@ -298,19 +304,8 @@ bool Coordinator::Reconcile(std::string key) {
             break;
         }
         /* persistent */
-        if (!persistence(std::ref(metadata), std::ref(entry))) {
-            LOG_ERROR("persistence {} failed", metadata.file_name);
-            do_not_requeue = true;
-            break;
-        }
-        LOG_INFO("file {} persistent", metadata.file_name);
-
-        /* update state to persistent */
-        to_update_state = api::CheckpointState::PERSISTENT;
-        if (!updateState(std::ref(metadata), to_update_state)) {
-            LOG_ERROR("cannot update {} state to {}", metadata.file_name, api::CheckpointStateString(to_update_state));
-        }
-        LOG_INFO("update state of {} to PERSISTENT, re-enqueue...", metadata.file_name);
+        persistence(std::ref(metadata));
+        do_not_requeue = true;
         break;
 
     case api::CheckpointState::PERSISTENT:
@@ -355,3 +350,66 @@ bool Coordinator::Reconcile(std::string key) {
     }
     return do_not_requeue;
 }
+
+bool Coordinator::Persist(const operators::PersistTask &task) {
+    api::Metadata metadata(WorldState::Instance().JobName(), task.key);
+    api::DataEntry entry;
+    auto meta_client = storage::MetadataClientFactory::GetClient();
+    auto rc = meta_client->Load(std::ref(metadata));
+    if (!api::IsSuccess(rc)) {
+        LOG_ERROR("load metadata of {} failed, skip persistence", task.key);
+        return false;
+    }
+
+    /* state may change while queued, e.g. marked obsolescent by eviction */
+    auto expected = WorldState::Instance().WorldSize() > 1 ? api::CheckpointState::BACKED_UP
+                                                           : api::CheckpointState::CACHED;
+    if (metadata.state != expected) {
+        LOG_INFO("state of {} is {}, skip persistence", metadata.file_name, CheckpointStateString(metadata.state));
+        return true;
+    }
+    if (!storage::Storage::Instance().Load(std::ref(metadata), std::ref(entry))) {
+        LOG_ERROR("data of {} not found, skip persistence", metadata.file_name);
+        return false;
+    }
+
+    LOG_INFO("start persistent {}", metadata.file_name);
+    util::NumaAffinity affinity(entry.numa_node);
+    auto &persistence = storage::Persistence::Instance();
+    bool ok = persistence.SSOEnabled()
+                  ? persistence.WriteToSSO(metadata.file_name, (const void *)entry.address, metadata.size)
+                  : persistence.WriteToDisk(metadata.file_name, (const void *)entry.address, metadata.size,
+                                            entry.memfd);
+    if (!ok) {
+        return false;
+    }
+    LOG_INFO("file {} persistent", metadata.file_name);
+
+    /* marked obsolescent or deleted while being written, PERSISTENT must not overwrite it */
+    rc = meta_client->Load(std::ref(metadata));
+    if (!api::IsSuccess(rc) || metadata.state == api::CheckpointState::OBSOLESCENT) {
+        LOG_INFO("{} is {} while being persisted, keep its state", metadata.file_name,
+                 api::IsSuccess(rc) ? CheckpointStateString(metadata.state) : "deleted");
+        return true;
+    }
+
+    rc = storage::MetadataBatcher::Instance().UpdateState(metadata.file_name, api::CheckpointState::PERSISTENT);
+    if (!api::IsSuccess(rc)) {
+        LOG_ERROR("cannot update {} state to {}", metadata.file_name,
+                  api::CheckpointStateString(api::CheckpointState::PERSISTENT));
+        return false;
+    }
+    return true;
+}
+
+bool Coordinator::IterationPersisted(int64_t iteration) {
+    api::BatchLoadFilter filter(WorldState::Instance().NodeRank(), std::to_string(iteration));
+    std::vector<api::Metadata> vec;
+    auto meta_client = storage::MetadataClientFactory::GetClient();
+    if (!api::IsSuccess(meta_client->BatchLoad(filter, vec)) || vec.empty()) {
+        return false;
+    }
+    return std::all_of(vec.begin(), vec.end(), [](const api::Metadata &metadata) {
+        return metadata.state == api::CheckpointState::PERSISTENT;
+    });
+}
@@ -0,0 +1,159 @@
+/**
+ * @file restorer.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "coordinator/restorer.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "logger/logger.h"
+#include "monitor/monitor.h"
+#include "operator/persist_queue.h"
+#include "storage/metadata.h"
+#include "storage/storage.h"
+
+using coordinator::Restorer;
+using monitor::MemoryMonitor;
+
+void Restorer::Start(std::vector<api::Metadata> files, size_t threads) {
+    /* newest iteration first, the one to resume training from is likely ready soonest */
+    std::stable_sort(files.begin(), files.end(), [](const api::Metadata &a, const api::Metadata &b) {
+        return operators::PersistTask::ParseIteration(a.iteration) > operators::PersistTask::ParseIteration(b.iteration);
+    });
+    threads = std::min(std::max(threads, 1UL), files.size());
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        total_ += files.size();
+        start_time_ = std::chrono::high_resolution_clock::now();
+        queue_.insert(queue_.end(), files.begin(), files.end());
+        running_ += threads;
+    }
+    LOG_INFO("restore {} files from file system by {} threads", files.size(), threads);
+    for (size_t i = 0; i < threads; i++) {
+        std::thread([this]() { this->run(); }).detach();
+    }
+}
+
+void Restorer::run() {
+    while (true) {
+        api::Metadata metadata;
+        {
+            std::lock_guard<std::mutex> lock(mut_);
+            if (queue_.empty()) {
+                if (--running_ == 0) {
+                    auto time_val = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::high_resolution_clock::now() - start_time_);
+                    double throughput = time_val.count() > 0
+                                            ? static_cast<double>(restored_bytes_) / time_val.count() * 1000 / 1048576
+                                            : 0;
+                    LOG_INFO("restored {}/{} files, {} bytes from file system use {} milliseconds, {:.2f} MB/s",
+                             restored_, total_, restored_bytes_, time_val.count(), throughput);
+                }
+                return;
+            }
+            metadata = queue_.front();
+            queue_.pop_front();
+            inflight_.insert(metadata.file_name);
+        }
+        bool ok = Restore(metadata);
+        {
+            std::lock_guard<std::mutex> lock(mut_);
+            inflight_.erase(metadata.file_name);
+            if (!ok) {
+                failed_.insert(metadata.file_name);
+            } else {
+                restored_++;
+                restored_bytes_ += metadata.size;
+            }
+        }
+        done_cv_.notify_all();
+    }
+}
+
+bool Restorer::Fetch(const std::string &file_name) {
+    std::unique_lock<std::mutex> lock(mut_);
+    auto it = std::find_if(queue_.begin(), queue_.end(),
+                           [&file_name](const api::Metadata &metadata) { return metadata.file_name == file_name; });
+    if (it != queue_.end()) {
+        /* restore it right here rather than waiting for a thread */
+        auto metadata = *it;
+        queue_.erase(it);
+        inflight_.insert(file_name);
+        lock.unlock();
+        LOG_INFO("{} is requested before restored, restore it on demand", file_name);
+        bool ok = Restore(metadata);
+        lock.lock();
+        inflight_.erase(file_name);
+        if (!ok) {
+            failed_.insert(file_name);
+        } else {
+            restored_++;
+            restored_bytes_ += metadata.size;
+        }
+        done_cv_.notify_all();
+        return ok;
+    }
+    done_cv_.wait(lock, [this, &file_name]() { return !pending(file_name); });
+    return failed_.count(file_name) == 0;
+}
+
+bool Restorer::Wait() {
+    std::unique_lock<std::mutex> lock(mut_);
+    done_cv_.wait(lock, [this]() { return queue_.empty() && inflight_.empty(); });
+    return failed_.empty();
+}
+
+bool Restorer::pending(const std::string &file_name) {
+    if (inflight_.count(file_name) > 0) {
+        return true;
+    }
+    return std::any_of(queue_.begin(), queue_.end(),
+                       [&file_name](const api::Metadata &metadata) { return metadata.file_name == file_name; });
+}
+
+bool Restorer::Restore(api::Metadata &metadata) {
+    auto &storage = storage::Storage::Instance();
+    /* state may change while queued, e.g. marked obsolescent by eviction */
+    auto meta_client = storage::MetadataClientFactory::GetClient();
+    if (api::IsSuccess(meta_client->Load(std::ref(metadata)))
+        && metadata.state == api::CheckpointState::OBSOLESCENT) {
+        LOG_INFO("{} is {}, skip restoring", metadata.file_name, api::CheckpointStateString(metadata.state));
+        return true;
+    }
+    /* created again since restart, which is newer than the persisted one */
+    if (storage.Contains(metadata)) {
+        LOG_INFO("{} is created again, skip restoring", metadata.file_name);
+        return true;
+    }
+
+    api::DataEntry entry;
+    auto rc = MemoryMonitor::Instance().TryLoadFromFile(std::ref(metadata), std::ref(entry));
+    if (!api::IsSuccess(rc)) {
+        LOG_ERROR("failed to restore {} from file system, rc {}", metadata.file_name, rc);
+        return false;
+    }
+    if (storage.Contains(metadata)) {
+        LOG_INFO("{} is created again while restoring, drop the restored one", metadata.file_name);
+        MemoryMonitor::Instance().memfdFree(std::ref(metadata), std::ref(entry));
+        return true;
+    }
+    if (!storage.Save(std::ref(metadata), std::ref(entry))) {
+        LOG_ERROR("failed to add <{}> into storage", metadata.String());
+        MemoryMonitor::Instance().memfdFree(std::ref(metadata), std::ref(entry));
+        return false;
+    }
+    /* served from now on without waiting for the rest */
+    storage.MarkRestored(metadata.file_name);
+    LOG_INFO("restored {} of iteration {} from file system", metadata.file_name, metadata.iteration);
+    return true;
+}
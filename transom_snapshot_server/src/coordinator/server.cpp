@@ -13,12 +13,14 @@
 
 #include "api/api.h"
 #include "coordinator/client.h"
+#include "coordinator/restorer.h"
 #include "monitor/monitor.h"
 #include "storage/storage.h"
 #include "util/channel.h"
 #include "util/util.h"
 
 using coordinator::Server;
+using coordinator::Restorer;
 using util::Util;
 using util::channel;
 using communicators::CommunicatorFactory;
@@ -129,7 +131,8 @@ void Server::handleBackup(std::shared_ptr<RdmaCommunicator> c) {
         api::DataEntry entry;
         if (!storage::Storage::Instance().Load(std::ref(req.metadata), std::ref(entry))) {
             LOG_DEBUG("{} doesn't exists, memfdCalloc", req.metadata.file_name);
-            auto rc = MemoryMonitor::Instance().TryMemfdMalloc(std::ref(req.metadata), std::ref(entry));
+            auto rc = MemoryMonitor::Instance().TryMemfdMalloc(std::ref(req.metadata), std::ref(entry),
+                                                               monitor::MEMORY_BACKUP, MemoryMonitor::Instance().WaitMs());
             if (api::IsOOM(rc)) {
                 LOG_ERROR("memfdCalloc failed: out of memory");
             }
@@ -206,7 +209,9 @@ void Server::handleLoad(std::shared_ptr<RdmaCommunicator> c) {
     /* load entry if necessary */
     if (!req.only_metadata) {
         api::DataEntry entry;
-        if (!Storage::Instance().Load(std::ref(metadata), std::ref(entry))) {
+        /* with lazy restore, it may not be restored yet */
+        if (!Restorer::Instance().Fetch(metadata.file_name)
+            || !Storage::Instance().Load(std::ref(metadata), std::ref(entry))) {
             LOG_ERROR("load from storage");
             rsp.code = api::STATUS_UNKNOWN_ERROR;
         } else {
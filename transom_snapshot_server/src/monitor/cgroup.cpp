@@ -0,0 +1,156 @@
+/**
+ * @file cgroup.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "monitor/cgroup.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using monitor::CgroupBackend;
+using monitor::CgroupBackendFactory;
+using monitor::CgroupV1;
+using monitor::CgroupV2;
+
+bool CgroupBackend::readValue(const std::string &file_name, size_t &value) {
+    std::ifstream infile(dir_ + file_name);
+    std::string text;
+    if (!(infile >> text)) {
+        return false;
+    }
+    if (text == "max") {
+        value = SIZE_MAX;
+        return true;
+    }
+    char *end = nullptr;
+    errno = 0;
+    auto parsed = std::strtoull(text.c_str(), &end, 10);
+    if (errno != 0 || end == text.c_str() || *end != '\0') {
+        LOG_WARN("unexpected content {} in {}{}", text, dir_, file_name);
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+std::map<std::string, size_t> CgroupBackend::readStat() {
+    std::map<std::string, size_t> stat;
+    std::ifstream infile(dir_ + "memory.stat");
+    std::string key;
+    size_t value;
+    while (infile >> key >> value) {
+        stat[key] = value;
+    }
+    return stat;
+}
+
+size_t CgroupBackend::reclaimable(size_t cache, size_t shmem, size_t dirty, size_t writeback) {
+    size_t pinned = shmem + dirty + writeback;
+    return cache > pinned ? cache - pinned : 0;
+}
+
+bool CgroupV1::Usage(size_t &usage, size_t &max_usage, size_t &reclaimable) {
+    if (!readValue("memory.usage_in_bytes", usage) || !readValue("memory.max_usage_in_bytes", max_usage)) {
+        return false;
+    }
+    /* total_ ones are hierarchical */
+    auto stat = readStat();
+    auto get = [&stat](const std::string &key) {
+        auto it = stat.find("total_" + key);
+        if (it == stat.end()) {
+            it = stat.find(key);
+        }
+        return it == stat.end() ? 0 : it->second;
+    };
+    reclaimable = CgroupBackend::reclaimable(get("cache"), get("shmem"), get("dirty"), get("writeback"));
+    return true;
+}
+
+bool CgroupV1::Limit(size_t &limit) {
+    return readValue("memory.limit_in_bytes", limit);
+}
+
+bool CgroupV2::Usage(size_t &usage, size_t &max_usage, size_t &reclaimable) {
+    if (!readValue("memory.current", usage)) {
+        return false;
+    }
+    /* memory.peak is added in linux 5.19 */
+    if (!readValue("memory.peak", max_usage)) {
+        max_usage = 0;
+    }
+    /* file includes shmem in v2 */
+    auto stat = readStat();
+    reclaimable = CgroupBackend::reclaimable(stat["file"], stat["shmem"], stat["file_dirty"], stat["file_writeback"]);
+    return true;
+}
+
+bool CgroupV2::Limit(size_t &limit) {
+    return readValue("memory.max", limit);
+}
+
+/**
+ * @brief cgroup path of this process in /proc/self/cgroup, "" if not found
+ */
+static std::string selfCgroup(bool v2) {
+    std::ifstream infile("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(infile, line)) {
+        /* hierarchy-ID:controller-list:cgroup-path */
+        auto first = line.find(':');
+        auto second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        auto controllers = "," + line.substr(first + 1, second - first - 1) + ",";
+        if ((v2 && controllers == ",,") || (!v2 && controllers.find(",memory,") != std::string::npos)) {
+            return line.substr(second + 1);
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief directory of own cgroup under root. Within cgroup namespace of a container, root is own cgroup already
+ */
+static std::string locate(const std::string &root, bool v2, const std::string &probe) {
+    auto self = selfCgroup(v2);
+    if (!self.empty() && self != "/") {
+        auto dir = root + self.substr(1) + "/";
+        if (access((dir + probe).c_str(), R_OK) == 0) {
+            return dir;
+        }
+    }
+    return root;
+}
+
+std::unique_ptr<CgroupBackend> CgroupBackendFactory::Create() {
+    auto option = util::Util::GetEnv(config::ENV_KEY_CGROUP_VERSION, config::CGROUP_VERSION_AUTO);
+    bool is_auto = option == config::CGROUP_VERSION_AUTO;
+    std::string v1_root = config::MEM_CGROUP_DIR;
+    std::string v2_root = config::MEM_CGROUP_V2_DIR;
+    /* on hybrid hierarchy, memory controller is still on v1 */
+    if (option == config::CGROUP_VERSION_V1
+        || (is_auto && access((v1_root + "memory.usage_in_bytes").c_str(), R_OK) == 0)) {
+        return std::make_unique<CgroupV1>(locate(v1_root, false, "memory.usage_in_bytes"));
+    }
+    if (option == config::CGROUP_VERSION_V2
+        || (is_auto && access((v2_root + "cgroup.controllers").c_str(), R_OK) == 0)) {
+        return std::make_unique<CgroupV2>(locate(v2_root, true, "memory.current"));
+    }
+    LOG_FATAL("cgroup config {} unsupported or no memory cgroup is found", option);
+}
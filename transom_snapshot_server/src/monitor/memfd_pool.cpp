@@ -0,0 +1,141 @@
+/**
+ * @file memfd_pool.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "monitor/memfd_pool.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "logger/logger.h"
+#include "operator/persist_queue.h"
+#include "util/util.h"
+
+using monitor::MemfdPool;
+
+MemfdPool::MemfdPool(size_t capacity) :
+    capacity_(capacity) {
+}
+
+MemfdPool::~MemfdPool() {
+    for (auto &[size, entries] : segments_) {
+        for (auto &entry : entries) {
+            munmap(reinterpret_cast<void *>(entry.address), util::Util::MemfdMappedSize(entry.memfd, size));
+            close(entry.memfd);
+        }
+    }
+}
+
+bool MemfdPool::Acquire(const api::Metadata &metadata, api::DataEntry &entry) {
+    if (!Enabled()) {
+        return false;
+    }
+    auto iteration = operators::PersistTask::ParseIteration(metadata.iteration);
+    std::lock_guard<std::mutex> lock(mut_);
+    if (iteration > iteration_) {
+        if (iteration_ != operators::PersistTask::UNKNOWN_ITERATION) {
+            last_demand_ = std::move(demand_);
+            demand_.clear();
+        }
+        iteration_ = iteration;
+        demand_cv_.notify_all();
+    }
+    demand_[metadata.size]++;
+
+    auto it = segments_.find(metadata.size);
+    if (it == segments_.end() || it->second.empty()) {
+        miss_ << 1;
+        return false;
+    }
+    entry = it->second.back();
+    it->second.pop_back();
+    auto mapped = util::Util::MemfdMappedSize(entry.memfd, metadata.size);
+    pooled_bytes_ -= mapped;
+    pooled_bytes_var_ << -static_cast<int64_t>(mapped);
+    hit_ << 1;
+    LOG_DEBUG("take {} of {} bytes from memfd pool, memfd {}", metadata.file_name, metadata.size, entry.memfd);
+    return true;
+}
+
+bool MemfdPool::Release(const api::Metadata &metadata, const api::DataEntry &entry) {
+    if (!Enabled() || metadata.size == 0) {
+        return false;
+    }
+    /* client may have truncated it to another size */
+    auto size = metadata.size;
+    auto mapped = util::Util::MemfdMappedSize(entry.memfd, size);
+    struct stat st;
+    if (fstat(entry.memfd, &st) != 0 || static_cast<size_t>(st.st_size) != mapped) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mut_);
+    auto target = std::max(last_demand_[size], demand_[size]);
+    auto &entries = segments_[size];
+    if (entries.size() >= target || pooled_bytes_ + mapped > capacity_) {
+        return false;
+    }
+    entries.push_back(entry);
+    pooled_bytes_ += mapped;
+    pooled_bytes_var_ << mapped;
+    recycled_ << 1;
+    return true;
+}
+
+void MemfdPool::Add(size_t size, const api::DataEntry &entry) {
+    auto mapped = util::Util::MemfdMappedSize(entry.memfd, size);
+    std::lock_guard<std::mutex> lock(mut_);
+    segments_[size].push_back(entry);
+    pooled_bytes_ += mapped;
+    pooled_bytes_var_ << mapped;
+}
+
+std::vector<size_t> MemfdPool::Shortage() {
+    std::vector<size_t> sizes;
+    if (!Enabled()) {
+        return sizes;
+    }
+    std::lock_guard<std::mutex> lock(mut_);
+    size_t planned = pooled_bytes_;
+    for (auto &[size, target] : last_demand_) {
+        auto it = segments_.find(size);
+        size_t have = it == segments_.end() ? 0 : it->second.size();
+        auto reserved = util::Util::MemfdReserveSize(size);
+        for (size_t i = have; i < target && planned + reserved <= capacity_; i++) {
+            sizes.push_back(size);
+            planned += reserved;
+        }
+    }
+    return sizes;
+}
+
+std::vector<std::pair<size_t, api::DataEntry>> MemfdPool::Trim(size_t bytes) {
+    std::vector<std::pair<size_t, api::DataEntry>> removed;
+    std::lock_guard<std::mutex> lock(mut_);
+    size_t freed = 0;
+    for (auto &[size, entries] : segments_) {
+        while (!entries.empty() && freed < bytes) {
+            removed.emplace_back(size, entries.back());
+            entries.pop_back();
+            freed += util::Util::MemfdMappedSize(removed.back().second.memfd, size);
+        }
+    }
+    pooled_bytes_ -= freed;
+    pooled_bytes_var_ << -static_cast<int64_t>(freed);
+    return removed;
+}
+
+void MemfdPool::WaitDemand(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mut_);
+    demand_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms));
+}
@@ -0,0 +1,153 @@
+/**
+ * @file memory_events.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "monitor/memory_events.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "config/config.h"
+#include "logger/logger.h"
+
+using monitor::MemoryEvents;
+
+MemoryEvents::MemoryEvents(const std::string &cgroup_dir) {
+    if (access((cgroup_dir + "memory.pressure").c_str(), F_OK) == 0) {
+        watchPressure(cgroup_dir + "memory.pressure");
+    } else {
+        watchPressure("/proc/pressure/memory");
+    }
+    if (access((cgroup_dir + "memory.events").c_str(), F_OK) == 0) {
+        watchEvents(cgroup_dir + "memory.events");
+    }
+    if (access((cgroup_dir + "memory.pressure_level").c_str(), F_OK) == 0) {
+        watchPressureLevel(cgroup_dir);
+    }
+    LOG_INFO("memory events: {} sources set up in {}", fds_.size(), cgroup_dir);
+}
+
+MemoryEvents::~MemoryEvents() {
+    for (auto &source : fds_) {
+        close(source.fd);
+    }
+    for (auto fd : holders_) {
+        close(fd);
+    }
+}
+
+void MemoryEvents::watchPressure(const std::string &file) {
+    int fd = open(file.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        LOG_DEBUG("open {} failed: {}", file, strerror(errno));
+        return;
+    }
+    /* trigger is removed when fd is closed */
+    auto trigger = config::MEM_PSI_TRIGGER;
+    if (write(fd, trigger, strlen(trigger) + 1) < 0) {
+        LOG_DEBUG("set psi trigger {} on {} failed: {}", trigger, file, strerror(errno));
+        close(fd);
+        return;
+    }
+    fds_.push_back(Source{fd, POLLPRI, false});
+}
+
+void MemoryEvents::watchEvents(const std::string &file) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        LOG_DEBUG("inotify_init1 failed: {}", strerror(errno));
+        return;
+    }
+    /* kernel generates a modify event when counters in memory.events change */
+    if (inotify_add_watch(fd, file.c_str(), IN_MODIFY) < 0) {
+        LOG_DEBUG("watch {} failed: {}", file, strerror(errno));
+        close(fd);
+        return;
+    }
+    fds_.push_back(Source{fd, POLLIN, true});
+}
+
+void MemoryEvents::watchPressureLevel(const std::string &cgroup_dir) {
+    auto level_file = cgroup_dir + "memory.pressure_level";
+    auto control_file = cgroup_dir + "cgroup.event_control";
+    int event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd < 0) {
+        LOG_DEBUG("eventfd failed: {}", strerror(errno));
+        return;
+    }
+    int level_fd = open(level_file.c_str(), O_RDONLY | O_CLOEXEC);
+    int control_fd = open(control_file.c_str(), O_WRONLY | O_CLOEXEC);
+    if (level_fd < 0 || control_fd < 0) {
+        LOG_DEBUG("open {} or {} failed: {}", level_file, control_file, strerror(errno));
+        close(event_fd);
+        if (level_fd >= 0) {
+            close(level_fd);
+        }
+        if (control_fd >= 0) {
+            close(control_fd);
+        }
+        return;
+    }
+    auto line = std::to_string(event_fd) + " " + std::to_string(level_fd) + " " + config::MEM_PRESSURE_LEVEL;
+    if (write(control_fd, line.c_str(), line.size()) < 0) {
+        LOG_DEBUG("register {} pressure in {} failed: {}", config::MEM_PRESSURE_LEVEL, control_file, strerror(errno));
+        close(event_fd);
+        close(level_fd);
+        close(control_fd);
+        return;
+    }
+    close(control_fd);
+    holders_.push_back(level_fd);
+    fds_.push_back(Source{event_fd, POLLIN, true});
+}
+
+bool MemoryEvents::Wait(int timeout_ms) {
+    if (fds_.empty()) {
+        usleep(timeout_ms * 1000);
+        return false;
+    }
+    std::vector<pollfd> fds;
+    for (auto &source : fds_) {
+        fds.push_back(pollfd{source.fd, source.events, 0});
+    }
+    int n = poll(fds.data(), fds.size(), timeout_ms);
+    if (n <= 0) {
+        if (n < 0 && errno != EINTR) {
+            LOG_WARN("poll memory events failed: {}", strerror(errno));
+            usleep(timeout_ms * 1000);
+        }
+        return false;
+    }
+    char buffer[4096];
+    std::vector<Source> alive;
+    for (size_t i = 0; i < fds.size(); i++) {
+        /* e.g. cgroup is removed, the source would wake poll up forever */
+        if (fds[i].revents & (POLLERR | POLLNVAL | POLLHUP)) {
+            LOG_WARN("memory event source {} is broken, stop watching it", fds[i].fd);
+            close(fds[i].fd);
+            continue;
+        }
+        alive.push_back(fds_[i]);
+        if (fds[i].revents == 0 || !fds_[i].readable) {
+            continue;
+        }
+        /* drain, so that poll blocks until next event */
+        while (read(fds[i].fd, buffer, sizeof(buffer)) > 0) {
+        }
+    }
+    fds_.swap(alive);
+    return true;
+}
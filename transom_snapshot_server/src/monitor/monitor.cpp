@@ -11,133 +11,461 @@
 
 #include "monitor/monitor.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include "monitor/memory_events.h"
+#include "storage/persistence.h"
+#include "util/numa.h"
 #include "util/util.h"
 
 using monitor::MemoryMonitor;
 using monitor::MemoryStat;
 using util::Util;
 
+std::string monitor::MemoryClassString(MemoryClass cls) {
+    switch (cls) {
+    case MEMORY_OWN:
+        return "own";
+    case MEMORY_BACKUP:
+        return "backup";
+    case MEMORY_RESTORE:
+        return "restore";
+    default:
+        return "unknown";
+    }
+}
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+/* allocate pages of [offset, offset + length) of memfd, content is untouched */
+static void prefault(int memfd, size_t offset, size_t length) {
+    /* a separate mapping, so that it does not matter if checkpoint is unmapped meanwhile. It must be MAP_SHARED:
+     * populating a MAP_PRIVATE mapping for write allocates anonymous copies and leaves pages of memfd untouched */
+    auto address = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, offset);
+    if (address != MAP_FAILED) {
+        Util::AdviseHugePage(address, length);
+        auto rc = madvise(address, length, MADV_POPULATE_WRITE);
+        munmap(address, length);
+        if (rc == 0) {
+            return;
+        }
+    }
+    /* before linux 5.14, shmem fallocate is serialized by inode lock but still saves faults */
+    if (fallocate(memfd, 0, offset, length) != 0) {
+        LOG_DEBUG("prefault memfd {} offset {} length {} failed: {}", memfd, offset, length, strerror(errno));
+    }
+}
+
 MemoryMonitor::MemoryMonitor() {
-    buffer_ = static_cast<char *>(calloc(sizeof(char), 100));
+    cgroup_ = CgroupBackendFactory::Create();
     auto user_limit = util::Util::GetEnv(config::ENV_KEY_MEMORY_LIMIT_GB); // unit: GB
     user_limit_ = user_limit.size() == 0 ? 0 : std::stoull(user_limit) * 1024 * 1024 * 1024L;
+    auto pool_limit = util::Util::GetEnv(config::ENV_KEY_MEMFD_POOL_GB, config::DEFAULT_MEMFD_POOL_GB);
+    pool_ = std::make_unique<MemfdPool>(std::stoull(pool_limit) * 1024 * 1024 * 1024L);
+    const char *budget_keys[MEMORY_CLASS_NUM] = {config::ENV_KEY_MEMORY_BUDGET_OWN_GB,
+                                                 config::ENV_KEY_MEMORY_BUDGET_BACKUP_GB,
+                                                 config::ENV_KEY_MEMORY_BUDGET_RESTORE_GB};
+    for (int cls = 0; cls < MEMORY_CLASS_NUM; cls++) {
+        auto budget = util::Util::GetEnv(budget_keys[cls]);
+        budgets_[cls] = budget.size() == 0 ? 0 : std::stoull(budget) * 1024 * 1024 * 1024L;
+    }
+    wait_ms_ = std::stoi(util::Util::GetEnv(config::ENV_KEY_MEMORY_WAIT_MS, config::DEFAULT_MEMORY_WAIT_MS));
+    auto prefault_threads = std::stoul(util::Util::GetEnv(config::ENV_KEY_PREFAULT_THREADS,
+                                                          config::DEFAULT_PREFAULT_THREADS));
+    if (prefault_threads > 0) {
+        prefault_pool_ = std::make_unique<util::ThreadPool>(prefault_threads);
+    }
+    if (util::Numa::Enabled()) {
+        for (auto node : util::Numa::Nodes()) {
+            auto usage = std::make_unique<NodeUsage>();
+            usage->var.expose_as("ckpt_engine_memory_node" + std::to_string(node), "bytes");
+            node_usage_[node] = std::move(usage);
+        }
+    }
     collectMetric(true);
+    LOG_INFO("memory monitor of cgroup {} in {}, statistics: {}",
+             cgroup_->Version(), cgroup_->Dir(), GetMemoryStat().String());
 }
 
 MemoryMonitor::~MemoryMonitor() {
-    free(buffer_);
 }
 
 void MemoryMonitor::Start() {
     std::thread([this]() {
-        std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+        MemoryEvents events(cgroup_->Dir());
         while (true) {
-            std::chrono::steady_clock::time_point current_time = std::chrono::steady_clock::now();
-            std::chrono::duration<double> elapsed_seconds = current_time - start_time;
-            if (elapsed_seconds.count() >= config::MEM_WATCH_PERIOD_SECONDS) {
-                collectMetric(false);
-                start_time = std::chrono::steady_clock::now();
-                continue;
+            if (events.Wait(config::MEM_WATCH_PERIOD_SECONDS * 1000)) {
+                LOG_DEBUG("memory event arrives, collect metric");
             }
+            collectMetric(false);
         }
     }).detach();
-    LOG_INFO("memory monitor started, collect metric every {} seconds", config::MEM_WATCH_PERIOD_SECONDS);
+    LOG_INFO("memory monitor started, collect metric on memory events or every {} seconds",
+             config::MEM_WATCH_PERIOD_SECONDS);
+    if (pool_->Enabled()) {
+        std::thread([this]() {
+            while (true) {
+                pool_->WaitDemand(1000);
+                refill();
+            }
+        }).detach();
+        LOG_INFO("memfd pool started");
+    }
 }
 
-void MemoryMonitor::collectMetric(bool collectCapacity) {
-    auto readAndSet = [this](std::string file_name, size_t &val) {
-        std::ifstream infile;
-        infile.open(std::string(config::MEM_CGROUP_DIR) + file_name);
-        infile >> buffer_;
-        val = std::stoul(buffer_);
-        infile.close();
-    };
-
-    mu_.lock();
+void MemoryMonitor::refill() {
+    api::Metadata metadata;
+    metadata.file_name = "ckpt_engine_pool";
+    for (auto size : pool_->Shortage()) {
+        metadata.size = size;
+        api::DataEntry entry;
+        if (!api::IsSuccess(allocate(metadata, entry, MEMORY_OWN, 0))) {
+            return;
+        }
+        /* allocate pages now rather than on first write of the checkpoint */
+        prefault(entry.memfd, 0, Util::MemfdMappedSize(entry.memfd, size));
+        pool_->Add(size, entry);
+        LOG_DEBUG("memfd pool added segment of {} bytes, memfd {}", size, entry.memfd);
+    }
+}
 
-    /* read total mem info from cgroup config */
+bool MemoryMonitor::shrinkPool(size_t bytes) {
+    auto segments = pool_->Trim(bytes);
+    for (auto &[size, entry] : segments) {
+        api::Metadata metadata;
+        metadata.file_name = "ckpt_engine_pool";
+        metadata.size = size;
+        memfdFree(metadata, entry, true);
+    }
+    return !segments.empty();
+}
 
-    readAndSet("memory.usage_in_bytes", std::ref(stat_.total_usage));
-    readAndSet("memory.max_usage_in_bytes", std::ref(stat_.total_max_usage));
+void MemoryMonitor::collectMetric(bool collectCapacity) {
+    std::lock_guard<std::mutex> lock(mu_);
 
     if (collectCapacity) {
-        readAndSet("memory.limit_in_bytes", std::ref(stat_.total_capacity));
+        size_t capacity = SIZE_MAX;
+        if (!cgroup_->Limit(capacity)) {
+            LOG_WARN("failed to read memory limit of cgroup {} in {}, take it as unlimited",
+                     cgroup_->Version(), cgroup_->Dir());
+        }
         /* if cgroup limit is not set, cap may exceeds max available memory */
         auto pages = sysconf(_SC_PHYS_PAGES);
         auto page_size = sysconf(_SC_PAGE_SIZE);
         size_t max_physical_memory = pages * page_size;
         if (user_limit_ > 0) {
-            stat_.total_capacity = std::min(stat_.total_capacity, user_limit_);
+            capacity_ = std::min(capacity, user_limit_);
         } else {
-            stat_.total_capacity = std::min(stat_.total_capacity, max_physical_memory);
+            capacity_ = std::min(capacity, max_physical_memory);
         }
     }
-    if (user_limit_ > 0) {
-        stat_.total_idle = stat_.total_capacity - stat_.self_total_usage;
-    } else {
-        stat_.total_idle = stat_.total_capacity - stat_.total_usage;
+    /* read total mem info from cgroup */
+    size_t usage, max_usage, reclaimable;
+    if (!cgroup_->Usage(usage, max_usage, reclaimable)) {
+        LOG_WARN("failed to read memory usage of cgroup {} in {}, keep previous statistics",
+                 cgroup_->Version(), cgroup_->Dir());
+        return;
     }
+    usage_ = usage;
+    max_usage_ = max_usage;
+    reclaimable_ = reclaimable;
+
+    /* clean page cache is dropped by kernel before it OOMs */
+    size_t used = user_limit_ > 0 ? self_usage_.load() : usage - std::min(usage, reclaimable);
+    idle_ = capacity_ > used ? capacity_ - used : 0;
+    notifySpace();
 
-    LOG_INFO("memory monitor statistics: {}", stat_.String());
+    LOG_DEBUG("memory monitor statistics: {}", GetMemoryStat().String());
+}
 
-    mu_.unlock();
+bool MemoryMonitor::tryReserve(MemoryClass cls, size_t size) {
+    auto &used = class_used_[cls];
+    auto current = used.load();
+    do {
+        if (budgets_[cls] > 0 && current + size > budgets_[cls]) {
+            return false;
+        }
+    } while (!used.compare_exchange_weak(current, current + size));
+    /* cgroup usage grows as pages are touched, do not hand the same idle memory out twice until next collection */
+    auto idle = idle_.load();
+    while (idle > size) {
+        if (idle_.compare_exchange_weak(idle, idle - size)) {
+            self_usage_ += size;
+            return true;
+        }
+    }
+    used -= size;
+    return false;
 }
 
-bool MemoryMonitor::enough(size_t toAlloc) {
+bool MemoryMonitor::Reserve(MemoryClass cls, size_t size, int wait_ms) {
+    if (tryReserve(cls, size)) {
+        return true;
+    }
+    /* snapshot may be stale, memory could have been freed since */
     collectMetric(false);
-    return stat_.total_idle > toAlloc;
+    if (tryReserve(cls, size)) {
+        return true;
+    }
+    if (wait_ms > 0) {
+        LOG_INFO("wait up to {} milliseconds for {} bytes of {} memory", wait_ms, size, MemoryClassString(cls));
+        std::unique_lock<std::mutex> lock(space_mu_);
+        if (space_cv_.wait_for(lock, std::chrono::milliseconds(wait_ms), [this, cls, size]() {
+                return tryReserve(cls, size);
+            })) {
+            return true;
+        }
+    }
+    LOG_WARN("memory insuficient, require {} of {}, idle {}, class used {} budget {}",
+             size, MemoryClassString(cls), idle_.load(), class_used_[cls].load(), budgets_[cls]);
+    return false;
 }
 
-int MemoryMonitor::TryMemfdMalloc(const api::Metadata &metadata, api::DataEntry &entry) {
-    if (enough(metadata.size) == false) {
-        LOG_WARN("memory insuficient, require {}, idle {}", metadata.size, stat_.total_idle);
-        return api::STATUS_OOM;
+void MemoryMonitor::Commit(MemoryClass cls, size_t size) {
+    class_committed_[cls] += size;
+    switch (cls) {
+    case MEMORY_OWN:
+        own_bytes_ << size;
+        break;
+    case MEMORY_BACKUP:
+        backup_bytes_ << size;
+        break;
+    default:
+        restore_bytes_ << size;
     }
-    stat_.self_total_usage += metadata.size;
-    return Util::memfdCalloc(metadata, entry);
 }
 
-void MemoryMonitor::memfdFree(api::Metadata &metadata, api::DataEntry &entry) {
-    LOG_TRACE("delete {} address {} size {} memfd {} in storage",
-              metadata.file_name, reinterpret_cast<void *>(entry.address), metadata.size, entry.memfd);
-    auto async_munmap = [](api::Metadata &metadata, api::DataEntry &entry) {
-        LOG_TRACE("delete {} address {} size {} memfd {} in storage", metadata.file_name,
-                  reinterpret_cast<void *>(entry.address), metadata.size, entry.memfd);
-        if (munmap(reinterpret_cast<void *>(entry.address), metadata.size) != 0) {
-            LOG_FATAL("munmap failed: {}", strerror(errno));
+void MemoryMonitor::Release(MemoryClass cls, size_t size, bool committed) {
+    if (size == 0) {
+        return;
+    }
+    if (committed) {
+        class_committed_[cls] -= size;
+        auto delta = -static_cast<int64_t>(size);
+        switch (cls) {
+        case MEMORY_OWN:
+            own_bytes_ << delta;
+            break;
+        case MEMORY_BACKUP:
+            backup_bytes_ << delta;
+            break;
+        default:
+            restore_bytes_ << delta;
         }
+    }
+    class_used_[cls] -= size;
+    self_usage_ -= size;
+    /* with user limit, idle is derived from self usage only, otherwise it's back after next collection */
+    if (user_limit_ > 0) {
+        idle_ += size;
+    }
+    notifySpace();
+}
+
+void MemoryMonitor::notifySpace() {
+    /* a waiter between checking and sleeping would miss notification without lock */
+    {
+        std::lock_guard<std::mutex> lock(space_mu_);
+    }
+    space_cv_.notify_all();
+}
+
+int MemoryMonitor::TryMemfdMalloc(const api::Metadata &metadata, api::DataEntry &entry, MemoryClass cls,
+                                  int wait_ms) {
+    auto node = entry.numa_node;
+    /* pooled memory is charged to own checkpoints already */
+    if (cls == MEMORY_OWN && pool_->Acquire(metadata, entry)) {
+        entry.pid = getpid();
+        /* pooled pages are faulted already, migrate them */
+        bindNode(entry, Util::MemfdMappedSize(entry.memfd, metadata.size), node, true);
+        return api::STATUS_SUCCESS;
+    }
+    entry.numa_node = node;
+    auto rc = allocate(metadata, entry, cls, 0);
+    /* pooled segments of other sizes are the cheapest to give up */
+    if (api::IsOOM(rc) && shrinkPool(Util::MemfdReserveSize(metadata.size))) {
+        rc = allocate(metadata, entry, cls, 0);
+    }
+    if (api::IsOOM(rc) && wait_ms > 0) {
+        rc = allocate(metadata, entry, cls, wait_ms);
+    }
+    if (api::IsSuccess(rc) && prefault_pool_) {
+        prefaultAsync(metadata, entry);
+    }
+    return rc;
+}
+
+void MemoryMonitor::prefaultAsync(const api::Metadata &metadata, const api::DataEntry &entry) {
+    size_t size = Util::MemfdMappedSize(entry.memfd, metadata.size);
+    /* no job would close the dup */
+    if (size == 0) {
+        return;
+    }
+    /* memfd may be closed by deletion before workers are done */
+    int memfd = dup(entry.memfd);
+    if (memfd < 0) {
+        LOG_WARN("dup memfd of {} failed, skip prefault: {}", metadata.file_name, strerror(errno));
+        return;
+    }
+    /* whole huge pages per worker */
+    size_t align = std::max(Util::HugePageSize(), static_cast<size_t>(sysconf(_SC_PAGE_SIZE)));
+    size_t chunk = (size + prefault_pool_->Size() - 1) / prefault_pool_->Size();
+    chunk = std::max((chunk + align - 1) / align * align, align);
+
+    struct Job {
+        std::string file_name;
+        int memfd;
+        size_t size;
+        std::atomic<size_t> remaining;
+        std::chrono::steady_clock::time_point start_time;
     };
-    // async_munmap(std::ref(metadata), std::ref(entry));
-    std::thread(std::move(async_munmap), std::ref(metadata), std::ref(entry)).detach();
-    stat_.self_total_usage -= metadata.size;
+    auto job = std::make_shared<Job>();
+    job->file_name = metadata.file_name;
+    job->memfd = memfd;
+    job->size = size;
+    job->remaining = (size + chunk - 1) / chunk;
+    job->start_time = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < size; offset += chunk) {
+        prefault_pool_->Submit([this, job, offset, length = std::min(chunk, size - offset)]() {
+            prefault(job->memfd, offset, length);
+            if (--job->remaining > 0) {
+                return;
+            }
+            close(job->memfd);
+            auto time_val = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - job->start_time);
+            prefault_bytes_ << job->size;
+            prefault_ms_ << time_val.count();
+            LOG_INFO("prefault performance: {} bytes of {} use {} milliseconds",
+                     job->size, job->file_name, time_val.count());
+        });
+    }
 }
 
-int MemoryMonitor::TryLoadFromFile(const api::Metadata &metadata, api::DataEntry &entry) {
-    if (enough(metadata.size) == false) {
-        LOG_WARN("memory insuficient, require {}, idle {}", metadata.size, stat_.total_idle);
+int MemoryMonitor::allocate(const api::Metadata &metadata, api::DataEntry &entry, MemoryClass cls, int wait_ms) {
+    /* hugetlb memfd takes whole huge pages unless it falls back to normal pages */
+    auto reserved = Util::MemfdReserveSize(metadata.size);
+    if (!Reserve(cls, reserved, wait_ms)) {
         return api::STATUS_OOM;
     }
-    auto start_time = std::chrono::high_resolution_clock::now();
-    stat_.self_total_usage += metadata.size;
     auto rc = Util::memfdCalloc(metadata, entry);
+    if (!api::IsSuccess(rc)) {
+        Release(cls, reserved, false);
+        return rc;
+    }
+    auto mapped = Util::MemfdMappedSize(entry.memfd, metadata.size);
+    Release(cls, reserved - mapped, false);
+    Commit(cls, mapped);
+    auto node = entry.numa_node;
+    entry.numa_node = -1;
+    {
+        std::lock_guard<std::mutex> lock(alloc_mu_);
+        allocations_[entry.address] = Allocation{cls, mapped, -1};
+    }
+    /* before any page is faulted */
+    bindNode(entry, mapped, node, false);
+    return rc;
+}
 
-    auto fp = fopen(metadata.file_name.c_str(), "r");
-    if (!fp) {
-        LOG_ERROR("failed to open file {} error: {}, you may not have permission to create it",
-                  metadata.file_name, strerror(errno));
-        return api::STATUS_UNKNOWN_ERROR;
+void MemoryMonitor::bindNode(api::DataEntry &entry, size_t size, int node, bool move) {
+    if (node == entry.numa_node || node_usage_.count(node) == 0) {
+        return;
     }
-    // if (file_len != metadata.Size) {
-    // }
-    auto read = fread(reinterpret_cast<void *>(entry.address), sizeof(char), metadata.size, fp);
-    if (read != metadata.size) {
-        LOG_ERROR("read from file {}, expect read {} bytes, return {}, failed: {}",
-                  metadata.file_name, metadata.size, read, strerror(errno));
-        return api::STATUS_UNKNOWN_ERROR;
+    if (!util::Numa::Bind(reinterpret_cast<void *>(entry.address), size, node, move)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(alloc_mu_);
+        if (auto it = allocations_.find(entry.address); it != allocations_.end()) {
+            it->second.node = node;
+        }
+    }
+    chargeNode(entry.numa_node, -static_cast<int64_t>(size));
+    chargeNode(node, size);
+    entry.numa_node = node;
+}
+
+void MemoryMonitor::chargeNode(int node, int64_t delta) {
+    auto it = node_usage_.find(node);
+    if (it == node_usage_.end()) {
+        return;
+    }
+    it->second->bytes += delta;
+    it->second->var << delta;
+}
+
+bool MemoryMonitor::Recycle(const api::Metadata &metadata, const api::DataEntry &entry) {
+    {
+        std::lock_guard<std::mutex> lock(alloc_mu_);
+        auto it = allocations_.find(entry.address);
+        if (it == allocations_.end() || it->second.cls != MEMORY_OWN) {
+            return false;
+        }
+    }
+    return pool_->Release(metadata, entry);
+}
+
+void MemoryMonitor::memfdFree(const api::Metadata &metadata, api::DataEntry &entry, bool wait) {
+    auto size = Util::MemfdMappedSize(entry.memfd, metadata.size);
+    auto cls = MEMORY_OWN;
+    int node = -1;
+    {
+        std::lock_guard<std::mutex> lock(alloc_mu_);
+        if (auto it = allocations_.find(entry.address); it != allocations_.end()) {
+            cls = it->second.cls;
+            size = it->second.size;
+            node = it->second.node;
+            allocations_.erase(it);
+        } else {
+            LOG_WARN("{} address {} is not allocated by memory monitor", metadata.file_name,
+                     reinterpret_cast<void *>(entry.address));
+        }
+    }
+    LOG_TRACE("delete {} address {} size {} memfd {} in storage",
+              metadata.file_name, reinterpret_cast<void *>(entry.address), size, entry.memfd);
+    close(entry.memfd);
+    /* entry is usually erased right after, capture by value */
+    auto async_munmap = [file_name = metadata.file_name, address = entry.address, size]() {
+        LOG_TRACE("munmap {} address {} size {}", file_name, reinterpret_cast<void *>(address), size);
+        if (munmap(reinterpret_cast<void *>(address), size) != 0) {
+            LOG_FATAL("munmap failed: {}", strerror(errno));
+        }
+    };
+    if (wait) {
+        async_munmap();
+    } else {
+        std::thread(std::move(async_munmap)).detach();
+    }
+    chargeNode(node, -static_cast<int64_t>(size));
+    Release(cls, size, true);
+}
+
+int MemoryMonitor::TryLoadFromFile(const api::Metadata &metadata, api::DataEntry &entry, MemoryClass cls) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto rc = allocate(metadata, entry, cls, 0);
+    if (!api::IsSuccess(rc)) {
+        return rc;
+    }
+
+    auto &persistence = storage::Persistence::Instance();
+    auto address = reinterpret_cast<void *>(entry.address);
+    if (persistence.SSOEnabled()) {
+        /* ranged downloads straight into the new memfd */
+        if (!persistence.ReadFromSSO(metadata.file_name, address, metadata.size)) {
+            memfdFree(metadata, entry, true);
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        return rc;
     }
-    auto ret = fclose(fp);
-    if (ret != 0) {
-        LOG_ERROR("failed to close file {}: {}", metadata.file_name, strerror(errno));
+    /* plain file or manifest of incremental persistence */
+    if (!persistence.ReadFromDisk(metadata.file_name, address, metadata.size)) {
+        memfdFree(metadata, entry, true);
         return api::STATUS_UNKNOWN_ERROR;
     }
     auto time_val = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -147,5 +475,19 @@ int MemoryMonitor::TryLoadFromFile(const api::Metadata &metadata, api::DataEntry
 }
 
 MemoryStat MemoryMonitor::GetMemoryStat() {
-    return stat_;
+    MemoryStat stat;
+    stat.total_capacity = capacity_;
+    stat.total_idle = idle_;
+    stat.total_usage = usage_;
+    stat.total_max_usage = max_usage_;
+    stat.total_reclaimable = reclaimable_;
+    stat.self_total_usage = self_usage_;
+    for (auto &[node, usage] : node_usage_) {
+        NodeMemoryStat node_stat;
+        node_stat.node = node;
+        util::Numa::Meminfo(node, node_stat.capacity, node_stat.idle);
+        node_stat.self_usage = usage->bytes;
+        stat.nodes.push_back(node_stat);
+    }
+    return stat;
 }
@@ -0,0 +1,111 @@
+/**
+ * @file bandwidth_limiter.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "operator/bandwidth_limiter.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using operators::BandwidthLimiter;
+using operators::ByteTokenBucket;
+using operators::TrafficStage;
+
+std::string operators::TrafficStageString(TrafficStage stage) {
+    switch (stage) {
+    case TrafficStage::NODE:
+        return "node";
+    case TrafficStage::PERSIST:
+        return "persist";
+    case TrafficStage::BACKUP:
+        return "backup";
+    }
+    return "unknown";
+}
+
+bool operators::ParseTrafficStage(const std::string &str, TrafficStage &stage) {
+    for (auto s : {TrafficStage::NODE, TrafficStage::PERSIST, TrafficStage::BACKUP}) {
+        if (TrafficStageString(s) == str) {
+            stage = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::chrono::microseconds ByteTokenBucket::Reserve(size_t bytes) {
+    if (rate_ == 0) { /* fast path, unlimited */
+        return std::chrono::microseconds(0);
+    }
+
+    std::lock_guard<std::mutex> lock(mut_);
+    double rate = rate_;
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_).count();
+    tokens_ = std::min(rate, tokens_ + elapsed * rate); /* burst is one second */
+    last_ = now;
+
+    tokens_ -= bytes;
+    if (tokens_ >= 0) {
+        return std::chrono::microseconds(0);
+    }
+    return std::chrono::microseconds(static_cast<int64_t>(-tokens_ / rate * 1000000));
+}
+
+void ByteTokenBucket::SetRate(uint64_t rate) {
+    std::lock_guard<std::mutex> lock(mut_);
+    rate_ = rate;
+    tokens_ = rate;
+    last_ = std::chrono::steady_clock::now();
+}
+
+BandwidthLimiter::BandwidthLimiter() {
+    const char *keys[N_STAGES] = {config::ENV_KEY_NODE_BANDWIDTH_MB, config::ENV_KEY_PERSIST_BANDWIDTH_MB,
+                                  config::ENV_KEY_BACKUP_BANDWIDTH_MB};
+    for (int i = 0; i < N_STAGES; i++) {
+        auto stage = static_cast<TrafficStage>(i);
+        uint64_t mb = std::stoull(util::Util::GetEnv(keys[i], config::DEFAULT_BANDWIDTH_MB));
+        buckets_[i].SetRate(mb * 1024 * 1024);
+        throttled_us_[i] = std::make_unique<bvar::Adder<int64_t>>(
+            "ckpt_engine_throttle", TrafficStageString(stage) + "_us");
+        LOG_INFO("bandwidth budget of {}: {} MB/s", TrafficStageString(stage), mb == 0 ? "unlimited" : std::to_string(mb));
+    }
+}
+
+void BandwidthLimiter::Acquire(TrafficStage stage, size_t bytes) {
+    auto idx = static_cast<int>(stage);
+    auto node_idx = static_cast<int>(TrafficStage::NODE);
+    auto stage_wait = stage == TrafficStage::NODE ? std::chrono::microseconds(0) : buckets_[idx].Reserve(bytes);
+    auto node_wait = buckets_[node_idx].Reserve(bytes);
+    auto wait = std::max(stage_wait, node_wait);
+    if (wait.count() == 0) {
+        return;
+    }
+
+    LOG_TRACE("{} throttled {} microseconds for {} bytes", TrafficStageString(stage), wait.count(), bytes);
+    std::this_thread::sleep_for(wait);
+    *throttled_us_[idx] << wait.count();
+    if (stage != TrafficStage::NODE && node_wait.count() > 0) {
+        *throttled_us_[node_idx] << node_wait.count();
+    }
+}
+
+uint64_t BandwidthLimiter::GetRate(TrafficStage stage) {
+    return buckets_[static_cast<int>(stage)].GetRate();
+}
+
+void BandwidthLimiter::SetRate(TrafficStage stage, uint64_t rate) {
+    buckets_[static_cast<int>(stage)].SetRate(rate);
+    LOG_INFO("bandwidth budget of {} changed to {} bytes/s", TrafficStageString(stage), rate);
+}
@@ -0,0 +1,221 @@
+/**
+ * @file persist_queue.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "operator/persist_queue.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "config/config.h"
+#include "config/iteration_manager.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using operators::PersistQueue;
+using operators::PersistTask;
+
+int64_t PersistTask::ParseIteration(const std::string &iteration) {
+    if (iteration.empty() || !std::all_of(iteration.begin(), iteration.end(), ::isdigit)) {
+        return UNKNOWN_ITERATION;
+    }
+    try {
+        return std::stoll(iteration);
+    } catch (const std::out_of_range &) {
+        return UNKNOWN_ITERATION;
+    }
+}
+
+bool PersistQueue::Priority::operator()(const PersistTask &a, const PersistTask &b) const {
+    if (a.expedited != b.expedited) {
+        return a.expedited;
+    }
+    /* unknown iteration is -1, put it before all */
+    bool a_unknown = a.iteration == PersistTask::UNKNOWN_ITERATION;
+    bool b_unknown = b.iteration == PersistTask::UNKNOWN_ITERATION;
+    if (a_unknown != b_unknown) {
+        return a_unknown;
+    }
+    if (a.iteration != b.iteration) {
+        return a.iteration > b.iteration;
+    }
+    return a.seq < b.seq;
+}
+
+PersistQueue::PersistQueue() {
+    auto policy = util::Util::GetEnv(config::ENV_KEY_PERSIST_POLICY, config::PERSIST_POLICY_ALL);
+    if (policy != config::PERSIST_POLICY_ALL && policy != config::PERSIST_POLICY_LATEST) {
+        LOG_FATAL("persistence policy {} unsupported", policy);
+    }
+    skip_superseded_ = policy == config::PERSIST_POLICY_LATEST;
+    nthreads_ = std::max(std::stoi(util::Util::GetEnv(config::ENV_KEY_PERSIST_THREADS,
+                                                      config::DEFAULT_PERSIST_THREADS)), 1);
+    LOG_INFO("persistence policy {}, {} threads", policy, nthreads_);
+}
+
+void PersistQueue::SetHandler(std::function<bool(const PersistTask &)> handler) {
+    handler_ = std::move(handler);
+}
+
+void PersistQueue::SetAbortHandler(std::function<void(const std::string &)> handler,
+                                   std::function<void(const std::string &)> forget) {
+    abort_handler_ = std::move(handler);
+    forget_handler_ = std::move(forget);
+}
+
+void PersistQueue::SetIterationChecker(std::function<bool(int64_t)> checker) {
+    iteration_checker_ = std::move(checker);
+}
+
+void PersistQueue::Run() {
+    for (auto i = 0; i < nthreads_; i++) {
+        std::thread([this]() {
+            LOG_INFO("started persistence thread {}", util::Util::GetThreadID());
+            this->run();
+        }).detach();
+    }
+}
+
+void PersistQueue::run() {
+    while (true) {
+        PersistTask task;
+        {
+            std::unique_lock<std::mutex> lock(mut_);
+            cv_.wait(lock, [this]() { return !queue_.empty(); });
+            task = *queue_.begin();
+            queue_.erase(queue_.begin());
+            if (evicted(task.iteration)) {
+                LOG_INFO("skip persistence of {}, iteration {} has been evicted", task.key, task.iteration);
+                skipped_bytes_ << task.size;
+                continue;
+            }
+            inflight_[task.key] = task;
+        }
+
+        LOG_TRACE("persist {} of iteration {}", task.key, task.iteration);
+        bool ok = handler_(task);
+        if (!ok) {
+            LOG_ERROR("persistence of {} failed", task.key);
+        }
+
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(mut_);
+            inflight_.erase(task.key);
+            /* under the lock, or an abort by cancel() in between is left for the next task of the key */
+            if (aborting_.erase(task.key) > 0 && forget_handler_) {
+                forget_handler_(task.key);
+            }
+            last = pending(task.iteration) == 0;
+        }
+        done_cv_.notify_all();
+
+        /* only needed to supersede older iterations */
+        if (ok && last && skip_superseded_ && task.iteration != PersistTask::UNKNOWN_ITERATION
+            && iteration_checker_ && iteration_checker_(task.iteration)) {
+            Complete(task.iteration);
+        }
+    }
+}
+
+void PersistQueue::Push(const std::string &key, const std::string &iteration, size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        if (contains(key)) {
+            return;
+        }
+        queue_.insert(PersistTask{key, PersistTask::ParseIteration(iteration), size, seq_++, false});
+    }
+    cv_.notify_one();
+}
+
+bool PersistQueue::Contains(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mut_);
+    return contains(key);
+}
+
+bool PersistQueue::contains(const std::string &key) {
+    if (inflight_.count(key) > 0) {
+        return true;
+    }
+    return std::any_of(queue_.begin(), queue_.end(), [&key](const PersistTask &t) { return t.key == key; });
+}
+
+size_t PersistQueue::pending(int64_t iteration) {
+    auto n = std::count_if(queue_.begin(), queue_.end(),
+                           [iteration](const PersistTask &t) { return t.iteration == iteration; });
+    n += std::count_if(inflight_.begin(), inflight_.end(),
+                       [iteration](const auto &item) { return item.second.iteration == iteration; });
+    return n;
+}
+
+void PersistQueue::Complete(int64_t iteration) {
+    if (!skip_superseded_ || iteration == PersistTask::UNKNOWN_ITERATION) {
+        return;
+    }
+    LOG_INFO("iteration {} is persisted, older iterations are superseded", iteration);
+    std::lock_guard<std::mutex> lock(mut_);
+    cancel([iteration](int64_t i) { return i != PersistTask::UNKNOWN_ITERATION && i < iteration; }, "superseded");
+}
+
+void PersistQueue::Evict(int64_t iteration) {
+    std::unique_lock<std::mutex> lock(mut_);
+    cancel([iteration](int64_t i) { return i == iteration; }, "evicted");
+    /* caller frees memory afterwards, in-flight writes must have stopped reading it */
+    done_cv_.wait(lock, [this, iteration]() {
+        return std::none_of(inflight_.begin(), inflight_.end(),
+                            [iteration](const auto &item) { return item.second.iteration == iteration; });
+    });
+}
+
+void PersistQueue::Expedite(int64_t iteration) {
+    std::lock_guard<std::mutex> lock(mut_);
+    /* key of set is immutable, re-insert */
+    for (auto it = queue_.begin(); it != queue_.end();) {
+        if (it->iteration == iteration && !it->expedited) {
+            auto task = *it;
+            task.expedited = true;
+            it = queue_.erase(it);
+            queue_.insert(task);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void PersistQueue::cancel(const std::function<bool(int64_t)> &pred, const char *reason) {
+    for (auto it = queue_.begin(); it != queue_.end();) {
+        if (pred(it->iteration)) {
+            LOG_INFO("skip persistence of {}, iteration {} is {}", it->key, it->iteration, reason);
+            skipped_bytes_ << it->size;
+            it = queue_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto &[key, task] : inflight_) {
+        if (!pred(task.iteration) || aborting_.count(key) > 0) {
+            continue;
+        }
+        LOG_INFO("abort persistence of {}, iteration {} is {}", key, task.iteration, reason);
+        aborting_.insert(key);
+        aborted_bytes_ << task.size;
+        if (abort_handler_) {
+            abort_handler_(key);
+        }
+    }
+}
+
+bool PersistQueue::evicted(int64_t iteration) {
+    if (iteration == PersistTask::UNKNOWN_ITERATION) {
+        return false;
+    }
+    return !config::IterationManager::Instance().isExist(static_cast<size_t>(iteration));
+}
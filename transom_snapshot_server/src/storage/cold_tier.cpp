@@ -0,0 +1,224 @@
+/**
+ * @file cold_tier.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/cold_tier.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <vector>
+
+#include <openssl/sha.h>
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using storage::ColdTier;
+
+/**
+ * @brief copy [0, size) of in_fd to out_fd from its offset 0, by sendfile if supported
+ */
+static bool copyFile(int out_fd, int in_fd, size_t size) {
+    if (lseek(out_fd, 0, SEEK_SET) < 0) {
+        return false;
+    }
+    off_t offset = 0;
+    while (static_cast<size_t>(offset) < size) {
+        auto n = sendfile(out_fd, in_fd, &offset, size - offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+            break;
+        }
+        if (n <= 0) {
+            if (n == 0) {
+                errno = ENODATA;
+            }
+            return false;
+        }
+    }
+    /* buffered copy of what is left */
+    std::vector<char> buffer(std::min(size - offset, config::BANDWIDTH_CHUNK_SIZE));
+    while (static_cast<size_t>(offset) < size) {
+        auto len = std::min(size - offset, buffer.size());
+        if (!util::Util::PreadAll(in_fd, buffer.data(), len, offset)
+            || !util::Util::PwriteAll(out_fd, buffer.data(), len, offset)) {
+            return false;
+        }
+        offset += len;
+    }
+    return true;
+}
+
+ColdTier::ColdTier() {
+    auto dir = util::Util::GetEnv(config::ENV_KEY_COLD_TIER_DIR, "");
+    if (dir.empty()) {
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        LOG_FATAL("failed to create cold tier directory {}: {}", dir, ec.message());
+    }
+    /* spilled checkpoints of previous run are not referenced by anyone */
+    for (auto &file : std::filesystem::directory_iterator(dir, ec)) {
+        if (file.path().extension() == config::COLD_TIER_SUFFIX) {
+            std::filesystem::remove(file.path(), ec);
+        }
+    }
+
+    auto capacity = util::Util::GetEnv(config::ENV_KEY_COLD_TIER_GB, "");
+    if (capacity.empty()) {
+        struct statvfs st;
+        if (statvfs(dir.c_str(), &st) != 0) {
+            LOG_FATAL("failed to statvfs cold tier directory {}: {}", dir, strerror(errno));
+        }
+        capacity_ = static_cast<size_t>(st.f_bavail) * st.f_frsize / 10 * 9;
+    } else {
+        capacity_ = std::stoull(capacity) * 1024 * 1024 * 1024L;
+    }
+    dir_ = dir;
+    LOG_INFO("cold tier at {}, capacity {} GB", dir_, capacity_ >> 30);
+}
+
+std::string ColdTier::path(const std::string &file_name) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char *>(file_name.data()), file_name.size(), digest);
+    char hex[33];
+    for (int i = 0; i < 16; i++) {
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+    return dir_ + "/" + hex + config::COLD_TIER_SUFFIX;
+}
+
+void ColdTier::remove(std::map<std::string, Item>::iterator it) {
+    unlink(path(it->first).c_str());
+    used_ -= it->second.size;
+    used_bytes_ << -static_cast<int64_t>(it->second.size);
+    items_.erase(it);
+}
+
+bool ColdTier::Put(const std::string &file_name, int fd, size_t size, int64_t iteration,
+                   std::vector<std::string> &evicted) {
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        if (auto it = items_.find(file_name); it != items_.end()) {
+            remove(it);
+        }
+        if (size > capacity_) {
+            LOG_WARN("{} of {} bytes exceeds cold tier capacity {}", file_name, size, capacity_);
+            return false;
+        }
+        while (used_ + size > capacity_) {
+            auto victim = std::min_element(items_.begin(), items_.end(), [](const auto &a, const auto &b) {
+                if (a.second.iteration != b.second.iteration) {
+                    return a.second.iteration < b.second.iteration;
+                }
+                return a.second.access < b.second.access;
+            });
+            if (victim == items_.end() || victim->second.iteration > iteration) {
+                LOG_WARN("cold tier is full, used {} capacity {}, cannot spill {} of {} bytes",
+                         used_, capacity_, file_name, size);
+                return false;
+            }
+            LOG_INFO("evict {} of iteration {} from cold tier", victim->first, victim->second.iteration);
+            evict_bytes_ << victim->second.size;
+            evicted.push_back(victim->first);
+            remove(victim);
+        }
+        /* reserve space while writing */
+        used_ += size;
+        used_bytes_ << size;
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto file = path(file_name);
+    bool ok = false;
+    int out = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        LOG_ERROR("failed to open file {} error: {}", file, strerror(errno));
+    } else {
+        /* dirty or cached pages are charged to our cgroup, write back and drop them */
+        ok = copyFile(out, fd, size) && fdatasync(out) == 0;
+        if (!ok) {
+            LOG_ERROR("failed to spill {} to {}: {}", file_name, file, strerror(errno));
+        } else {
+            posix_fadvise(out, 0, size, POSIX_FADV_DONTNEED);
+        }
+        close(out);
+    }
+
+    std::lock_guard<std::mutex> lock(mut_);
+    if (!ok) {
+        unlink(file.c_str());
+        used_ -= size;
+        used_bytes_ << -static_cast<int64_t>(size);
+        return false;
+    }
+    items_[file_name] = Item{size, iteration, clock_++};
+    spill_bytes_ << size;
+    auto timeval = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - start_time);
+    LOG_INFO("spilled {} of {} bytes to cold tier use {} milliseconds, used {} capacity {}",
+             file_name, size, timeval.count(), used_, capacity_);
+    return true;
+}
+
+bool ColdTier::Get(const std::string &file_name, char *data, size_t size) {
+    std::string file;
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        auto it = items_.find(file_name);
+        if (it == items_.end() || it->second.size != size) {
+            LOG_ERROR("{} of {} bytes not found in cold tier", file_name, size);
+            return false;
+        }
+        it->second.access = clock_++;
+        file = path(file_name);
+    }
+    /* once opened, it's still readable if evicted meanwhile */
+    int in = open(file.c_str(), O_RDONLY);
+    if (in < 0) {
+        LOG_ERROR("failed to open file {} error: {}", file, strerror(errno));
+        return false;
+    }
+    posix_fadvise(in, 0, size, POSIX_FADV_SEQUENTIAL);
+    bool ok = util::Util::PreadAll(in, data, size, 0);
+    if (!ok) {
+        LOG_ERROR("failed to read {} from {}: {}", file_name, file, strerror(errno));
+    } else {
+        posix_fadvise(in, 0, size, POSIX_FADV_DONTNEED);
+        rehydrate_bytes_ << size;
+    }
+    close(in);
+    return ok;
+}
+
+size_t ColdTier::Size(const std::string &file_name) {
+    std::lock_guard<std::mutex> lock(mut_);
+    auto it = items_.find(file_name);
+    return it == items_.end() ? 0 : it->second.size;
+}
+
+void ColdTier::Remove(const std::string &file_name) {
+    std::lock_guard<std::mutex> lock(mut_);
+    if (auto it = items_.find(file_name); it != items_.end()) {
+        remove(it);
+    }
+}
@@ -0,0 +1,333 @@
+/**
+ * @file compression.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/compression.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+
+#include <zstd.h>
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using storage::SeekableZstd;
+
+/* refer to https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md */
+static constexpr uint32_t SEEKABLE_MAGIC = 0x8F92EAB1;
+static constexpr uint32_t SKIPPABLE_SEEK_TABLE_MAGIC = 0x184D2A5E;
+static constexpr size_t SEEKABLE_FOOTER_SIZE = 9;
+static constexpr size_t SKIPPABLE_HEADER_SIZE = 8;
+static constexpr uint8_t SEEKABLE_CHECKSUM_FLAG = 0x80;
+static constexpr uint8_t SEEKABLE_RESERVED_BITS = 0x7c;
+
+static void putLE32(std::string &out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<char>((v >> (8 * i)) & 0xff));
+    }
+}
+
+static uint32_t getLE32(const char *in) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        v |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    }
+    return v;
+}
+
+/* contexts are expensive to create, keep one per worker */
+static ZSTD_CCtx *threadCCtx() {
+    thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    return cctx.get();
+}
+
+static ZSTD_DCtx *threadDCtx() {
+    thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx(ZSTD_createDCtx(), ZSTD_freeDCtx);
+    return dctx.get();
+}
+
+SeekableZstd::SeekableZstd(int level, size_t frame_size) {
+    level_ = std::min(std::max(level, ZSTD_minCLevel()), ZSTD_maxCLevel());
+    /* seek table stores sizes in 32 bits, compressed size may be a little larger than input */
+    frame_size_ = std::min(std::max(frame_size, 1UL << 16), 1UL << 30);
+}
+
+double SeekableZstd::ratio(void *arg) {
+    auto self = static_cast<SeekableZstd *>(arg);
+    auto output = self->output_bytes_.get_value();
+    return output > 0 ? static_cast<double>(self->input_bytes_.get_value()) / output : 0;
+}
+
+bool SeekableZstd::Write(const std::string &file_name, const void *data, size_t size, util::ThreadPool &pool,
+                         const std::function<bool(size_t)> &throttle) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto base = static_cast<const char *>(data);
+    size_t frame_count = (size + frame_size_ - 1) / frame_size_;
+
+    auto tmp_name = file_name + config::PERSIST_TMP_SUFFIX;
+    int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("failed to open file {} error: {}, you may not have permission to create it",
+                  tmp_name, strerror(errno));
+        return false;
+    }
+
+    /*
+     * compress a batch of frames concurrently while the previous batch is written,
+     * memory is bounded by two batches of compressed frames
+     */
+    size_t batch = pool.Size() * 2;
+    std::vector<std::string> buffers[2] = {std::vector<std::string>(batch), std::vector<std::string>(batch)};
+    auto compressBatch = [&](size_t first, std::vector<std::string> &out) {
+        std::vector<std::future<bool>> futures;
+        for (size_t k = 0; k < batch && first + k < frame_count; k++) {
+            futures.push_back(pool.Submit([&, first, k]() -> bool {
+                size_t offset = (first + k) * frame_size_;
+                size_t len = std::min(frame_size_, size - offset);
+                auto cctx = threadCCtx();
+                ZSTD_CCtx_reset(cctx, ZSTD_reset_session_only);
+                ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level_);
+                ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+                out[k].resize(ZSTD_compressBound(len));
+                auto rc = ZSTD_compress2(cctx, out[k].data(), out[k].size(), base + offset, len);
+                if (ZSTD_isError(rc)) {
+                    LOG_ERROR("compress frame {} of {} failed: {}", first + k, file_name, ZSTD_getErrorName(rc));
+                    return false;
+                }
+                out[k].resize(rc);
+                return true;
+            }));
+        }
+        return futures;
+    };
+    auto wait = [](std::vector<std::future<bool>> &futures) -> bool {
+        bool ok = true;
+        for (auto &f : futures) {
+            ok = f.get() && ok;
+        }
+        return ok;
+    };
+
+    std::string seek_table;
+    uint64_t written = 0;
+    bool ok = true;
+    auto current = compressBatch(0, buffers[0]);
+    for (size_t first = 0, idx = 0; first < frame_count; first += batch, idx ^= 1) {
+        ok = wait(current) && ok;
+        current.clear();
+        if (!ok) {
+            break;
+        }
+        if (first + batch < frame_count) {
+            current = compressBatch(first + batch, buffers[idx ^ 1]);
+        }
+        for (size_t k = 0; k < batch && first + k < frame_count; k++) {
+            auto &frame = buffers[idx][k];
+            if (!throttle(frame.size())) {
+                ok = false;
+                break;
+            }
+            if (!util::Util::PwriteAll(fd, frame.data(), frame.size(), written)) {
+                LOG_ERROR("write frame {} of {} failed: {}", first + k, tmp_name, strerror(errno));
+                ok = false;
+                break;
+            }
+            written += frame.size();
+            putLE32(seek_table, static_cast<uint32_t>(frame.size()));
+            putLE32(seek_table, static_cast<uint32_t>(std::min(frame_size_, size - (first + k) * frame_size_)));
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    /* buffers must outlive in-flight tasks */
+    wait(current);
+
+    if (ok) {
+        /* skippable frame wrapping seek table entries and footer */
+        std::string table;
+        putLE32(table, SKIPPABLE_SEEK_TABLE_MAGIC);
+        putLE32(table, static_cast<uint32_t>(seek_table.size() + SEEKABLE_FOOTER_SIZE));
+        table += seek_table;
+        putLE32(table, static_cast<uint32_t>(frame_count));
+        table.push_back(0); /* descriptor, no per-frame checksum since frames carry their own */
+        putLE32(table, SEEKABLE_MAGIC);
+        if (!util::Util::PwriteAll(fd, table.data(), table.size(), written)) {
+            LOG_ERROR("write seek table of {} failed: {}", tmp_name, strerror(errno));
+            ok = false;
+        }
+        written += table.size();
+    }
+    if (ok && fsync(fd) != 0) {
+        LOG_ERROR("failed to fsync file {}: {}", tmp_name, strerror(errno));
+        ok = false;
+    }
+    if (close(fd) != 0 && ok) {
+        LOG_ERROR("failed to close file {}: {}", tmp_name, strerror(errno));
+        ok = false;
+    }
+    if (ok && rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+        LOG_ERROR("failed to rename {} to {}: {}", tmp_name, file_name, strerror(errno));
+        ok = false;
+    }
+    if (!ok) {
+        unlink(tmp_name.c_str());
+        return false;
+    }
+
+    input_bytes_ << size;
+    output_bytes_ << written;
+    auto timeval = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - start_time);
+    double throughput = timeval.count() > 0 ? static_cast<double>(size) / timeval.count() * 1000000 / 1048576 : 0;
+    LOG_INFO("compress {}: {} bytes to {} bytes in {} frames, ratio {:.2f}, {:.2f} MB/s",
+             file_name, size, written, frame_count, written > 0 ? static_cast<double>(size) / written : 0, throughput);
+    return true;
+}
+
+bool SeekableZstd::Detect(int fd) {
+    struct stat sb;
+    if (fstat(fd, &sb) != 0 || static_cast<size_t>(sb.st_size) < SKIPPABLE_HEADER_SIZE + SEEKABLE_FOOTER_SIZE) {
+        return false;
+    }
+    char magic[4];
+    if (!util::Util::PreadAll(fd, magic, sizeof(magic), sb.st_size - sizeof(magic))) {
+        return false;
+    }
+    return getLE32(magic) == SEEKABLE_MAGIC;
+}
+
+bool SeekableZstd::readSeekTable(const std::string &file_name, int fd, std::vector<Frame> &frames) {
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) {
+        LOG_ERROR("failed to stat {}: {}", file_name, strerror(errno));
+        return false;
+    }
+    size_t file_size = sb.st_size;
+    char footer[SEEKABLE_FOOTER_SIZE];
+    if (file_size < SKIPPABLE_HEADER_SIZE + SEEKABLE_FOOTER_SIZE
+        || !util::Util::PreadAll(fd, footer, sizeof(footer), file_size - sizeof(footer))) {
+        LOG_ERROR("failed to read seek table footer of {}", file_name);
+        return false;
+    }
+    uint32_t frame_count = getLE32(footer);
+    uint8_t descriptor = static_cast<uint8_t>(footer[4]);
+    if (getLE32(footer + 5) != SEEKABLE_MAGIC || (descriptor & SEEKABLE_RESERVED_BITS) != 0) {
+        LOG_ERROR("{} is not in seekable format", file_name);
+        return false;
+    }
+
+    size_t entry_size = (descriptor & SEEKABLE_CHECKSUM_FLAG) ? 12 : 8;
+    size_t table_size = SKIPPABLE_HEADER_SIZE + frame_count * entry_size + SEEKABLE_FOOTER_SIZE;
+    if (table_size > file_size) {
+        LOG_ERROR("seek table of {} is larger than file", file_name);
+        return false;
+    }
+    std::string table(table_size, '\0');
+    if (!util::Util::PreadAll(fd, table.data(), table.size(), file_size - table_size)) {
+        LOG_ERROR("failed to read seek table of {}: {}", file_name, strerror(errno));
+        return false;
+    }
+    if (getLE32(table.data()) != SKIPPABLE_SEEK_TABLE_MAGIC
+        || getLE32(table.data() + 4) != table_size - SKIPPABLE_HEADER_SIZE) {
+        LOG_ERROR("seek table of {} is broken", file_name);
+        return false;
+    }
+
+    frames.clear();
+    frames.reserve(frame_count);
+    uint64_t compressed_offset = 0;
+    uint64_t decompressed_offset = 0;
+    for (uint32_t i = 0; i < frame_count; i++) {
+        auto entry = table.data() + SKIPPABLE_HEADER_SIZE + i * entry_size;
+        Frame frame;
+        frame.compressed_offset = compressed_offset;
+        frame.compressed_size = getLE32(entry);
+        frame.decompressed_offset = decompressed_offset;
+        frame.decompressed_size = getLE32(entry + 4);
+        compressed_offset += frame.compressed_size;
+        decompressed_offset += frame.decompressed_size;
+        frames.push_back(frame);
+    }
+    if (compressed_offset + table_size != file_size) {
+        LOG_ERROR("frames of {} do not match its seek table", file_name);
+        return false;
+    }
+    return true;
+}
+
+bool SeekableZstd::Read(const std::string &file_name, int fd, size_t offset, size_t length, void *data,
+                        util::ThreadPool &pool) {
+    std::vector<Frame> frames;
+    if (!readSeekTable(file_name, fd, std::ref(frames))) {
+        return false;
+    }
+    uint64_t total = frames.empty() ? 0 : frames.back().decompressed_offset + frames.back().decompressed_size;
+    if (offset + length > total) {
+        LOG_ERROR("read [{}, {}) out of range of {}, which has {} bytes", offset, offset + length, file_name, total);
+        return false;
+    }
+
+    /* frames overlapping [offset, offset + length) */
+    auto first = std::upper_bound(frames.begin(), frames.end(), offset, [](size_t off, const Frame &f) {
+                     return off < f.decompressed_offset;
+                 })
+                 - frames.begin() - 1;
+    auto out = static_cast<char *>(data);
+    std::atomic<bool> failed(false);
+    std::vector<std::future<void>> futures;
+    for (size_t i = std::max(first, 0L); i < frames.size() && frames[i].decompressed_offset < offset + length; i++) {
+        futures.push_back(pool.Submit([&, i]() {
+            auto &frame = frames[i];
+            std::string compressed(frame.compressed_size, '\0');
+            if (!util::Util::PreadAll(fd, compressed.data(), compressed.size(), frame.compressed_offset)) {
+                LOG_ERROR("failed to read frame {} of {}: {}", i, file_name, strerror(errno));
+                failed = true;
+                return;
+            }
+
+            /* decompress in place if the frame is fully requested, otherwise through a scratch buffer */
+            size_t begin = std::max(static_cast<uint64_t>(offset), frame.decompressed_offset);
+            size_t end = std::min(static_cast<uint64_t>(offset + length), frame.decompressed_offset + frame.decompressed_size);
+            bool whole = begin == frame.decompressed_offset && end - begin == frame.decompressed_size;
+            std::string scratch;
+            char *dst = out + (begin - offset);
+            if (!whole) {
+                scratch.resize(frame.decompressed_size);
+                dst = scratch.data();
+            }
+            auto rc = ZSTD_decompressDCtx(threadDCtx(), dst, frame.decompressed_size, compressed.data(), compressed.size());
+            if (ZSTD_isError(rc) || rc != frame.decompressed_size) {
+                LOG_ERROR("decompress frame {} of {} failed: {}", i, file_name,
+                          ZSTD_isError(rc) ? ZSTD_getErrorName(rc) : "size mismatch");
+                failed = true;
+                return;
+            }
+            if (!whole) {
+                memcpy(out + (begin - offset), scratch.data() + (begin - frame.decompressed_offset), end - begin);
+            }
+        }));
+    }
+    for (auto &f : futures) {
+        f.wait();
+    }
+    return !failed;
+}
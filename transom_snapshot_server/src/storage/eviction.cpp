@@ -0,0 +1,250 @@
+/**
+ * @file eviction.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/eviction.h"
+
+#include <chrono>
+#include <thread>
+
+#include "config/config.h"
+#include "config/iteration_manager.h"
+#include "config/world.h"
+#include "logger/logger.h"
+#include "operator/persist_queue.h"
+#include "storage/metadata.h"
+#include "storage/storage.h"
+#include "util/util.h"
+
+using storage::CostEvictionPolicy;
+using storage::EvictionPolicyFactory;
+using storage::Evictor;
+using storage::FifoEvictionPolicy;
+using storage::IterationStat;
+using config::IterationManager;
+using config::WorldState;
+
+std::string FifoEvictionPolicy::Name() const {
+    return config::EVICTION_POLICY_FIFO;
+}
+
+double FifoEvictionPolicy::Score(const IterationStat &stat) const {
+    return stat.age;
+}
+
+std::string CostEvictionPolicy::Name() const {
+    return config::EVICTION_POLICY_COST;
+}
+
+double CostEvictionPolicy::Score(const IterationStat &stat) const {
+    double score = stat.age * config::EVICTION_WEIGHT_AGE;
+    score += static_cast<double>(stat.bytes) / (1024 * 1024 * 1024L) * config::EVICTION_WEIGHT_GB;
+    if (stat.persistent) {
+        score += config::EVICTION_WEIGHT_PERSISTENT;
+    }
+    return score;
+}
+
+std::unique_ptr<storage::EvictionPolicy> EvictionPolicyFactory::Create() {
+    auto policy = util::Util::GetEnv(config::ENV_KEY_EVICTION_POLICY, config::EVICTION_POLICY_COST);
+    if (policy == config::EVICTION_POLICY_FIFO) {
+        return std::make_unique<FifoEvictionPolicy>();
+    }
+    if (policy != config::EVICTION_POLICY_COST) {
+        LOG_WARN("unknown eviction policy {}, use {}", policy, config::EVICTION_POLICY_COST);
+    }
+    return std::make_unique<CostEvictionPolicy>();
+}
+
+Evictor::Evictor() {
+    policy_ = EvictionPolicyFactory::Create();
+    auto budget = util::Util::GetEnv(config::ENV_KEY_EVICTION_BUDGET_GB);
+    budget_ = budget.size() == 0 ? 0 : std::stoull(budget) * 1024 * 1024 * 1024L;
+    LOG_INFO("eviction policy {}, max iterations {}, memory budget {} bytes", policy_->Name(),
+             IterationManager::Instance().maxIteration(), budget_);
+}
+
+void Evictor::SetHandler(std::function<bool(size_t)> handler) {
+    std::lock_guard<std::mutex> lock(mut_);
+    handler_ = std::move(handler);
+}
+
+void Evictor::Start() {
+    std::thread([this]() {
+        run();
+    }).detach();
+}
+
+void Evictor::Notify() {
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        wake_ = true;
+    }
+    cv_.notify_one();
+}
+
+void Evictor::Pin(const std::string &tag, size_t iteration) {
+    std::lock_guard<std::mutex> lock(mut_);
+    pins_[tag] = iteration;
+    LOG_INFO("iteration {} is pinned by {}", iteration, tag);
+}
+
+bool Evictor::Unpin(const std::string &tag) {
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        auto it = pins_.find(tag);
+        if (it == pins_.end()) {
+            return false;
+        }
+        LOG_INFO("iteration {} is unpinned by {}", it->second, tag);
+        pins_.erase(it);
+    }
+    /* it may be the only candidate */
+    Notify();
+    return true;
+}
+
+std::map<std::string, size_t> Evictor::Pins() {
+    std::lock_guard<std::mutex> lock(mut_);
+    return pins_;
+}
+
+bool Evictor::pinned(size_t iteration) {
+    std::lock_guard<std::mutex> lock(mut_);
+    for (auto &[tag, pinned] : pins_) {
+        if (pinned == iteration) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Evictor::run() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mut_);
+            cv_.wait_for(lock, std::chrono::seconds(config::EVICTION_PERIOD_SECONDS), [this]() {
+                return wake_;
+            });
+            wake_ = false;
+            if (!handler_) {
+                continue;
+            }
+        }
+        evict();
+    }
+}
+
+bool Evictor::collect(std::map<size_t, IterationStat> &stats, std::map<size_t, bool> &settled) {
+    api::BatchLoadFilter filter(WorldState::Instance().NodeRank());
+    std::vector<api::Metadata> vec;
+    auto meta_client = storage::MetadataClientFactory::GetClient();
+    if (meta_client->BatchLoad(filter, vec) == api::STATUS_UNKNOWN_ERROR) {
+        LOG_ERROR("load metadata of node {} for eviction failed", WorldState::Instance().NodeRank());
+        return false;
+    }
+    bool single = WorldState::Instance().WorldSize() < 2;
+    for (auto &metadata : vec) {
+        auto iteration = operators::PersistTask::ParseIteration(metadata.iteration);
+        if (iteration == operators::PersistTask::UNKNOWN_ITERATION || stats.count(iteration) == 0) {
+            continue;
+        }
+        auto &stat = stats[iteration];
+        if (stat.files == 0) {
+            stat.persistent = true;
+            settled[iteration] = true;
+        }
+        stat.files++;
+        switch (metadata.state) {
+        case api::CheckpointState::PERSISTENT:
+            break;
+        case api::CheckpointState::BACKED_UP:
+            stat.persistent = false;
+            break;
+        case api::CheckpointState::CACHED:
+            /* without backup, the only copy is in memory until it's persistent */
+            stat.persistent = false;
+            settled[iteration] = settled[iteration] && single;
+            break;
+        case api::CheckpointState::PENDING:
+            stat.persistent = false;
+            settled[iteration] = false;
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+size_t Evictor::evict() {
+    auto &iterations = IterationManager::Instance();
+    std::function<bool(size_t)> handler;
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        handler = handler_;
+    }
+    size_t evicted = 0;
+    while (true) {
+        auto cached = iterations.iterations();
+        /* the latest one is being saved */
+        if (cached.size() < 2) {
+            return evicted;
+        }
+        auto bytes = Storage::Instance().IterationBytes();
+        std::map<size_t, IterationStat> stats;
+        size_t total = 0;
+        for (auto iteration : cached) {
+            auto &stat = stats[iteration];
+            stat.iteration = iteration;
+            stat.age = *cached.rbegin() - iteration;
+            stat.bytes = bytes[iteration];
+            total += stat.bytes;
+        }
+        bool over_count = cached.size() > iterations.maxIteration();
+        bool over_budget = budget_ > 0 && total > budget_;
+        if (!over_count && !over_budget) {
+            return evicted;
+        }
+
+        std::map<size_t, bool> settled;
+        if (!collect(std::ref(stats), std::ref(settled))) {
+            return evicted;
+        }
+        const IterationStat *victim = nullptr;
+        double victim_score = 0;
+        for (auto &[iteration, stat] : stats) {
+            if (iteration == *cached.rbegin() || stat.files == 0 || !settled[iteration] || pinned(iteration)) {
+                continue;
+            }
+            auto score = policy_->Score(stat);
+            if (victim == nullptr || score > victim_score) {
+                victim = &stat;
+                victim_score = score;
+            }
+        }
+        if (victim == nullptr) {
+            LOG_WARN("{} iterations hold {} bytes, exceeding limits, but none can be evicted", cached.size(), total);
+            blocked_ << 1;
+            return evicted;
+        }
+
+        LOG_INFO("evict iteration {} of {} files {} bytes with score {}, {} iterations hold {} bytes",
+                 victim->iteration, victim->files, victim->bytes, victim_score, cached.size(), total);
+        if (!handler(victim->iteration)) {
+            LOG_ERROR("evict iteration {} failed", victim->iteration);
+            return evicted;
+        }
+        iterations.deleteIteration(victim->iteration);
+        evicted_ << 1;
+        evicted_bytes_ << victim->bytes;
+        evicted++;
+    }
+}
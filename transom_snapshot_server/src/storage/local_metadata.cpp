@@ -0,0 +1,246 @@
+/**
+ * @file local_metadata.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/local_metadata.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <mutex>
+
+#include "config/config.h"
+#include "logger/logger.h"
+
+using storage::LocalMetadataStore;
+using storage::MetadataLog;
+
+LocalMetadataStore::~LocalMetadataStore() {
+    if (lock_fd_ >= 0) {
+        close(lock_fd_);
+    }
+}
+
+bool LocalMetadataStore::Open() {
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    auto &path = log_.Path();
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    if (ec) {
+        LOG_ERROR("failed to create directory of metadata store {}: {}", path, ec.message());
+        return false;
+    }
+    auto lock_path = path + ".lock";
+    lock_fd_ = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock_fd_ < 0 || flock(lock_fd_, LOCK_EX | LOCK_NB) != 0) {
+        LOG_ERROR("lock metadata store {} failed, is it used by another server? {}", path, strerror(errno));
+        return false;
+    }
+
+    records_ = MetadataLog::Replay(path, [this](MetadataLog::Op op, api::Metadata &metadata) {
+        apply(op, metadata);
+    });
+    if (!log_.Open()) {
+        return false;
+    }
+    LOG_INFO("metadata store {} opens with {} rows of {} records", path, rows_.size(), records_);
+    compact();
+    return true;
+}
+
+void LocalMetadataStore::index(const api::Metadata &metadata) {
+    by_rank_[metadata.node_rank].insert(metadata.file_name);
+    by_iteration_[metadata.iteration].insert(metadata.file_name);
+    by_state_[metadata.state].insert(metadata.file_name);
+}
+
+void LocalMetadataStore::unindex(const api::Metadata &metadata) {
+    auto erase = [&metadata](auto &index, const auto &key) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return;
+        }
+        it->second.erase(metadata.file_name);
+        if (it->second.empty()) {
+            index.erase(it);
+        }
+    };
+    erase(by_rank_, metadata.node_rank);
+    erase(by_iteration_, metadata.iteration);
+    erase(by_state_, static_cast<int>(metadata.state));
+}
+
+void LocalMetadataStore::apply(MetadataLog::Op op, const api::Metadata &metadata) {
+    if (auto it = rows_.find(metadata.file_name); it != rows_.end()) {
+        unindex(it->second);
+        rows_.erase(it);
+    }
+    if (op == MetadataLog::SAVE) {
+        /* job name is not stored, like database */
+        api::Metadata row("", metadata.file_name, metadata.node_rank, metadata.iteration, metadata.state,
+                          metadata.size);
+        index(row);
+        rows_.emplace(row.file_name, row);
+    }
+}
+
+void LocalMetadataStore::compact() {
+    if (records_ < rows_.size() + config::META_LOCAL_COMPACT_RECORDS) {
+        return;
+    }
+    std::vector<MetadataLog::Record> records;
+    records.reserve(rows_.size());
+    for (auto &[file_name, metadata] : rows_) {
+        records.emplace_back(MetadataLog::SAVE, metadata);
+    }
+    if (!log_.Rewrite(records)) {
+        LOG_ERROR("compact metadata store {} failed", log_.Path());
+        return;
+    }
+    LOG_INFO("compact metadata store {} from {} records to {}", log_.Path(), records_, records.size());
+    records_ = records.size();
+}
+
+int LocalMetadataStore::write(const std::vector<MetadataLog::Record> &records) {
+    if (records.empty()) {
+        return api::STATUS_SUCCESS;
+    }
+    if (!log_.Append(records, true)) {
+        LOG_ERROR("append {} records to metadata store {} failed: {}", records.size(), log_.Path(), strerror(errno));
+        return api::STATUS_UNKNOWN_ERROR;
+    }
+    for (auto &[op, metadata] : records) {
+        apply(op, metadata);
+    }
+    records_ += records.size();
+    compact();
+    return api::STATUS_SUCCESS;
+}
+
+int LocalMetadataStore::Save(api::Metadata &metadata) {
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    return write({{MetadataLog::SAVE, metadata}});
+}
+
+int LocalMetadataStore::BatchSave(std::vector<api::Metadata> &vec) {
+    std::vector<MetadataLog::Record> records;
+    records.reserve(vec.size());
+    for (auto &metadata : vec) {
+        records.emplace_back(MetadataLog::SAVE, metadata);
+    }
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    return write(records);
+}
+
+int LocalMetadataStore::Load(api::Metadata &metadata) {
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    auto it = rows_.find(metadata.file_name);
+    if (it == rows_.end()) {
+        LOG_WARN("query primary key {}, not found in metadata store", metadata.file_name);
+        return api::STATUS_NOT_FOUND;
+    }
+    metadata.node_rank = it->second.node_rank;
+    metadata.iteration = it->second.iteration;
+    metadata.state = it->second.state;
+    metadata.size = it->second.size;
+    return api::STATUS_SUCCESS;
+}
+
+int LocalMetadataStore::UpdateState(const std::string &file_name, const api::CheckpointState &state) {
+    return BatchUpdateState({file_name}, state);
+}
+
+int LocalMetadataStore::BatchUpdateState(const std::vector<std::string> &file_names,
+                                         const api::CheckpointState &state) {
+    std::vector<MetadataLog::Record> records;
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    for (auto &file_name : file_names) {
+        auto it = rows_.find(file_name);
+        /* updating nothing is not an error, like database */
+        if (it == rows_.end()) {
+            continue;
+        }
+        api::Metadata metadata(it->second);
+        metadata.state = state;
+        records.emplace_back(MetadataLog::SAVE, metadata);
+    }
+    return write(records);
+}
+
+int LocalMetadataStore::DeleteByFileName(const std::string &file_name) {
+    return BatchDelete({file_name});
+}
+
+int LocalMetadataStore::BatchDelete(const std::vector<std::string> &file_names) {
+    std::vector<MetadataLog::Record> records;
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    for (auto &file_name : file_names) {
+        if (rows_.count(file_name) > 0) {
+            records.emplace_back(MetadataLog::DELETE, api::Metadata("", file_name));
+        }
+    }
+    return write(records);
+}
+
+int LocalMetadataStore::BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) {
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    /* scan the smallest index among conditions of filter */
+    const std::set<std::string> *candidates = nullptr;
+    bool any = true;
+    auto narrow = [&candidates, &any](const auto &index, const auto &key) {
+        any = false;
+        auto it = index.find(key);
+        static const std::set<std::string> none;
+        auto &found = it == index.end() ? none : it->second;
+        if (candidates == nullptr || found.size() < candidates->size()) {
+            candidates = &found;
+        }
+    };
+    if (filter.node_rank >= 0) {
+        narrow(by_rank_, filter.node_rank);
+    }
+    if (!filter.iteration.empty()) {
+        narrow(by_iteration_, filter.iteration);
+    }
+    if (filter.state >= api::CheckpointState::PENDING && filter.state < api::CheckpointState::STATE_NUM) {
+        narrow(by_state_, static_cast<int>(filter.state));
+    }
+
+    size_t found = 0;
+    if (any) {
+        for (auto &[file_name, metadata] : rows_) {
+            vec.push_back(metadata);
+            found++;
+        }
+    } else {
+        for (auto &file_name : *candidates) {
+            auto &metadata = rows_.at(file_name);
+            if (filter.Match(metadata)) {
+                vec.push_back(metadata);
+                found++;
+            }
+        }
+    }
+    return found == 0 ? api::STATUS_NOT_FOUND : api::STATUS_SUCCESS;
+}
+
+bool LocalMetadataStore::Contains(const std::string &file_name) {
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    return rows_.count(file_name) > 0;
+}
+
+size_t LocalMetadataStore::Size() {
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    return rows_.size();
+}
@@ -11,195 +11,426 @@
 
 #include "storage/metadata.h"
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include "mysql/mysql.h"
 
-static std::once_flag once_flag;
+#include "config/world.h"
+#include "storage/local_metadata.h"
+#include "storage/metadata_cache.h"
+#include "storage/mysql_pool.h"
 
+using storage::CachedClient;
+using storage::LocalClient;
+using storage::LocalMetadataStore;
 using storage::MetaClient;
+using storage::MetadataCache;
 using storage::MysqlClient;
 using storage::TransomServiceClient;
 using storage::MetadataClientFactory;
+using storage::MysqlConnectionPool;
 
 std::shared_ptr<MetaClient> MetadataClientFactory::GetClient() {
+    if (MetadataCache::Instance().Running()) {
+        return std::make_shared<CachedClient>();
+    }
+    return GetDatabaseClient();
+}
+
+std::shared_ptr<MetaClient> MetadataClientFactory::GetDatabaseClient() {
     auto option = util::Util::GetEnv(config::ENV_KEY_META_CLIENT, config::META_CLIENT_MYSQL);
     if (option == config::META_CLIENT_MYSQL) {
         return std::make_shared<MysqlClient>();
     }
+    if (option == config::META_CLIENT_LOCAL) {
+        return std::make_shared<LocalClient>();
+    }
+    if (option == config::META_CLIENT_TRANSOM) {
+        return std::make_shared<TransomServiceClient>();
+    }
     LOG_FATAL("meta client config {} unsupported", option);
 }
 
-MysqlClient::MysqlClient() {
-    db_addr_ = util::Util::GetEnv(config::ENV_KEY_MYSQL_ADDR, "0.0.0.0");
-    db_port_ = std::atoi(util::Util::GetEnv(config::ENV_KEY_MYSQL_PORT, "3306").c_str());
-    db_user_ = util::Util::GetEnv(config::ENV_KEY_MYSQL_USER, "root");
-    db_password_ = util::Util::GetEnv(config::ENV_KEY_MYSQL_PASSWORD);
-
-    // hardcode db name
-    db_name_ = std::string("engine");
-
-    sql_ = nullptr;
-    rw_mutex_.lock();
-    sql_ = mysql_init(sql_);
-    rw_mutex_.unlock();
-    if (!sql_) {
-        LOG_FATAL("cannot init mysql: {}", mysql_error(sql_));
+int MetaClient::BatchSave(std::vector<api::Metadata> &vec) {
+    for (auto &metadata : vec) {
+        auto rc = Save(metadata);
+        if (!api::IsSuccess(rc)) {
+            return rc;
+        }
     }
-    if (!mysql_real_connect(sql_, db_addr_.c_str(), db_user_.c_str(), db_password_.c_str(),
-                            db_name_.c_str(), db_port_, nullptr, 0)) {
-        LOG_FATAL("cannot connect to mysql: {}", mysql_error(sql_));
+    return api::STATUS_SUCCESS;
+}
+
+int MetaClient::BatchDelete(const std::vector<std::string> &file_names) {
+    for (auto &file_name : file_names) {
+        auto rc = DeleteByFileName(file_name);
+        if (!api::IsSuccess(rc)) {
+            return rc;
+        }
     }
+    return api::STATUS_SUCCESS;
+}
 
-    std::call_once(once_flag, [this]() {
-        std::string createCmd = "CREATE TABLE IF NOT EXISTS " + std::string(config::MYSQL_TABLE_NAME)
-                                + " (FILE_NAME   varchar(512)   PRIMARY KEY     NOT NULL,"
-                                  "  NODE_RANK   INT                            NOT NULL,"
-                                  "  ITERATION   TEXT                           NOT NULL,"
-                                  "  STATE       INT                            NOT NULL,"
-                                  "  SIZE        BIGINT UNSIGNED                NOT NULL);";
-
-        int ret = mysql_query(sql_, createCmd.c_str());
-        if (ret) {
-            LOG_FATAL("create table failed: {}", mysql_error(sql_));
-        }
-        LOG_TRACE("Table {} created successfully", config::MYSQL_TABLE_NAME);
-
-        if (util::Util::GetEnv(config::ENV_KEY_MYSQL_FLUSH_TABLE, "false") == "true") {
-            std::string delete_cmd = "DELETE FROM " + std::string(config::MYSQL_TABLE_NAME) + " ;";
-            ret = mysql_query(sql_, delete_cmd.c_str());
-            if (ret) {
-                LOG_FATAL("create table failed: {}", mysql_error(sql_));
-            }
+int MetaClient::BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) {
+    for (auto &file_name : file_names) {
+        auto rc = UpdateState(file_name, state);
+        if (!api::IsSuccess(rc)) {
+            return rc;
         }
-    });
+    }
+    return api::STATUS_SUCCESS;
 }
 
-MysqlClient::~MysqlClient() {
-    mysql_close(sql_);
+static void bindString(MYSQL_BIND &bind, const std::string &value, unsigned long &length) {
+    memset(&bind, 0, sizeof(bind));
+    length = value.size();
+    bind.buffer_type = MYSQL_TYPE_STRING;
+    bind.buffer = const_cast<char *>(value.data());
+    bind.buffer_length = length;
+    bind.length = &length;
 }
 
-int MysqlClient::Save(api::Metadata &metadata) {
-    std::string valueCmd = "'" + metadata.file_name + "', '"
-                           + std::to_string(metadata.node_rank) + "', '"
-                           + metadata.iteration + "', '"
-                           + std::to_string(metadata.state) + "', '"
-                           + std::to_string(metadata.size) + "'";
-    std::string cmd = "REPLACE INTO " + std::string(config::MYSQL_TABLE_NAME)
-                      + " VALUES (" + valueCmd + ");";
-
-    int ret = mysql_query(sql_, cmd.c_str());
-    if (ret) {
-        LOG_ERROR("insert entry <{}> failed: {}", metadata.String(), mysql_error(sql_));
-        return api::STATUS_UNKNOWN_ERROR;
+static void bindInt(MYSQL_BIND &bind, int &value) {
+    memset(&bind, 0, sizeof(bind));
+    bind.buffer_type = MYSQL_TYPE_LONG;
+    bind.buffer = &value;
+}
+
+static void bindSize(MYSQL_BIND &bind, unsigned long long &value) {
+    memset(&bind, 0, sizeof(bind));
+    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+    bind.buffer = &value;
+    bind.is_unsigned = true;
+}
+
+/**
+ * @brief result buffers of a metadata row
+ */
+struct MetadataRow {
+    /* varchar(512) of utf8mb4 */
+    char file_name[2048];
+    char iteration[256];
+    unsigned long file_name_length = 0;
+    unsigned long iteration_length = 0;
+    int node_rank = 0;
+    int state = 0;
+    unsigned long long size = 0;
+    MYSQL_BIND binds[5];
+
+    MetadataRow() {
+        bindBuffer(binds[0], file_name, sizeof(file_name), file_name_length);
+        bindInt(binds[1], node_rank);
+        bindBuffer(binds[2], iteration, sizeof(iteration), iteration_length);
+        bindInt(binds[3], state);
+        bindSize(binds[4], size);
     }
-    LOG_TRACE("insert or replace metadata <{}>", metadata.String());
-    return api::STATUS_SUCCESS;
+
+    static void bindBuffer(MYSQL_BIND &bind, char *buffer, size_t size, unsigned long &length) {
+        memset(&bind, 0, sizeof(bind));
+        bind.buffer_type = MYSQL_TYPE_STRING;
+        bind.buffer = buffer;
+        bind.buffer_length = size;
+        bind.length = &length;
+    }
+
+    /**
+     * @brief fetch next row of stmt
+     * @return int 0 for a row, MYSQL_NO_DATA at the end, otherwise error
+     */
+    int Fetch(MYSQL_STMT *stmt) {
+        auto rc = mysql_stmt_fetch(stmt);
+        if (rc == MYSQL_DATA_TRUNCATED) {
+            LOG_ERROR("metadata row is truncated, file name {} bytes, iteration {} bytes",
+                      file_name_length, iteration_length);
+        }
+        return rc;
+    }
+
+    void To(api::Metadata &metadata) {
+        metadata.file_name.assign(file_name, file_name_length);
+        metadata.node_rank = node_rank;
+        metadata.iteration.assign(iteration, iteration_length);
+        metadata.state = static_cast<api::CheckpointState>(state);
+        metadata.size = static_cast<size_t>(size);
+    }
+};
+
+/**
+ * @brief bind params and execute, connection is marked broken if it's lost
+ */
+static bool execute(storage::MysqlConnection &conn, MYSQL_STMT *stmt, MYSQL_BIND *params) {
+    if (mysql_stmt_bind_param(stmt, params) || mysql_stmt_execute(stmt)) {
+        MysqlConnectionPool::CheckLost(conn, stmt);
+        return false;
+    }
+    return true;
+}
+
+MysqlClient::MysqlClient() {
+    /* connect and create table on first use */
+    MysqlConnectionPool::Instance();
+}
+
+int MysqlClient::Save(api::Metadata &metadata) {
+    return MysqlConnectionPool::Instance().Run(storage::STMT_SAVE, [&metadata](auto &conn, auto stmt) {
+        MYSQL_BIND params[5];
+        unsigned long file_name_length, iteration_length;
+        int node_rank = metadata.node_rank;
+        int state = metadata.state;
+        unsigned long long size = metadata.size;
+        bindString(params[0], metadata.file_name, file_name_length);
+        bindInt(params[1], node_rank);
+        bindString(params[2], metadata.iteration, iteration_length);
+        bindInt(params[3], state);
+        bindSize(params[4], size);
+        if (!execute(conn, stmt, params)) {
+            LOG_ERROR("insert entry <{}> failed: {}", metadata.String(), mysql_stmt_error(stmt));
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        LOG_TRACE("insert or replace metadata <{}>", metadata.String());
+        return api::STATUS_SUCCESS;
+    });
 }
 
 int MysqlClient::Load(api::Metadata &metadata) {
-    std::string cmd = "SELECT * FROM " + std::string(config::MYSQL_TABLE_NAME)
-                      + " WHERE FILE_NAME = '" + metadata.file_name + "'";
+    return MysqlConnectionPool::Instance().Run(storage::STMT_LOAD, [&metadata](auto &conn, auto stmt) {
+        MYSQL_BIND params[1];
+        unsigned long file_name_length;
+        bindString(params[0], metadata.file_name, file_name_length);
+        MetadataRow row;
+        if (!execute(conn, stmt, params) || mysql_stmt_bind_result(stmt, row.binds)
+            || mysql_stmt_store_result(stmt)) {
+            MysqlConnectionPool::CheckLost(conn, stmt);
+            LOG_ERROR("query entry with primary key <{}> failed: {}", metadata.file_name, mysql_stmt_error(stmt));
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        auto rows_num = mysql_stmt_num_rows(stmt);
+        if (rows_num != 1) {
+            if (rows_num == 0) {
+                LOG_WARN("query primary key {}, not found in database", metadata.file_name);
+                return api::STATUS_NOT_FOUND;
+            }
+            LOG_ERROR("query primary key {}, result contain {} rows", metadata.file_name, rows_num);
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        if (row.Fetch(stmt) != 0) {
+            LOG_ERROR("fetch entry with primary key <{}> failed: {}", metadata.file_name, mysql_stmt_error(stmt));
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        row.To(metadata);
+        return api::STATUS_SUCCESS;
+    });
+}
 
-    int ret = mysql_query(sql_, cmd.c_str());
-    if (ret) {
-        LOG_ERROR("query entry with primary key <{}> failed: {}", metadata.file_name, mysql_error(sql_));
-        return api::STATUS_UNKNOWN_ERROR;
-    }
+int MysqlClient::UpdateState(const std::string &file_name, const api::CheckpointState &state) {
+    return MysqlConnectionPool::Instance().Run(storage::STMT_UPDATE_STATE, [&](auto &conn, auto stmt) {
+        MYSQL_BIND params[2];
+        int state_value = state;
+        unsigned long file_name_length;
+        bindInt(params[0], state_value);
+        bindString(params[1], file_name, file_name_length);
+        if (!execute(conn, stmt, params)) {
+            LOG_ERROR("update entry with primary key <{}>, state to {}, failed: {}",
+                      file_name, api::CheckpointStateString(state), mysql_stmt_error(stmt));
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        LOG_TRACE("update metadata {} State to {}", file_name, CheckpointStateString(state));
+        return api::STATUS_SUCCESS;
+    });
+}
 
-    auto query_res = mysql_store_result(sql_);
-    auto rows_num = mysql_num_rows(query_res);
-    if (rows_num != 1) {
-        if (rows_num == 0) {
-            LOG_WARN("query primary key {}, not found in database", metadata.file_name);
+int MysqlClient::DeleteByFileName(const std::string &file_name) {
+    return MysqlConnectionPool::Instance().Run(storage::STMT_DELETE, [&file_name](auto &conn, auto stmt) {
+        MYSQL_BIND params[1];
+        unsigned long file_name_length;
+        bindString(params[0], file_name, file_name_length);
+        if (!execute(conn, stmt, params)) {
+            LOG_ERROR("delete entry with primary key <{}> failed: {}", file_name, mysql_stmt_error(stmt));
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        LOG_TRACE("delete metadata {}", file_name);
+        return api::STATUS_SUCCESS;
+    });
+}
+
+int MysqlClient::BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) {
+    return MysqlConnectionPool::Instance().Run(storage::STMT_BATCH_LOAD, [&filter, &vec](auto &conn, auto stmt) {
+        int node_rank = filter.node_rank >= 0 ? filter.node_rank : -1;
+        int state = filter.state >= api::CheckpointState::PENDING && filter.state < api::CheckpointState::STATE_NUM
+                        ? static_cast<int>(filter.state)
+                        : -1;
+        MYSQL_BIND params[6];
+        unsigned long iteration_length[2];
+        bindInt(params[0], node_rank);
+        bindInt(params[1], node_rank);
+        bindString(params[2], filter.iteration, iteration_length[0]);
+        bindString(params[3], filter.iteration, iteration_length[1]);
+        bindInt(params[4], state);
+        bindInt(params[5], state);
+        MetadataRow row;
+        if (!execute(conn, stmt, params) || mysql_stmt_bind_result(stmt, row.binds)
+            || mysql_stmt_store_result(stmt)) {
+            MysqlConnectionPool::CheckLost(conn, stmt);
+            LOG_ERROR("batch load with condition <{}> failed: {}", filter.String(), mysql_stmt_error(stmt));
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        if (mysql_stmt_num_rows(stmt) == 0) {
             return api::STATUS_NOT_FOUND;
         }
-        LOG_ERROR("query primary key {}, result contain {} rows", metadata.file_name, rows_num);
-        return api::STATUS_UNKNOWN_ERROR;
+        int rc;
+        while ((rc = row.Fetch(stmt)) == 0) {
+            api::Metadata metadata;
+            row.To(metadata);
+            vec.push_back(metadata);
+        }
+        if (rc != MYSQL_NO_DATA) {
+            LOG_ERROR("batch load with condition <{}> failed: {}", filter.String(), mysql_stmt_error(stmt));
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        return api::STATUS_SUCCESS;
+    });
+}
+
+int MysqlClient::BatchSave(std::vector<api::Metadata> &vec) {
+    for (size_t begin = 0; begin < vec.size(); begin += config::MYSQL_BATCH_ROWS) {
+        auto rc = MysqlConnectionPool::Instance().Run(storage::STMT_BATCH_SAVE, [&vec, begin](auto &conn, auto stmt) {
+            constexpr int rows = config::MYSQL_BATCH_ROWS;
+            MYSQL_BIND params[rows * 5];
+            unsigned long file_name_length[rows], iteration_length[rows];
+            int node_rank[rows], state[rows];
+            unsigned long long size[rows];
+            for (int i = 0; i < rows; i++) {
+                /* padded with the last row, replacing a row twice with the same values is harmless */
+                auto &metadata = vec[std::min(begin + i, vec.size() - 1)];
+                node_rank[i] = metadata.node_rank;
+                state[i] = metadata.state;
+                size[i] = metadata.size;
+                bindString(params[i * 5], metadata.file_name, file_name_length[i]);
+                bindInt(params[i * 5 + 1], node_rank[i]);
+                bindString(params[i * 5 + 2], metadata.iteration, iteration_length[i]);
+                bindInt(params[i * 5 + 3], state[i]);
+                bindSize(params[i * 5 + 4], size[i]);
+            }
+            if (!execute(conn, stmt, params)) {
+                LOG_ERROR("insert {} entries from {} failed: {}", std::min(vec.size() - begin, size_t(rows)),
+                          vec[begin].file_name, mysql_stmt_error(stmt));
+                return api::STATUS_UNKNOWN_ERROR;
+            }
+            return api::STATUS_SUCCESS;
+        });
+        if (!api::IsSuccess(rc)) {
+            return rc;
+        }
     }
-    auto row_data = mysql_fetch_row(query_res);
-    metadata.file_name = row_data[0];
-    metadata.node_rank = std::atoi(row_data[1]);
-    metadata.iteration = row_data[2];
-    metadata.state = (api::CheckpointState)std::atoi(row_data[3]);
-    metadata.size = static_cast<size_t>(std::atoll(row_data[4]));
-
-    mysql_free_result(query_res);
+    LOG_TRACE("insert or replace {} metadata", vec.size());
     return api::STATUS_SUCCESS;
 }
 
-int MysqlClient::UpdateState(const std::string &file_name, const api::CheckpointState &state) {
-    std::string updateCmd = "UPDATE " + std::string(config::MYSQL_TABLE_NAME)
-                            + " SET STATE='"
-                            + std::to_string(state)
-                            + "' WHERE FILE_NAME='"
-                            + file_name + "';";
-    int ret = mysql_query(sql_, updateCmd.c_str());
-    if (ret) {
-        LOG_ERROR("update entry with primary key <{}>, state to {}, failed: {}",
-                  file_name, api::CheckpointStateString(state), mysql_error(sql_));
-        return api::STATUS_UNKNOWN_ERROR;
+int MysqlClient::BatchDelete(const std::vector<std::string> &file_names) {
+    for (size_t begin = 0; begin < file_names.size(); begin += config::MYSQL_BATCH_ROWS) {
+        auto rc = MysqlConnectionPool::Instance().Run(storage::STMT_BATCH_DELETE, [&file_names, begin](auto &conn,
+                                                                                                        auto stmt) {
+            constexpr int rows = config::MYSQL_BATCH_ROWS;
+            MYSQL_BIND params[rows];
+            unsigned long file_name_length[rows];
+            for (int i = 0; i < rows; i++) {
+                bindString(params[i], file_names[std::min(begin + i, file_names.size() - 1)], file_name_length[i]);
+            }
+            if (!execute(conn, stmt, params)) {
+                LOG_ERROR("delete {} entries from {} failed: {}", std::min(file_names.size() - begin, size_t(rows)),
+                          file_names[begin], mysql_stmt_error(stmt));
+                return api::STATUS_UNKNOWN_ERROR;
+            }
+            return api::STATUS_SUCCESS;
+        });
+        if (!api::IsSuccess(rc)) {
+            return rc;
+        }
     }
-
-    LOG_TRACE("update metadata {} State to {}", file_name, CheckpointStateString(state));
+    LOG_TRACE("delete {} metadata", file_names.size());
     return api::STATUS_SUCCESS;
 }
 
-int MysqlClient::DeleteByFileName(const std::string &file_name) {
-    std::string delete_cmd = "DELETE FROM " + std::string(config::MYSQL_TABLE_NAME)
-                             + " WHERE FILE_NAME='" + file_name + "';";
-    int ret = mysql_query(sql_, delete_cmd.c_str());
-    if (ret) {
-        LOG_ERROR("delete entry with primary key <{}> failed: {}", file_name, mysql_error(sql_));
-        return api::STATUS_UNKNOWN_ERROR;
+int MysqlClient::BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) {
+    for (size_t begin = 0; begin < file_names.size(); begin += config::MYSQL_BATCH_ROWS) {
+        auto rc = MysqlConnectionPool::Instance().Run(storage::STMT_BATCH_UPDATE_STATE, [&, begin](auto &conn,
+                                                                                                  auto stmt) {
+            constexpr int rows = config::MYSQL_BATCH_ROWS;
+            MYSQL_BIND params[rows + 1];
+            int state_value = state;
+            unsigned long file_name_length[rows];
+            bindInt(params[0], state_value);
+            for (int i = 0; i < rows; i++) {
+                bindString(params[i + 1], file_names[std::min(begin + i, file_names.size() - 1)],
+                           file_name_length[i]);
+            }
+            if (!execute(conn, stmt, params)) {
+                LOG_ERROR("update {} entries from {}, state to {}, failed: {}",
+                          std::min(file_names.size() - begin, size_t(rows)), file_names[begin],
+                          api::CheckpointStateString(state), mysql_stmt_error(stmt));
+                return api::STATUS_UNKNOWN_ERROR;
+            }
+            return api::STATUS_SUCCESS;
+        });
+        if (!api::IsSuccess(rc)) {
+            return rc;
+        }
     }
-
-    LOG_TRACE("delete metadata {}", file_name);
+    LOG_TRACE("update {} metadata State to {}", file_names.size(), api::CheckpointStateString(state));
     return api::STATUS_SUCCESS;
 }
 
-int MysqlClient::BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) {
-    std::vector<std::string> filters;
-    if (filter.node_rank >= 0) {
-        filters.push_back("NODE_RANK = '" + std::to_string(filter.node_rank) + "'");
-    }
-    if (filter.iteration.size() > 0) {
-        filters.push_back("ITERATION = '" + filter.iteration + "'");
-    }
-    if (filter.state >= api::CheckpointState::PENDING && filter.state < api::CheckpointState::STATE_NUM) {
-        filters.push_back("STATE= '" + std::to_string(filter.state) + "'");
-    }
-    auto filter_str = util::Util::Join(std::ref(filters), " AND ");
+/**
+ * @brief store shared by local clients, opened on first use
+ */
+static LocalMetadataStore &localStore() {
+    static LocalMetadataStore *store = []() {
+        /* each node only has its own rows, loading rows of other nodes during recovery would find nothing */
+        if (config::WorldState::Instance().WorldSize() > 1) {
+            LOG_FATAL("meta client {} is for single node jobs only, world size is {}, use {} or {} instead",
+                      config::META_CLIENT_LOCAL, config::WorldState::Instance().WorldSize(),
+                      config::META_CLIENT_MYSQL, config::META_CLIENT_TRANSOM);
+        }
+        auto dir = util::Util::GetEnv(config::ENV_KEY_META_LOCAL_DIR, config::DEFAULT_META_LOCAL_DIR);
+        auto store = new LocalMetadataStore(dir + "/metadata_" + config::WorldState::Instance().JobName() + ".log");
+        if (!store->Open()) {
+            LOG_FATAL("cannot open metadata store in {}", dir);
+        }
+        return store;
+    }();
+    return *store;
+}
 
-    std::string cmd = "SELECT * FROM " + std::string(config::MYSQL_TABLE_NAME);
-    if (!filter_str.empty()) {
-        cmd += " WHERE " + filter_str;
-    }
+int LocalClient::Save(api::Metadata &metadata) {
+    return localStore().Save(metadata);
+}
 
-    int ret = mysql_query(sql_, cmd.c_str());
-    if (ret) {
-        LOG_ERROR("batch load with condition <{}> failed: {}", filter_str, mysql_error(sql_));
-        return api::STATUS_UNKNOWN_ERROR;
-    }
+int LocalClient::Load(api::Metadata &metadata) {
+    return localStore().Load(metadata);
+}
 
-    auto query_res = mysql_store_result(sql_);
-    auto rows_num = mysql_num_rows(query_res);
+int LocalClient::UpdateState(const std::string &file_name, const api::CheckpointState &state) {
+    return localStore().UpdateState(file_name, state);
+}
 
-    if (rows_num == 0) {
-        return api::STATUS_NOT_FOUND;
-    }
+int LocalClient::DeleteByFileName(const std::string &file_name) {
+    return localStore().DeleteByFileName(file_name);
+}
 
-    for (auto i = 0; i < rows_num; i++) {
-        auto rowData = mysql_fetch_row(query_res);
-        api::Metadata metadata;
-        metadata.file_name = rowData[0];
-        metadata.node_rank = std::atoi(rowData[1]);
-        metadata.iteration = rowData[2];
-        metadata.state = (api::CheckpointState)std::atoi(rowData[3]);
-        metadata.size = std::atoll(rowData[4]);
-        vec.push_back(metadata);
-    }
+int LocalClient::BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) {
+    return localStore().BatchLoad(filter, vec);
+}
 
-    mysql_free_result(query_res);
-    return api::STATUS_SUCCESS;
-}
\ No newline at end of file
+int LocalClient::BatchSave(std::vector<api::Metadata> &vec) {
+    return localStore().BatchSave(vec);
+}
+
+int LocalClient::BatchDelete(const std::vector<std::string> &file_names) {
+    return localStore().BatchDelete(file_names);
+}
+
+int LocalClient::BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) {
+    return localStore().BatchUpdateState(file_names, state);
+}
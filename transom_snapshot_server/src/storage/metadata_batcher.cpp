@@ -0,0 +1,78 @@
+/**
+ * @file metadata_batcher.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/metadata_batcher.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "storage/metadata.h"
+
+using storage::MetadataBatcher;
+
+int MetadataBatcher::UpdateState(const std::string &file_name, const api::CheckpointState &state) {
+    Pending pending{&file_name, state};
+    std::unique_lock<std::mutex> lock(mut_);
+    queue_.push_back(&pending);
+    while (!pending.done) {
+        if (sending_) {
+            cv_.wait(lock);
+            continue;
+        }
+        sending_ = true;
+        /* a file updated twice ends the batch, so that updates of a file are applied in order */
+        std::deque<Pending *> batch;
+        std::set<std::string> file_names;
+        while (!queue_.empty() && batch.size() < config::META_BATCH_UPDATE_ROWS
+               && file_names.insert(*queue_.front()->file_name).second) {
+            batch.push_back(queue_.front());
+            queue_.pop_front();
+        }
+        lock.unlock();
+        send(batch);
+        lock.lock();
+        for (auto item : batch) {
+            item->done = true;
+        }
+        sending_ = false;
+        cv_.notify_all();
+    }
+    return pending.code;
+}
+
+void MetadataBatcher::send(const std::deque<Pending *> &batch) {
+    std::map<api::CheckpointState, std::vector<Pending *>> by_state;
+    for (auto item : batch) {
+        by_state[item->state].push_back(item);
+    }
+    auto meta_client = storage::MetadataClientFactory::GetClient();
+    for (auto &[state, items] : by_state) {
+        std::vector<std::string> file_names;
+        file_names.reserve(items.size());
+        for (auto item : items) {
+            file_names.push_back(*item->file_name);
+        }
+        auto rc = items.size() == 1 ? meta_client->UpdateState(file_names.front(), state)
+                                    : meta_client->BatchUpdateState(file_names, state);
+        if (!api::IsSuccess(rc)) {
+            LOG_ERROR("update state of {} files from {} to {} failed", file_names.size(), file_names.front(),
+                      api::CheckpointStateString(state));
+        }
+        for (auto item : items) {
+            item->code = rc;
+        }
+        batches_ << 1;
+        updates_ << items.size();
+    }
+}
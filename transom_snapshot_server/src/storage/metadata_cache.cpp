@@ -0,0 +1,353 @@
+/**
+ * @file metadata_cache.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/metadata_cache.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#include "config/config.h"
+#include "config/world.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using storage::CachedClient;
+using storage::MetadataCache;
+using config::WorldState;
+
+/**
+ * @brief copy loaded fields like database does, job name is kept
+ */
+static void assign(api::Metadata &metadata, const api::Metadata &row) {
+    metadata.file_name = row.file_name;
+    metadata.node_rank = row.node_rank;
+    metadata.iteration = row.iteration;
+    metadata.state = row.state;
+    metadata.size = row.size;
+}
+
+MetadataCache::MetadataCache() {
+    /* local store is in memory already */
+    enabled_ = util::Util::GetEnv(config::ENV_KEY_META_CACHE, "true") == "true"
+               && util::Util::GetEnv(config::ENV_KEY_META_CLIENT, config::META_CLIENT_MYSQL)
+                      != config::META_CLIENT_LOCAL;
+    node_rank_ = WorldState::Instance().NodeRank();
+    flush_ms_ = std::max(1, std::atoi(util::Util::GetEnv(config::ENV_KEY_META_FLUSH_MS,
+                                                         config::DEFAULT_META_FLUSH_MS).c_str()));
+    auto dir = util::Util::GetEnv(config::ENV_KEY_META_LOG_DIR, config::DEFAULT_META_LOG_DIR);
+    log_path_ = dir + "/metadata_" + WorldState::Instance().JobName() + "_" + std::to_string(node_rank_) + ".log";
+    flushing_path_ = log_path_ + ".flushing";
+    log_ = std::make_unique<MetadataLog>(log_path_);
+}
+
+void MetadataCache::Start() {
+    if (!enabled_) {
+        LOG_INFO("metadata cache is disabled");
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(log_path_).parent_path(), ec);
+    if (ec) {
+        LOG_FATAL("failed to create metadata log directory of {}: {}", log_path_, ec.message());
+    }
+
+    /* the one being flushed is older */
+    replay(flushing_path_);
+    replay(log_path_);
+    if (!log_->Open()) {
+        LOG_FATAL("cannot start metadata cache without log");
+    }
+    if (!dirty_.empty()) {
+        LOG_INFO("flush {} metadata writes of previous run", dirty_.size());
+        Flush();
+    }
+
+    api::BatchLoadFilter filter(node_rank_);
+    std::vector<api::Metadata> vec;
+    auto rc = MetadataClientFactory::GetDatabaseClient()->BatchLoad(filter, vec);
+    if (rc == api::STATUS_UNKNOWN_ERROR) {
+        LOG_FATAL("load metadata of node {} failed", node_rank_);
+    }
+    for (auto &metadata : vec) {
+        rows_.emplace(metadata.file_name, metadata);
+    }
+    /* writes not flushed yet are newer than database */
+    for (auto &[file_name, metadata] : dirty_) {
+        if (metadata.has_value()) {
+            rows_.insert_or_assign(file_name, *metadata);
+        } else {
+            rows_.erase(file_name);
+        }
+    }
+    LOG_INFO("metadata cache of node {} starts with {} rows, flush every {} ms", node_rank_, rows_.size(), flush_ms_);
+
+    running_ = true;
+    std::thread([this]() {
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(flush_ms_));
+            Flush();
+        }
+    }).detach();
+}
+
+void MetadataCache::replay(const std::string &path) {
+    auto records = MetadataLog::Replay(path, [this](MetadataLog::Op op, api::Metadata &metadata) {
+        if (op == MetadataLog::SAVE) {
+            dirty_.insert_or_assign(metadata.file_name, metadata);
+        } else {
+            dirty_.insert_or_assign(metadata.file_name, std::nullopt);
+        }
+    });
+    LOG_INFO("replay {} records of metadata log {}", records, path);
+}
+
+void MetadataCache::write(const std::vector<MetadataLog::Record> &records) {
+    if (records.empty()) {
+        return;
+    }
+    for (auto &[op, metadata] : records) {
+        if (op == MetadataLog::SAVE) {
+            rows_.insert_or_assign(metadata.file_name, metadata);
+            dirty_.insert_or_assign(metadata.file_name, metadata);
+        } else {
+            rows_.erase(metadata.file_name);
+            dirty_.insert_or_assign(metadata.file_name, std::nullopt);
+        }
+    }
+    if (!log_->Append(records, false)) {
+        LOG_ERROR("append {} records from {} to metadata log failed: {}, they're lost if server exits before "
+                  "flushed", records.size(), records.front().second.file_name, strerror(errno));
+    }
+}
+
+bool MetadataCache::Flush() {
+    std::lock_guard<std::mutex> flush_lock(flush_mut_);
+    std::map<std::string, std::optional<api::Metadata>> batch;
+    {
+        std::unique_lock<std::shared_mutex> lock(mut_);
+        if (dirty_.empty()) {
+            return true;
+        }
+        batch.swap(dirty_);
+        /* writes from now on go to a new log, unless the last flush failed and its log is kept */
+        if (access(flushing_path_.c_str(), F_OK) != 0) {
+            log_->Close();
+            if (rename(log_path_.c_str(), flushing_path_.c_str()) != 0) {
+                LOG_ERROR("rotate metadata log {} failed: {}", log_path_, strerror(errno));
+            }
+            log_->Open();
+        }
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<api::Metadata> saved;
+    std::vector<std::string> deleted;
+    for (auto &[file_name, metadata] : batch) {
+        if (metadata.has_value()) {
+            saved.push_back(*metadata);
+        } else {
+            deleted.push_back(file_name);
+        }
+    }
+    auto db = MetadataClientFactory::GetDatabaseClient();
+    bool ok = (deleted.empty() || api::IsSuccess(db->BatchDelete(deleted)))
+              && (saved.empty() || api::IsSuccess(db->BatchSave(saved)));
+    if (!ok) {
+        LOG_ERROR("flush {} metadata writes failed, retry later", batch.size());
+        flush_failures_ << 1;
+        std::unique_lock<std::shared_mutex> lock(mut_);
+        /* writes during flush are newer */
+        for (auto &[file_name, metadata] : batch) {
+            dirty_.emplace(file_name, metadata);
+        }
+        return false;
+    }
+    unlink(flushing_path_.c_str());
+    flushed_ << batch.size();
+    flush_latency_ << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()
+                                                                            - start_time)
+                          .count();
+    LOG_TRACE("flush {} saved and {} deleted metadata", saved.size(), deleted.size());
+    return true;
+}
+
+int MetadataCache::Save(api::Metadata &metadata) {
+    if (metadata.node_rank != node_rank_) {
+        return MetadataClientFactory::GetDatabaseClient()->Save(metadata);
+    }
+    std::unique_lock<std::shared_mutex> lock(mut_);
+    write({{MetadataLog::SAVE, metadata}});
+    LOG_TRACE("insert or replace metadata <{}>", metadata.String());
+    return api::STATUS_SUCCESS;
+}
+
+int MetadataCache::Load(api::Metadata &metadata) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mut_);
+        if (auto it = rows_.find(metadata.file_name); it != rows_.end()) {
+            assign(metadata, it->second);
+            hits_ << 1;
+            return api::STATUS_SUCCESS;
+        }
+        /* deleted, but database does not know yet */
+        if (auto it = dirty_.find(metadata.file_name); it != dirty_.end() && !it->second.has_value()) {
+            hits_ << 1;
+            return api::STATUS_NOT_FOUND;
+        }
+    }
+    misses_ << 1;
+    return MetadataClientFactory::GetDatabaseClient()->Load(metadata);
+}
+
+int MetadataCache::UpdateState(const std::string &file_name, const api::CheckpointState &state) {
+    {
+        std::unique_lock<std::shared_mutex> lock(mut_);
+        if (auto it = rows_.find(file_name); it != rows_.end()) {
+            api::Metadata metadata(it->second);
+            metadata.state = state;
+            write({{MetadataLog::SAVE, metadata}});
+            LOG_TRACE("update metadata {} State to {}", file_name, CheckpointStateString(state));
+            return api::STATUS_SUCCESS;
+        }
+    }
+    return MetadataClientFactory::GetDatabaseClient()->UpdateState(file_name, state);
+}
+
+int MetadataCache::DeleteByFileName(const std::string &file_name) {
+    {
+        std::unique_lock<std::shared_mutex> lock(mut_);
+        if (rows_.count(file_name) > 0) {
+            write({{MetadataLog::DELETE, api::Metadata("", file_name)}});
+            LOG_TRACE("delete metadata {}", file_name);
+            return api::STATUS_SUCCESS;
+        }
+    }
+    return MetadataClientFactory::GetDatabaseClient()->DeleteByFileName(file_name);
+}
+
+int MetadataCache::BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) {
+    /* rows of other nodes */
+    if (filter.node_rank != node_rank_) {
+        misses_ << 1;
+        auto rc = MetadataClientFactory::GetDatabaseClient()->BatchLoad(filter, vec);
+        if (filter.node_rank >= 0 || rc == api::STATUS_UNKNOWN_ERROR) {
+            return rc;
+        }
+        vec.erase(std::remove_if(vec.begin(), vec.end(), [this](const api::Metadata &metadata) {
+            return metadata.node_rank == node_rank_;
+        }), vec.end());
+    } else {
+        hits_ << 1;
+    }
+    std::shared_lock<std::shared_mutex> lock(mut_);
+    for (auto &[file_name, metadata] : rows_) {
+        if (filter.Match(metadata)) {
+            vec.push_back(metadata);
+        }
+    }
+    return vec.empty() ? api::STATUS_NOT_FOUND : api::STATUS_SUCCESS;
+}
+
+int MetadataCache::BatchSave(std::vector<api::Metadata> &vec) {
+    std::vector<MetadataLog::Record> records;
+    std::vector<api::Metadata> others;
+    for (auto &metadata : vec) {
+        if (metadata.node_rank == node_rank_) {
+            records.emplace_back(MetadataLog::SAVE, metadata);
+        } else {
+            others.push_back(metadata);
+        }
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(mut_);
+        write(records);
+    }
+    LOG_TRACE("insert or replace {} metadata, {} of other nodes", vec.size(), others.size());
+    return others.empty() ? api::STATUS_SUCCESS : MetadataClientFactory::GetDatabaseClient()->BatchSave(others);
+}
+
+int MetadataCache::BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) {
+    std::vector<std::string> others;
+    {
+        std::vector<MetadataLog::Record> records;
+        std::unique_lock<std::shared_mutex> lock(mut_);
+        for (auto &file_name : file_names) {
+            if (auto it = rows_.find(file_name); it != rows_.end()) {
+                records.emplace_back(MetadataLog::SAVE, it->second);
+                records.back().second.state = state;
+            } else {
+                others.push_back(file_name);
+            }
+        }
+        write(records);
+    }
+    LOG_TRACE("update {} metadata State to {}, {} of other nodes", file_names.size(), CheckpointStateString(state),
+              others.size());
+    return others.empty() ? api::STATUS_SUCCESS
+                          : MetadataClientFactory::GetDatabaseClient()->BatchUpdateState(others, state);
+}
+
+int MetadataCache::BatchDelete(const std::vector<std::string> &file_names) {
+    std::vector<std::string> others;
+    {
+        std::vector<MetadataLog::Record> records;
+        std::unique_lock<std::shared_mutex> lock(mut_);
+        for (auto &file_name : file_names) {
+            if (rows_.count(file_name) > 0) {
+                records.emplace_back(MetadataLog::DELETE, api::Metadata("", file_name));
+            } else {
+                others.push_back(file_name);
+            }
+        }
+        write(records);
+    }
+    LOG_TRACE("delete {} metadata, {} of other nodes", file_names.size(), others.size());
+    return others.empty() ? api::STATUS_SUCCESS : MetadataClientFactory::GetDatabaseClient()->BatchDelete(others);
+}
+
+int CachedClient::Save(api::Metadata &metadata) {
+    return MetadataCache::Instance().Save(metadata);
+}
+
+int CachedClient::Load(api::Metadata &metadata) {
+    return MetadataCache::Instance().Load(metadata);
+}
+
+int CachedClient::UpdateState(const std::string &file_name, const api::CheckpointState &state) {
+    return MetadataCache::Instance().UpdateState(file_name, state);
+}
+
+int CachedClient::DeleteByFileName(const std::string &file_name) {
+    return MetadataCache::Instance().DeleteByFileName(file_name);
+}
+
+int CachedClient::BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) {
+    return MetadataCache::Instance().BatchLoad(filter, vec);
+}
+
+int CachedClient::BatchSave(std::vector<api::Metadata> &vec) {
+    return MetadataCache::Instance().BatchSave(vec);
+}
+
+int CachedClient::BatchUpdateState(const std::vector<std::string> &file_names, const api::CheckpointState &state) {
+    return MetadataCache::Instance().BatchUpdateState(file_names, state);
+}
+
+int CachedClient::BatchDelete(const std::vector<std::string> &file_names) {
+    return MetadataCache::Instance().BatchDelete(file_names);
+}
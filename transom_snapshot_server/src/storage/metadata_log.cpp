@@ -0,0 +1,182 @@
+/**
+ * @file metadata_log.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/metadata_log.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "buffer/buffer.h"
+#include "logger/logger.h"
+
+using storage::MetadataLog;
+
+/* length and checksum of payload */
+constexpr size_t HEADER_SIZE = sizeof(uint32_t) + sizeof(uint64_t);
+
+/**
+ * @brief FNV-1a, enough to tell a torn record from a complete one
+ */
+static uint64_t checksum(const char *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static bool writeAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        auto n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+MetadataLog::~MetadataLog() {
+    Close();
+}
+
+bool MetadataLog::Open() {
+    Close();
+    fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR("open metadata log {} failed: {}", path_, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void MetadataLog::Close() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+std::string MetadataLog::encode(const std::vector<Record> &records) {
+    std::string content;
+    buffer::Buffer buffer;
+    for (auto &[op, metadata] : records) {
+        buffer.Reset();
+        buffer.Add(op);
+        api::Metadata copied(metadata);
+        copied.Marshal(std::ref(buffer));
+        uint32_t length = buffer.GetBufferSize();
+        uint64_t sum = checksum(buffer.GetBuffer(), length);
+        content.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        content.append(reinterpret_cast<const char *>(&sum), sizeof(sum));
+        content.append(buffer.GetBuffer(), length);
+    }
+    return content;
+}
+
+bool MetadataLog::Append(const std::vector<Record> &records, bool sync) {
+    if (fd_ < 0) {
+        errno = EBADF;
+        return false;
+    }
+    auto content = encode(records);
+    auto offset = lseek(fd_, 0, SEEK_END);
+    if (offset < 0) {
+        return false;
+    }
+    if (writeAll(fd_, content.data(), content.size()) && (!sync || fdatasync(fd_) == 0)) {
+        return true;
+    }
+    /* cut records of a failed append, or replay stops at the torn one and drops records appended after it */
+    auto err = errno;
+    if (ftruncate(fd_, offset) != 0) {
+        LOG_ERROR("truncate metadata log {} to {} failed: {}, it is unusable until reopened", path_, offset,
+                  strerror(errno));
+        Close();
+    }
+    errno = err;
+    return false;
+}
+
+bool MetadataLog::Rewrite(const std::vector<Record> &records) {
+    auto tmp_path = path_ + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("open {} failed: {}", tmp_path, strerror(errno));
+        return false;
+    }
+    auto content = encode(records);
+    bool ok = writeAll(fd, content.data(), content.size()) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        LOG_ERROR("rewrite metadata log {} failed: {}", path_, strerror(errno));
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    /* make rename durable */
+    auto dir = std::filesystem::path(path_).parent_path().string();
+    int dir_fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return Open();
+}
+
+size_t MetadataLog::Replay(const std::string &path, const std::function<void(Op, api::Metadata &)> &fn) {
+    std::ifstream infile(path, std::ios::binary);
+    if (!infile) {
+        return 0;
+    }
+    std::string content((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+    size_t offset = 0, records = 0;
+    buffer::Buffer buffer;
+    while (offset + HEADER_SIZE <= content.size()) {
+        uint32_t length;
+        uint64_t sum;
+        memcpy(&length, content.data() + offset, sizeof(length));
+        memcpy(&sum, content.data() + offset + sizeof(length), sizeof(sum));
+        auto payload = content.data() + offset + HEADER_SIZE;
+        if (length == 0 || offset + HEADER_SIZE + length > content.size() || checksum(payload, length) != sum) {
+            break;
+        }
+        buffer.Reset();
+        buffer.Realloc(length + 1);
+        memcpy(buffer.GetBuffer(), payload, length);
+        buffer.SetBufferSize(length);
+        offset += HEADER_SIZE + length;
+
+        auto op = buffer.Get<Op>();
+        api::Metadata metadata;
+        metadata.Unmarshal(std::ref(buffer));
+        fn(op, metadata);
+        records++;
+    }
+    /* or records appended later are never reached */
+    if (offset != content.size()) {
+        LOG_WARN("metadata log {} has a torn record at {} of {} bytes, truncate it", path, offset, content.size());
+        if (truncate(path.c_str(), offset) != 0) {
+            LOG_ERROR("truncate metadata log {} failed: {}", path, strerror(errno));
+        }
+    }
+    return records;
+}
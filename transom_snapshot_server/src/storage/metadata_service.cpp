@@ -0,0 +1,215 @@
+/**
+ * @file metadata_service.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/metadata_service.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#include "brpc/server.h"
+
+#include "logger/logger.h"
+
+using storage::LocalMetadataStore;
+using storage::MetadataServiceImpl;
+
+void storage::ToRow(const api::Metadata &metadata, MetadataRow *row) {
+    row->set_file_name(metadata.file_name);
+    row->set_node_rank(metadata.node_rank);
+    row->set_iteration(metadata.iteration);
+    row->set_state(metadata.state);
+    row->set_size(metadata.size);
+}
+
+void storage::FromRow(const MetadataRow &row, api::Metadata &metadata) {
+    metadata.file_name = row.file_name();
+    metadata.node_rank = row.node_rank();
+    metadata.iteration = row.iteration();
+    metadata.state = static_cast<api::CheckpointState>(row.state());
+    metadata.size = row.size();
+}
+
+static int64_t elapsedUs(std::chrono::steady_clock::time_point start_time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time)
+        .count();
+}
+
+MetadataServiceImpl::MetadataServiceImpl(std::string dir, size_t shards) :
+    dir_(std::move(dir)), shards_(std::max<size_t>(1, shards)) {
+    LOG_INFO("metadata service at {}, {} shards per job", dir_, shards_);
+}
+
+MetadataServiceImpl::Job *MetadataServiceImpl::job(const std::string &name) {
+    std::lock_guard<std::mutex> lock(mut_);
+    auto it = jobs_.find(name);
+    if (it != jobs_.end()) {
+        return it->second.get();
+    }
+    if (name.empty() || name.find('/') != std::string::npos || name == "." || name == "..") {
+        LOG_ERROR("invalid job name {}", name);
+        return nullptr;
+    }
+    auto job = std::make_unique<Job>();
+    for (size_t i = 0; i < shards_; i++) {
+        auto store = std::make_unique<LocalMetadataStore>(dir_ + "/" + name + "/shard_" + std::to_string(i) + ".log");
+        if (!store->Open()) {
+            LOG_ERROR("open shard {} of job {} failed", i, name);
+            return nullptr;
+        }
+        job->shards.push_back(std::move(store));
+    }
+    LOG_INFO("job {} is served", name);
+    return jobs_.emplace(name, std::move(job)).first->second.get();
+}
+
+LocalMetadataStore &MetadataServiceImpl::shard(Job &job, int node_rank) {
+    return *job.shards[node_rank < 0 ? 0 : node_rank % job.shards.size()];
+}
+
+LocalMetadataStore *MetadataServiceImpl::locate(Job &job, const std::string &file_name) {
+    for (auto &store : job.shards) {
+        if (store->Contains(file_name)) {
+            return store.get();
+        }
+    }
+    return nullptr;
+}
+
+void MetadataServiceImpl::Write(google::protobuf::RpcController *cntl_base, const MetadataWriteRequest *request,
+                                MetadataWriteResponse *response, google::protobuf::Closure *done) {
+    brpc::ClosureGuard done_guard(done);
+    auto start_time = std::chrono::steady_clock::now();
+    auto job = this->job(request->job());
+    if (job == nullptr) {
+        response->set_code(api::STATUS_UNKNOWN_ERROR);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(job->write_mut);
+
+    /* result of ops per file, with the shard it was in */
+    struct Change {
+        std::optional<api::Metadata> row;
+        LocalMetadataStore *origin;
+    };
+    std::map<std::string, Change> changes;
+    auto current = [this, job, &changes](const std::string &file_name) -> Change & {
+        auto it = changes.find(file_name);
+        if (it != changes.end()) {
+            return it->second;
+        }
+        Change change{std::nullopt, locate(*job, file_name)};
+        if (change.origin != nullptr) {
+            api::Metadata metadata("", file_name);
+            change.origin->Load(metadata);
+            change.row = metadata;
+        }
+        return changes.emplace(file_name, change).first->second;
+    };
+    for (auto &op : request->ops()) {
+        auto &change = current(op.row().file_name());
+        switch (op.type()) {
+        case MetadataOp::SAVE: {
+            api::Metadata metadata;
+            FromRow(op.row(), metadata);
+            change.row = metadata;
+            break;
+        }
+        case MetadataOp::UPDATE_STATE:
+            /* updating nothing is not an error, like database */
+            if (change.row.has_value()) {
+                change.row->state = static_cast<api::CheckpointState>(op.row().state());
+            }
+            break;
+        case MetadataOp::DELETE:
+            change.row = std::nullopt;
+            break;
+        default:
+            break;
+        }
+    }
+
+    /* a synced append per shard */
+    std::map<LocalMetadataStore *, std::vector<api::Metadata>> saved;
+    std::map<LocalMetadataStore *, std::vector<std::string>> deleted;
+    for (auto &[file_name, change] : changes) {
+        auto target = change.row.has_value() ? &shard(*job, change.row->node_rank) : nullptr;
+        if (change.origin != nullptr && change.origin != target) {
+            deleted[change.origin].push_back(file_name);
+        }
+        if (target != nullptr) {
+            saved[target].push_back(*change.row);
+        }
+    }
+    int rc = api::STATUS_SUCCESS;
+    for (auto &[store, file_names] : deleted) {
+        if (!api::IsSuccess(store->BatchDelete(file_names))) {
+            rc = api::STATUS_UNKNOWN_ERROR;
+        }
+    }
+    for (auto &[store, vec] : saved) {
+        if (!api::IsSuccess(store->BatchSave(vec))) {
+            rc = api::STATUS_UNKNOWN_ERROR;
+        }
+    }
+    response->set_code(rc);
+    ops_ << request->ops_size();
+    write_latency_ << elapsedUs(start_time);
+}
+
+void MetadataServiceImpl::Load(google::protobuf::RpcController *cntl_base, const MetadataLoadRequest *request,
+                               MetadataLoadResponse *response, google::protobuf::Closure *done) {
+    brpc::ClosureGuard done_guard(done);
+    auto start_time = std::chrono::steady_clock::now();
+    auto job = this->job(request->job());
+    if (job == nullptr) {
+        response->set_code(api::STATUS_UNKNOWN_ERROR);
+        return;
+    }
+    for (auto &file_name : request->file_names()) {
+        auto store = locate(*job, file_name);
+        api::Metadata metadata("", file_name);
+        /* removed since located */
+        if (store == nullptr || !api::IsSuccess(store->Load(metadata))) {
+            continue;
+        }
+        ToRow(metadata, response->add_rows());
+    }
+    response->set_code(api::STATUS_SUCCESS);
+    load_latency_ << elapsedUs(start_time);
+}
+
+void MetadataServiceImpl::BatchLoad(google::protobuf::RpcController *cntl_base,
+                                    const MetadataBatchLoadRequest *request, MetadataBatchLoadResponse *response,
+                                    google::protobuf::Closure *done) {
+    brpc::ClosureGuard done_guard(done);
+    auto start_time = std::chrono::steady_clock::now();
+    auto job = this->job(request->job());
+    if (job == nullptr) {
+        response->set_code(api::STATUS_UNKNOWN_ERROR);
+        return;
+    }
+    api::BatchLoadFilter filter(request->node_rank(), request->iteration(),
+                                static_cast<api::CheckpointState>(request->state()));
+    std::vector<api::Metadata> vec;
+    if (filter.node_rank >= 0) {
+        shard(*job, filter.node_rank).BatchLoad(filter, vec);
+    } else {
+        for (auto &store : job->shards) {
+            store->BatchLoad(filter, vec);
+        }
+    }
+    for (auto &metadata : vec) {
+        ToRow(metadata, response->add_rows());
+    }
+    response->set_code(vec.empty() ? api::STATUS_NOT_FOUND : api::STATUS_SUCCESS);
+    batch_load_latency_ << elapsedUs(start_time);
+}
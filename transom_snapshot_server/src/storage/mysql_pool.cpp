@@ -0,0 +1,273 @@
+/**
+ * @file mysql_pool.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/mysql_pool.h"
+
+#include <algorithm>
+
+#include "mysql/errmsg.h"
+
+#include "api/api.h"
+#include "config/config.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using storage::MysqlConnection;
+using storage::MysqlConnectionPool;
+
+/* columns are listed, so that result binding does not depend on table layout */
+static std::string stmtSql(int stmt) {
+    std::string table = config::MYSQL_TABLE_NAME;
+    std::string columns = "FILE_NAME, NODE_RANK, ITERATION, STATE, SIZE";
+    switch (stmt) {
+    case storage::STMT_SAVE:
+        return "REPLACE INTO " + table + " (" + columns + ") VALUES (?, ?, ?, ?, ?)";
+    case storage::STMT_LOAD:
+        return "SELECT " + columns + " FROM " + table + " WHERE FILE_NAME = ?";
+    case storage::STMT_UPDATE_STATE:
+        return "UPDATE " + table + " SET STATE = ? WHERE FILE_NAME = ?";
+    case storage::STMT_DELETE:
+        return "DELETE FROM " + table + " WHERE FILE_NAME = ?";
+    case storage::STMT_BATCH_SAVE: {
+        std::string sql = "REPLACE INTO " + table + " (" + columns + ") VALUES (?, ?, ?, ?, ?)";
+        for (int i = 1; i < config::MYSQL_BATCH_ROWS; i++) {
+            sql += ", (?, ?, ?, ?, ?)";
+        }
+        return sql;
+    }
+    case storage::STMT_BATCH_DELETE: {
+        std::string sql = "DELETE FROM " + table + " WHERE FILE_NAME IN (?";
+        for (int i = 1; i < config::MYSQL_BATCH_ROWS; i++) {
+            sql += ", ?";
+        }
+        return sql + ")";
+    }
+    case storage::STMT_BATCH_UPDATE_STATE: {
+        std::string sql = "UPDATE " + table + " SET STATE = ? WHERE FILE_NAME IN (?";
+        for (int i = 1; i < config::MYSQL_BATCH_ROWS; i++) {
+            sql += ", ?";
+        }
+        return sql + ")";
+    }
+    default:
+        /* a negative rank or state and an empty iteration match any */
+        return "SELECT " + columns + " FROM " + table
+               + " WHERE (? < 0 OR NODE_RANK = ?) AND (? = '' OR ITERATION = ?) AND (? < 0 OR STATE = ?)";
+    }
+}
+
+static const char *STMT_NAME[storage::STMT_NUM] = {"save", "load", "update_state", "delete", "batch_load",
+                                                       "batch_save", "batch_delete", "batch_update_state"};
+
+/* mysql_init is not thread-safe before library is initialized */
+static std::mutex init_mut;
+
+MysqlConnectionPool::MysqlConnectionPool() {
+    db_addr_ = util::Util::GetEnv(config::ENV_KEY_MYSQL_ADDR, "0.0.0.0");
+    db_port_ = std::atoi(util::Util::GetEnv(config::ENV_KEY_MYSQL_PORT, "3306").c_str());
+    db_user_ = util::Util::GetEnv(config::ENV_KEY_MYSQL_USER, "root");
+    db_password_ = util::Util::GetEnv(config::ENV_KEY_MYSQL_PASSWORD);
+
+    // hardcode db name
+    db_name_ = std::string("engine");
+
+    capacity_ = std::max(1UL, std::stoul(util::Util::GetEnv(config::ENV_KEY_MYSQL_POOL_SIZE,
+                                                             config::DEFAULT_MYSQL_POOL_SIZE)));
+    for (int i = 0; i < STMT_NUM; i++) {
+        latency_[i] = std::make_unique<bvar::LatencyRecorder>("ckpt_engine_mysql", STMT_NAME[i]);
+    }
+
+    /* statements are prepared against the table */
+    auto conn = new MysqlConnection();
+    if (!open(conn)) {
+        LOG_FATAL("cannot connect to mysql: {}", mysql_error(conn->sql));
+    }
+    createTable(conn);
+    if (!prepare(conn)) {
+        LOG_FATAL("cannot prepare statements: {}", mysql_error(conn->sql));
+    }
+    created_ = 1;
+    release(conn);
+    LOG_INFO("mysql pool of {}:{} with at most {} connections", db_addr_, db_port_, capacity_);
+}
+
+MysqlConnectionPool::~MysqlConnectionPool() {
+    std::lock_guard<std::mutex> lock(mut_);
+    for (auto conn : idle_) {
+        close(conn);
+        delete conn;
+    }
+}
+
+void MysqlConnectionPool::createTable(MysqlConnection *conn) {
+    std::string createCmd = "CREATE TABLE IF NOT EXISTS " + std::string(config::MYSQL_TABLE_NAME)
+                            + " (FILE_NAME   varchar(512)   PRIMARY KEY     NOT NULL,"
+                              "  NODE_RANK   INT                            NOT NULL,"
+                              "  ITERATION   TEXT                           NOT NULL,"
+                              "  STATE       INT                            NOT NULL,"
+                              "  SIZE        BIGINT UNSIGNED                NOT NULL);";
+
+    int ret = mysql_query(conn->sql, createCmd.c_str());
+    if (ret) {
+        LOG_FATAL("create table failed: {}", mysql_error(conn->sql));
+    }
+    LOG_TRACE("Table {} created successfully", config::MYSQL_TABLE_NAME);
+
+    if (util::Util::GetEnv(config::ENV_KEY_MYSQL_FLUSH_TABLE, "false") == "true") {
+        std::string delete_cmd = "DELETE FROM " + std::string(config::MYSQL_TABLE_NAME) + " ;";
+        ret = mysql_query(conn->sql, delete_cmd.c_str());
+        if (ret) {
+            LOG_FATAL("create table failed: {}", mysql_error(conn->sql));
+        }
+    }
+}
+
+bool MysqlConnectionPool::open(MysqlConnection *conn) {
+    {
+        std::lock_guard<std::mutex> lock(init_mut);
+        conn->sql = mysql_init(nullptr);
+    }
+    if (!conn->sql) {
+        LOG_ERROR("cannot init mysql");
+        return false;
+    }
+    unsigned int timeout = config::MYSQL_TIMEOUT_SECONDS;
+    mysql_options(conn->sql, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+    mysql_options(conn->sql, MYSQL_OPT_READ_TIMEOUT, &timeout);
+    mysql_options(conn->sql, MYSQL_OPT_WRITE_TIMEOUT, &timeout);
+    if (!mysql_real_connect(conn->sql, db_addr_.c_str(), db_user_.c_str(), db_password_.c_str(),
+                            db_name_.c_str(), db_port_, nullptr, 0)) {
+        LOG_ERROR("cannot connect to mysql {}:{}: {}", db_addr_, db_port_, mysql_error(conn->sql));
+        return false;
+    }
+    conn->broken = false;
+    return true;
+}
+
+bool MysqlConnectionPool::prepare(MysqlConnection *conn) {
+    for (int i = 0; i < STMT_NUM; i++) {
+        conn->stmts[i] = mysql_stmt_init(conn->sql);
+        if (conn->stmts[i] == nullptr) {
+            LOG_ERROR("init statement {} failed: {}", STMT_NAME[i], mysql_error(conn->sql));
+            return false;
+        }
+        auto sql = stmtSql(i);
+        if (mysql_stmt_prepare(conn->stmts[i], sql.c_str(), sql.size()) != 0) {
+            LOG_ERROR("prepare statement {} failed: {}", STMT_NAME[i], mysql_stmt_error(conn->stmts[i]));
+            return false;
+        }
+    }
+    return true;
+}
+
+void MysqlConnectionPool::close(MysqlConnection *conn) {
+    for (auto &stmt : conn->stmts) {
+        if (stmt != nullptr) {
+            mysql_stmt_close(stmt);
+            stmt = nullptr;
+        }
+    }
+    if (conn->sql != nullptr) {
+        mysql_close(conn->sql);
+        conn->sql = nullptr;
+    }
+}
+
+MysqlConnection *MysqlConnectionPool::acquire() {
+    MysqlConnection *conn = nullptr;
+    {
+        std::unique_lock<std::mutex> lock(mut_);
+        if (idle_.empty() && created_ >= capacity_) {
+            waits_ << 1;
+            cv_.wait(lock, [this]() {
+                return !idle_.empty() || created_ < capacity_;
+            });
+        }
+        if (!idle_.empty()) {
+            conn = idle_.back();
+            idle_.pop_back();
+        } else {
+            created_++;
+        }
+    }
+
+    if (conn != nullptr) {
+        auto idle = std::chrono::steady_clock::now() - conn->last_used;
+        if (idle < std::chrono::seconds(config::MYSQL_PING_IDLE_SECONDS) || mysql_ping(conn->sql) == 0) {
+            return conn;
+        }
+        LOG_WARN("mysql connection is dead after idle for {} seconds: {}, reconnect",
+                 std::chrono::duration_cast<std::chrono::seconds>(idle).count(), mysql_error(conn->sql));
+        close(conn);
+        reconnects_ << 1;
+    } else {
+        conn = new MysqlConnection();
+    }
+    if (open(conn) && prepare(conn)) {
+        return conn;
+    }
+    close(conn);
+    delete conn;
+    std::lock_guard<std::mutex> lock(mut_);
+    created_--;
+    cv_.notify_one();
+    return nullptr;
+}
+
+void MysqlConnectionPool::release(MysqlConnection *conn) {
+    bool broken = conn->broken;
+    if (broken) {
+        close(conn);
+        delete conn;
+        reconnects_ << 1;
+    }
+    std::lock_guard<std::mutex> lock(mut_);
+    if (broken) {
+        created_--;
+    } else {
+        conn->last_used = std::chrono::steady_clock::now();
+        idle_.push_back(conn);
+    }
+    cv_.notify_one();
+}
+
+void MysqlConnectionPool::CheckLost(MysqlConnection &conn, MYSQL_STMT *stmt) {
+    auto err = mysql_stmt_errno(stmt);
+    if (err == CR_SERVER_GONE_ERROR || err == CR_SERVER_LOST) {
+        conn.broken = true;
+    }
+}
+
+int MysqlConnectionPool::Run(MysqlStatement stmt, const std::function<int(MysqlConnection &, MYSQL_STMT *)> &fn) {
+    auto start_time = std::chrono::steady_clock::now();
+    int rc = api::STATUS_UNKNOWN_ERROR;
+    /* a lost connection is retried once on another one */
+    for (int attempt = 0; attempt < 2; attempt++) {
+        auto conn = acquire();
+        if (conn == nullptr) {
+            break;
+        }
+        rc = fn(*conn, conn->stmts[stmt]);
+        /* drop pending results, so that statement can be executed again */
+        mysql_stmt_free_result(conn->stmts[stmt]);
+        mysql_stmt_reset(conn->stmts[stmt]);
+        bool lost = conn->broken;
+        release(conn);
+        if (!lost) {
+            break;
+        }
+        LOG_WARN("mysql connection lost during {}, retry", STMT_NAME[stmt]);
+    }
+    *latency_[stmt] << std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - start_time)
+                           .count();
+    return rc;
+}
@@ -0,0 +1,444 @@
+/**
+ * @file object_store.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/object_store.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <utility>
+
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+
+#include "config/config.h"
+#include "logger/logger.h"
+
+using storage::S3Client;
+
+static const char *methodString(brpc::HttpMethod method) {
+    switch (method) {
+    case brpc::HTTP_METHOD_GET:
+        return "GET";
+    case brpc::HTTP_METHOD_PUT:
+        return "PUT";
+    case brpc::HTTP_METHOD_POST:
+        return "POST";
+    case brpc::HTTP_METHOD_DELETE:
+        return "DELETE";
+    case brpc::HTTP_METHOD_HEAD:
+        return "HEAD";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+static std::string toHex(const unsigned char *data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(size * 2);
+    for (size_t i = 0; i < size; i++) {
+        hex.push_back(digits[data[i] >> 4]);
+        hex.push_back(digits[data[i] & 0xf]);
+    }
+    return hex;
+}
+
+static std::string sha256Hex(const std::string &data) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char *>(data.data()), data.size(), digest);
+    return toHex(digest, sizeof(digest));
+}
+
+static std::string md5Hex(const char *data, size_t size) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    EVP_Digest(data, size, digest, &len, EVP_md5(), nullptr);
+    return toHex(digest, len);
+}
+
+static std::string hmacSha256(const std::string &key, const std::string &data) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+         reinterpret_cast<const unsigned char *>(data.data()), data.size(), digest, &len);
+    return std::string(reinterpret_cast<char *>(digest), len);
+}
+
+/* uri encoding required by signature version 4, '/' is kept in object key */
+static std::string uriEncode(const std::string &in, bool encode_slash) {
+    static const char digits[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : in) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || (c == '/' && !encode_slash)) {
+            out.push_back(c);
+        } else {
+            out.push_back('%');
+            out.push_back(digits[c >> 4]);
+            out.push_back(digits[c & 0xf]);
+        }
+    }
+    return out;
+}
+
+/* canonical query string, sorted by key */
+static std::string queryString(std::vector<std::pair<std::string, std::string>> params) {
+    std::sort(params.begin(), params.end());
+    std::string query;
+    for (auto &[key, value] : params) {
+        if (!query.empty()) {
+            query += "&";
+        }
+        query += uriEncode(key, true) + "=" + uriEncode(value, true);
+    }
+    return query;
+}
+
+/* value of the first <tag> in xml body */
+static std::string xmlValue(const std::string &xml, const std::string &tag) {
+    auto begin = xml.find("<" + tag + ">");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    begin += tag.size() + 2;
+    auto end = xml.find("</" + tag + ">", begin);
+    return end == std::string::npos ? "" : xml.substr(begin, end - begin);
+}
+
+S3Client::S3Client(const ObjectStoreConfig &config) :
+    config_(config), pool_(config.concurrency) {
+    brpc::ChannelOptions options;
+    options.protocol = brpc::PROTOCOL_HTTP;
+    options.timeout_ms = config::SSO_TIMEOUT_MS;
+    options.connect_timeout_ms = config::SSO_TIMEOUT_MS;
+    options.max_retry = 0; /* parts are retried by ourselves */
+    /* pooled connections let parts be sent concurrently */
+    options.connection_type = "pooled";
+    if (channel_.Init(config_.endpoint.c_str(), &options) != 0) {
+        LOG_ERROR("failed to init channel to object store {}", config_.endpoint);
+        return;
+    }
+    valid_ = true;
+    LOG_INFO("object store {}, bucket {}, part size {} MB, concurrency {}",
+             config_.endpoint, config_.bucket, config_.part_size >> 20, config_.concurrency);
+}
+
+void S3Client::sign(brpc::Controller &cntl, const std::string &method, const std::string &path,
+                    const std::string &query) {
+    char amz_date[32];
+    char date[16];
+    time_t now = time(nullptr);
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    strftime(amz_date, sizeof(amz_date), "%Y%m%dT%H%M%SZ", &tm);
+    strftime(date, sizeof(date), "%Y%m%d", &tm);
+
+    /* payload is not hashed, it would double the cost of uploading */
+    const std::string payload_hash = "UNSIGNED-PAYLOAD";
+    const std::string signed_headers = "host;x-amz-content-sha256;x-amz-date";
+    auto canonical_request = method + "\n" + path + "\n" + query + "\n"
+                             + "host:" + config_.endpoint + "\n"
+                             + "x-amz-content-sha256:" + payload_hash + "\n"
+                             + "x-amz-date:" + amz_date + "\n\n"
+                             + signed_headers + "\n" + payload_hash;
+
+    auto scope = std::string(date) + "/" + config_.region + "/s3/aws4_request";
+    auto string_to_sign = std::string("AWS4-HMAC-SHA256\n") + amz_date + "\n" + scope + "\n" + sha256Hex(canonical_request);
+
+    auto key = hmacSha256("AWS4" + config_.secret_key, date);
+    key = hmacSha256(key, config_.region);
+    key = hmacSha256(key, "s3");
+    key = hmacSha256(key, "aws4_request");
+    auto signature = hmacSha256(key, string_to_sign);
+
+    auto &header = cntl.http_request();
+    header.SetHeader("Host", config_.endpoint);
+    header.SetHeader("x-amz-content-sha256", payload_hash);
+    header.SetHeader("x-amz-date", amz_date);
+    header.SetHeader("Authorization", "AWS4-HMAC-SHA256 Credential=" + config_.access_key + "/" + scope
+                                          + ", SignedHeaders=" + signed_headers
+                                          + ", Signature=" + toHex(reinterpret_cast<const unsigned char *>(signature.data()), signature.size()));
+}
+
+int S3Client::request(brpc::Controller &cntl, brpc::HttpMethod method, const std::string &key,
+                      const std::string &query) {
+    auto path = "/" + config_.bucket + "/" + uriEncode(key, false);
+    cntl.http_request().set_method(method);
+    cntl.http_request().uri() = "http://" + config_.endpoint + path + (query.empty() ? "" : "?" + query);
+    sign(cntl, methodString(method), path, query);
+
+    channel_.CallMethod(nullptr, &cntl, nullptr, nullptr, nullptr);
+    /* non-2xx is also marked failed by brpc, status code is still available */
+    auto status = cntl.http_response().status_code();
+    if (cntl.Failed()) {
+        LOG_WARN("{} {} {} failed, status {}: {} {}", methodString(method), key, query, status, cntl.ErrorText(),
+                 cntl.response_attachment().to_string());
+    }
+    return status;
+}
+
+bool S3Client::putObject(const std::string &key, const void *data, size_t size, const Throttle &throttle) {
+    for (int attempt = 0; attempt < config::SSO_MAX_RETRY; attempt++) {
+        if (!throttle(size)) {
+            return false;
+        }
+        brpc::Controller cntl;
+        cntl.request_attachment().append_user_data(const_cast<void *>(data), size, [](void *) {});
+        if (request(cntl, brpc::HTTP_METHOD_PUT, key, "") == 200) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(1 << attempt));
+    }
+    LOG_ERROR("failed to put object {}", key);
+    return false;
+}
+
+bool S3Client::createMultipartUpload(const std::string &key, MultipartUpload &upload) {
+    brpc::Controller cntl;
+    if (request(cntl, brpc::HTTP_METHOD_POST, key, queryString({{"uploads", ""}})) != 200) {
+        LOG_ERROR("failed to create multipart upload of {}", key);
+        return false;
+    }
+    upload.upload_id = xmlValue(cntl.response_attachment().to_string(), "UploadId");
+    if (upload.upload_id.empty()) {
+        LOG_ERROR("no upload id in response of creating multipart upload {}", key);
+        return false;
+    }
+    LOG_DEBUG("create multipart upload {} of {}", upload.upload_id, key);
+    return true;
+}
+
+bool S3Client::uploadPart(const std::string &key, MultipartUpload &upload, size_t part, const char *data,
+                          const Throttle &throttle, bool &aborted) {
+    size_t offset = part * upload.part_size;
+    size_t len = std::min(upload.part_size, upload.size - offset);
+    /* part number starts from 1 */
+    auto query = queryString({{"partNumber", std::to_string(part + 1)}, {"uploadId", upload.upload_id}});
+
+    if (!throttle(len)) {
+        aborted = true;
+        return false;
+    }
+    brpc::Controller cntl;
+    /* slice from caller's memory, no copy */
+    cntl.request_attachment().append_user_data(const_cast<char *>(data + offset), len, [](void *) {});
+    if (request(cntl, brpc::HTTP_METHOD_PUT, key, query) != 200) {
+        return false;
+    }
+    auto etag = cntl.http_response().GetHeader("ETag");
+    if (!etag) {
+        LOG_WARN("no etag in response of uploading part {} of {}", part + 1, key);
+        return false;
+    }
+    upload.etags[part] = *etag;
+    return true;
+}
+
+bool S3Client::completeMultipartUpload(const std::string &key, MultipartUpload &upload) {
+    std::string body = "<CompleteMultipartUpload>";
+    for (size_t i = 0; i < upload.etags.size(); i++) {
+        body += "<Part><PartNumber>" + std::to_string(i + 1) + "</PartNumber><ETag>" + upload.etags[i] + "</ETag></Part>";
+    }
+    body += "</CompleteMultipartUpload>";
+
+    brpc::Controller cntl;
+    cntl.request_attachment().append(body);
+    if (request(cntl, brpc::HTTP_METHOD_POST, key, queryString({{"uploadId", upload.upload_id}})) != 200) {
+        LOG_ERROR("failed to complete multipart upload {} of {}", upload.upload_id, key);
+        return false;
+    }
+    /* s3 may report error with status 200 after the body started streaming */
+    auto response = cntl.response_attachment().to_string();
+    if (response.find("<Error>") != std::string::npos) {
+        LOG_ERROR("failed to complete multipart upload {} of {}: {}", upload.upload_id, key, response);
+        return false;
+    }
+    return true;
+}
+
+bool S3Client::samePart(const MultipartUpload &upload, size_t part, const char *data) {
+    size_t offset = part * upload.part_size;
+    size_t len = std::min(upload.part_size, upload.size - offset);
+    /* etag of a part is quoted md5 of its content, unless server side encryption by kms is used, in which case
+     * the part never matches and is uploaded again */
+    auto etag = upload.etags[part];
+    etag.erase(std::remove(etag.begin(), etag.end(), '"'), etag.end());
+    return etag == md5Hex(data + offset, len);
+}
+
+void S3Client::abortMultipartUpload(const std::string &key, const std::string &upload_id) {
+    brpc::Controller cntl;
+    request(cntl, brpc::HTTP_METHOD_DELETE, key, queryString({{"uploadId", upload_id}}));
+}
+
+bool S3Client::Upload(const std::string &key, const void *data, size_t size, const Throttle &throttle) {
+    if (size <= config_.part_size) {
+        return putObject(key, data, size, throttle);
+    }
+
+    /* resume unfinished upload of the same object, uploaded parts are checked against new data since the object
+     * may be written with different content of the same size */
+    MultipartUpload upload;
+    bool resumed = false;
+    {
+        std::lock_guard<std::mutex> lock(mut_);
+        auto it = pending_uploads_.find(key);
+        if (it != pending_uploads_.end()) {
+            if (it->second.size == size && it->second.part_size == config_.part_size) {
+                upload = it->second;
+                resumed = true;
+                LOG_INFO("resume multipart upload {} of {}", upload.upload_id, key);
+            } else {
+                abortMultipartUpload(key, it->second.upload_id);
+            }
+            pending_uploads_.erase(it);
+        }
+    }
+    if (upload.upload_id.empty()) {
+        upload.size = size;
+        upload.part_size = config_.part_size;
+        if (!createMultipartUpload(key, std::ref(upload))) {
+            return false;
+        }
+    }
+    size_t parts = (size + upload.part_size - 1) / upload.part_size;
+    upload.etags.resize(parts);
+
+    /* part i is uploaded by worker i % workers, a failed part does not stop others so that more can be resumed */
+    auto base = static_cast<const char *>(data);
+    std::atomic<bool> failed(false);
+    std::atomic<bool> aborted(false);
+    size_t workers = std::min(parts, pool_.Size());
+    auto uploadParts = [&](size_t worker) {
+        for (size_t i = worker; i < parts && !aborted; i += workers) {
+            if (!upload.etags[i].empty()) {
+                if (!resumed || samePart(upload, i, base)) {
+                    continue;
+                }
+                LOG_INFO("part {} of {} changes since uploaded, upload it again", i + 1, key);
+                upload.etags[i].clear();
+            }
+            bool ok = false;
+            bool part_aborted = false;
+            for (int attempt = 0; attempt < config::SSO_MAX_RETRY && !ok && !part_aborted; attempt++) {
+                if (attempt > 0) {
+                    std::this_thread::sleep_for(std::chrono::seconds(1 << attempt));
+                }
+                ok = uploadPart(key, std::ref(upload), i, base, throttle, std::ref(part_aborted));
+            }
+            if (part_aborted) {
+                aborted = true;
+                return;
+            }
+            if (!ok) {
+                LOG_ERROR("failed to upload part {} of {} after {} attempts", i + 1, key, config::SSO_MAX_RETRY);
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < workers; i++) {
+        futures.push_back(pool_.Submit([&uploadParts, i]() { uploadParts(i); }));
+    }
+    for (auto &f : futures) {
+        f.wait();
+    }
+
+    /* an aborted upload is not wanted any more, drop uploaded parts instead of resuming */
+    if (aborted) {
+        LOG_INFO("multipart upload {} of {} aborted", upload.upload_id, key);
+        abortMultipartUpload(key, upload.upload_id);
+        return false;
+    }
+    if (failed || !completeMultipartUpload(key, std::ref(upload))) {
+        std::lock_guard<std::mutex> lock(mut_);
+        pending_uploads_[key] = upload;
+        return false;
+    }
+    return true;
+}
+
+bool S3Client::Download(const std::string &key, void *data, size_t size, size_t offset) {
+    auto base = static_cast<char *>(data);
+    size_t parts = (size + config_.part_size - 1) / config_.part_size;
+    size_t workers = std::min(parts, pool_.Size());
+    std::atomic<bool> failed(false);
+    auto downloadParts = [&](size_t worker) {
+        for (size_t i = worker; i < parts && !failed; i += workers) {
+            size_t begin = i * config_.part_size;
+            size_t len = std::min(config_.part_size, size - begin);
+            bool ok = false;
+            for (int attempt = 0; attempt < config::SSO_MAX_RETRY && !ok; attempt++) {
+                if (attempt > 0) {
+                    std::this_thread::sleep_for(std::chrono::seconds(1 << attempt));
+                }
+                brpc::Controller cntl;
+                cntl.http_request().SetHeader("Range", "bytes=" + std::to_string(offset + begin) + "-"
+                                                           + std::to_string(offset + begin + len - 1));
+                auto status = request(cntl, brpc::HTTP_METHOD_GET, key, "");
+                if (status != 206 && status != 200) {
+                    continue;
+                }
+                if (cntl.response_attachment().size() != len) {
+                    LOG_WARN("range {} of {} returns {} bytes, expect {}", offset + begin, key,
+                             cntl.response_attachment().size(), len);
+                    continue;
+                }
+                cntl.response_attachment().copy_to(base + begin, len);
+                ok = true;
+            }
+            if (!ok) {
+                LOG_ERROR("failed to download range {} length {} of {}", offset + begin, len, key);
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < workers; i++) {
+        futures.push_back(pool_.Submit([&downloadParts, i]() { downloadParts(i); }));
+    }
+    for (auto &f : futures) {
+        f.wait();
+    }
+    return !failed;
+}
+
+bool S3Client::Head(const std::string &key, size_t &size) {
+    /* content-length of HEAD is consumed by http parser, read total size from content-range instead */
+    brpc::Controller cntl;
+    cntl.http_request().SetHeader("Range", "bytes=0-0");
+    auto status = request(cntl, brpc::HTTP_METHOD_GET, key, "");
+    if (status == 200) { /* empty object ignores range */
+        size = cntl.response_attachment().size();
+        return true;
+    }
+    if (status != 206) {
+        return false;
+    }
+    auto range = cntl.http_response().GetHeader("Content-Range");
+    if (!range || range->find('/') == std::string::npos) {
+        LOG_ERROR("invalid content-range of {}", key);
+        return false;
+    }
+    size = std::stoull(range->substr(range->find('/') + 1));
+    return true;
+}
+
+bool S3Client::Delete(const std::string &key) {
+    brpc::Controller cntl;
+    auto status = request(cntl, brpc::HTTP_METHOD_DELETE, key, "");
+    return status == 204 || status == 200 || status == 404;
+}
@@ -12,14 +12,354 @@
 #include "storage/persistence.h"
 
 #include <error.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/file.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <map>
+
+#include <openssl/sha.h>
 
 #include "logger/logger.h"
+#include "operator/bandwidth_limiter.h"
+#include "util/io_uring.h"
+#include "util/util.h"
 
+using operators::BandwidthLimiter;
+using operators::TrafficStage;
 using storage::Persistence;
 
-bool Persistence::WriteToDisk(std::string &file_name, const void *data, size_t size) {
+/* create or truncate file_name and write data, optionally flush to device before returning */
+static bool writeFile(const std::string &file_name, const char *data, size_t size, bool sync) {
+    int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("failed to open file {} error: {}, you may not have permission to create it",
+                  file_name, strerror(errno));
+        return false;
+    }
+    bool ok = true;
+    if (!util::Util::PwriteAll(fd, data, size, 0)) {
+        LOG_ERROR("write {} bytes to file {} failed: {}", size, file_name, strerror(errno));
+        ok = false;
+    }
+    if (ok && sync && fdatasync(fd) != 0) {
+        LOG_ERROR("failed to fdatasync file {}: {}", file_name, strerror(errno));
+        ok = false;
+    }
+    if (close(fd) != 0 && ok) {
+        LOG_ERROR("failed to close file {}: {}", file_name, strerror(errno));
+        ok = false;
+    }
+    return ok;
+}
+
+static std::string toHex(const unsigned char *data, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(size * 2);
+    for (size_t i = 0; i < size; i++) {
+        hex.push_back(digits[data[i] >> 4]);
+        hex.push_back(digits[data[i] & 0xf]);
+    }
+    return hex;
+}
+
+static std::string chunkPath(const std::string &dir, const unsigned char *digest) {
+    auto hex = toHex(digest, SHA256_DIGEST_LENGTH);
+    return dir + "/" + hex.substr(0, 2) + "/" + hex;
+}
+
+Persistence::Persistence() {
+    engine_ = util::Util::GetEnv(config::ENV_KEY_PERSIST_ENGINE, config::PERSIST_ENGINE_STDIO);
+    if (engine_ != config::PERSIST_ENGINE_STDIO && engine_ != config::PERSIST_ENGINE_URING
+        && engine_ != config::PERSIST_ENGINE_STRIPED && engine_ != config::PERSIST_ENGINE_ZEROCOPY) {
+        LOG_FATAL("persistence engine {} unsupported", engine_);
+    }
+
+    uring_queue_depth_ = std::stoul(util::Util::GetEnv(config::ENV_KEY_URING_QUEUE_DEPTH,
+                                                       config::DEFAULT_URING_QUEUE_DEPTH));
+    uring_queue_depth_ = std::max(uring_queue_depth_, 1U);
+
+    /* a single sqe carries at most 4GB, keep block far below and aligned */
+    size_t block_mb = std::stoul(util::Util::GetEnv(config::ENV_KEY_URING_BLOCK_MB, config::DEFAULT_URING_BLOCK_MB));
+    block_mb = std::min(std::max(block_mb, 1UL), 1024UL);
+    uring_block_size_ = block_mb * 1024 * 1024;
+
+    LOG_INFO("persistence engine {}, uring queue depth {}, uring block size {} MB",
+             engine_, uring_queue_depth_, block_mb);
+
+    auto chunk_store_dir = util::Util::GetEnv(config::ENV_KEY_CHUNK_STORE_DIR, "");
+    if (!chunk_store_dir.empty()) {
+        std::error_code ec;
+        /* the directory is recorded in manifests, must not depend on cwd */
+        chunk_store_dir_ = std::filesystem::absolute(chunk_store_dir, ec).lexically_normal().string();
+        std::filesystem::create_directories(chunk_store_dir_, ec);
+        if (ec) {
+            LOG_FATAL("failed to create chunk store {}: {}", chunk_store_dir_, ec.message());
+        }
+        size_t chunk_mb = std::stoul(util::Util::GetEnv(config::ENV_KEY_CHUNK_MB, config::DEFAULT_CHUNK_MB));
+        chunk_size_ = std::max(chunk_mb, 1UL) * 1024 * 1024;
+        LOG_INFO("incremental persistence enabled, chunk store {}, chunk size {} MB", chunk_store_dir_, chunk_size_ >> 20);
+    }
+
+    size_t read_chunk_mb = std::stoul(util::Util::GetEnv(config::ENV_KEY_RESTORE_CHUNK_MB,
+                                                         config::DEFAULT_RESTORE_CHUNK_MB));
+    read_chunk_size_ = std::max(read_chunk_mb, 1UL) * 1024 * 1024;
+
+    auto compression = util::Util::GetEnv(config::ENV_KEY_COMPRESSION, config::COMPRESSION_NONE);
+    if (compression == config::COMPRESSION_ZSTD) {
+        int level = std::stoi(util::Util::GetEnv(config::ENV_KEY_COMPRESSION_LEVEL, config::DEFAULT_COMPRESSION_LEVEL));
+        size_t frame_mb = std::stoul(util::Util::GetEnv(config::ENV_KEY_COMPRESSION_FRAME_MB,
+                                                        config::DEFAULT_COMPRESSION_FRAME_MB));
+        compressor_ = std::make_unique<SeekableZstd>(level, frame_mb * 1024 * 1024);
+        LOG_INFO("compression zstd enabled, level {}, frame size {} MB", level, frame_mb);
+        if (!chunk_store_dir_.empty()) {
+            LOG_WARN("compression is ignored since incremental persistence is enabled");
+        }
+    } else if (compression != config::COMPRESSION_NONE) {
+        LOG_FATAL("compression {} unsupported", compression);
+    }
+
+    auto dirs = util::Util::GetEnv(config::ENV_KEY_PERSIST_DIRS, "");
+    if (!dirs.empty()) {
+        size_t stripe_mb = std::stoul(util::Util::GetEnv(config::ENV_KEY_STRIPE_MB, config::DEFAULT_STRIPE_MB));
+        size_t concurrency = std::stoul(util::Util::GetEnv(config::ENV_KEY_PERSIST_DIR_CONCURRENCY,
+                                                           config::DEFAULT_PERSIST_DIR_CONCURRENCY));
+        auto dir_list = util::Util::Split(dirs, ',');
+        for (auto &dir : dir_list) {
+            dir.erase(0, dir.find_first_not_of(" \t"));
+            dir.erase(dir.find_last_not_of(" \t") + 1);
+        }
+        dir_list.erase(std::remove(dir_list.begin(), dir_list.end(), ""), dir_list.end());
+        if (dir_list.empty()) {
+            LOG_FATAL("{} '{}' has no directory", config::ENV_KEY_PERSIST_DIRS, dirs);
+        }
+        placement_ = std::make_unique<DevicePlacement>(dir_list, std::max(stripe_mb, 1UL) * 1024 * 1024,
+                                                       std::max(concurrency, 1UL));
+        if (!chunk_store_dir_.empty() || compressor_) {
+            LOG_WARN("persistence directories are ignored since incremental persistence or compression is enabled");
+        }
+    }
+
+    auto endpoint = util::Util::GetEnv(config::ENV_KEY_SSO_ENDPOINT, "");
+    if (!endpoint.empty()) {
+        ObjectStoreConfig c;
+        c.endpoint = endpoint;
+        c.region = util::Util::GetEnv(config::ENV_KEY_SSO_REGION, config::DEFAULT_SSO_REGION);
+        c.bucket = util::Util::GetEnv(config::ENV_KEY_SSO_BUCKET, "");
+        c.access_key = util::Util::GetEnv(config::ENV_KEY_SSO_ACCESS_KEY, "");
+        c.secret_key = util::Util::GetEnv(config::ENV_KEY_SSO_SECRET_KEY, "");
+        if (c.bucket.empty() || c.access_key.empty() || c.secret_key.empty()) {
+            LOG_FATAL("bucket, access key and secret key of object store {} are required", endpoint);
+        }
+        /* S3 rejects parts smaller than 5MB except the last one */
+        size_t part_mb = std::stoul(util::Util::GetEnv(config::ENV_KEY_SSO_PART_MB, config::DEFAULT_SSO_PART_MB));
+        c.part_size = std::max(part_mb, 5UL) * 1024 * 1024;
+        c.concurrency = std::max(std::stoul(util::Util::GetEnv(config::ENV_KEY_SSO_CONCURRENCY,
+                                                               config::DEFAULT_SSO_CONCURRENCY)), 1UL);
+        /* objects of different jobs are separated by default */
+        auto job = util::Util::GetEnv(config::ENV_KEY_TRANSOM_JOB_KEY, config::DEFAULT_TRANSOM_JOB_KEY);
+        sso_prefix_ = util::Util::GetEnv(config::ENV_KEY_SSO_PREFIX, job.c_str());
+        sso_client_ = std::make_unique<S3Client>(c);
+        if (!sso_client_->Valid()) {
+            LOG_FATAL("failed to connect object store {}", endpoint);
+        }
+    }
+
+    if (engine_ != config::PERSIST_ENGINE_STRIPED) {
+        return;
+    }
+
+    /* mount specific settings, e.g. /mnt/lustre:128:16 */
+    auto mounts = util::Util::GetEnv(config::ENV_KEY_STRIPE_MOUNTS, "");
+    for (auto &item : util::Util::Split(mounts, ',')) {
+        auto fields = util::Util::Split(item, ':');
+        if (fields.size() != 3) {
+            LOG_FATAL("invalid stripe setting {}, expect mount:stripe_mb:concurrency", item);
+        }
+        StripeConfig c;
+        c.mount = fields[0];
+        c.stripe_size = std::max(std::stoul(fields[1]), 1UL) * 1024 * 1024;
+        c.concurrency = std::max(std::stoul(fields[2]), 1UL);
+        stripe_configs_.push_back(c);
+    }
+    /* longest prefix first */
+    std::sort(stripe_configs_.begin(), stripe_configs_.end(), [](const StripeConfig &a, const StripeConfig &b) {
+        return a.mount.length() > b.mount.length();
+    });
+
+    /* default setting matches any path */
+    StripeConfig c;
+    c.mount = "";
+    c.stripe_size = std::max(std::stoul(util::Util::GetEnv(config::ENV_KEY_STRIPE_MB, config::DEFAULT_STRIPE_MB)), 1UL)
+                    * 1024 * 1024;
+    c.concurrency = std::max(std::stoul(util::Util::GetEnv(config::ENV_KEY_STRIPE_CONCURRENCY,
+                                                           config::DEFAULT_STRIPE_CONCURRENCY)),
+                             1UL);
+    stripe_configs_.push_back(c);
+
+    size_t threads = 0;
+    for (auto &c : stripe_configs_) {
+        LOG_INFO("stripe setting of mount '{}': stripe size {} bytes, concurrency {}", c.mount, c.stripe_size, c.concurrency);
+        threads = std::max(threads, c.concurrency);
+    }
+    stripe_pool_ = std::make_unique<util::ThreadPool>(threads);
+}
+
+bool Persistence::WriteToDisk(std::string &file_name, const void *data, size_t size, int memfd) {
+    auto ok = begin(file_name) && writeToDisk(file_name, data, size, memfd);
+    end(file_name, ok);
+    if (ok) {
+        retire(file_name, persistedPath(file_name));
+    }
+    return ok;
+}
+
+std::vector<std::string> Persistence::persistedForms(const std::string &file_name) {
+    return {file_name, file_name + config::PERSIST_MANIFEST_SUFFIX, file_name + config::PERSIST_COMPRESSED_SUFFIX,
+            file_name + config::PERSIST_PLACEMENT_SUFFIX};
+}
+
+std::string Persistence::persistedPath(const std::string &file_name) {
+    if (!chunk_store_dir_.empty()) {
+        return file_name + config::PERSIST_MANIFEST_SUFFIX;
+    }
+    if (compressor_) {
+        return file_name + config::PERSIST_COMPRESSED_SUFFIX;
+    }
+    if (placement_) {
+        return file_name + config::PERSIST_PLACEMENT_SUFFIX;
+    }
+    return file_name;
+}
+
+std::string Persistence::locate(const std::string &file_name) {
+    /* a crash between publishing a form and retiring the others leaves both, the newer one wins */
+    std::string found = file_name;
+    struct timespec newest = {0, 0};
+    for (auto &path : persistedForms(file_name)) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            continue;
+        }
+        if (st.st_mtim.tv_sec > newest.tv_sec
+            || (st.st_mtim.tv_sec == newest.tv_sec && st.st_mtim.tv_nsec > newest.tv_nsec)) {
+            newest = st.st_mtim;
+            found = path;
+        }
+    }
+    return found;
+}
+
+void Persistence::retire(const std::string &file_name, const std::string &kept) {
+    /* refs of a removed manifest are released by the next collection, stripes go with their placement index */
+    for (auto &path : persistedForms(file_name)) {
+        if (path == kept) {
+            continue;
+        }
+        if (DevicePlacement::Remove(path) || unlink(path.c_str()) == 0) {
+            LOG_INFO("{} is persisted as {}, remove stale {}", file_name, kept, path);
+        }
+    }
+}
+
+bool Persistence::Abort(const std::string &file_name) {
+    std::lock_guard<std::mutex> lock(writing_mut_);
+    auto it = writing_.find(file_name);
+    if (it == writing_.end()) {
+        /* the write may not have begun yet, e.g. its metadata is being loaded */
+        aborted_.insert(file_name);
+        return false;
+    }
+    it->second = true;
+    return true;
+}
+
+void Persistence::Forget(const std::string &file_name) {
+    std::lock_guard<std::mutex> lock(writing_mut_);
+    aborted_.erase(file_name);
+}
+
+bool Persistence::begin(const std::string &file_name) {
+    std::lock_guard<std::mutex> lock(writing_mut_);
+    auto aborted = aborted_.erase(file_name) > 0;
+    writing_[file_name] = aborted;
+    return !aborted;
+}
+
+void Persistence::end(const std::string &file_name, bool ok) {
+    std::lock_guard<std::mutex> lock(writing_mut_);
+    if (!ok && writing_[file_name]) {
+        LOG_WARN("persistence of {} aborted", file_name);
+    }
+    writing_.erase(file_name);
+}
+
+bool Persistence::throttle(const std::string &file_name, size_t len) {
+    {
+        std::lock_guard<std::mutex> lock(writing_mut_);
+        auto it = writing_.find(file_name);
+        if (it != writing_.end() && it->second) {
+            return false;
+        }
+    }
+    BandwidthLimiter::Instance().Acquire(TrafficStage::PERSIST, len);
+    return true;
+}
+
+bool Persistence::writeToDisk(std::string &file_name, const void *data, size_t size, int memfd) {
+    /* chunk store takes precedence over engines, since only changed chunks are written */
+    if (!chunk_store_dir_.empty()) {
+        auto manifest = persistedPath(file_name);
+        return writeIncremental(manifest, data, size);
+    }
+    /* compressed frames are written by its own pipeline beside file_name, which is left for plain checkpoints */
+    if (compressor_) {
+        return compressor_->Write(persistedPath(file_name), data, size, workerPool(),
+                                  [this, &file_name](size_t len) { return throttle(file_name, len); });
+    }
+    /* stripes are spread across devices, the placement index is written beside file_name */
+    if (placement_) {
+        return placement_->Write(persistedPath(file_name), data, size,
+                                 [this, &file_name](size_t len) { return throttle(file_name, len); });
+    }
+    if (engine_ == config::PERSIST_ENGINE_ZEROCOPY) {
+        bool fallback = false;
+        if (writeZeroCopy(file_name, memfd, size, std::ref(fallback))) {
+            return true;
+        }
+        if (!fallback) {
+            return false;
+        }
+        LOG_WARN("zero-copy engine unavailable for {}, fallback to stdio", file_name);
+    }
+    if (engine_ == config::PERSIST_ENGINE_URING) {
+        bool fallback = false;
+        if (writeUring(file_name, data, size, std::ref(fallback))) {
+            return true;
+        }
+        if (!fallback) {
+            return false;
+        }
+        LOG_WARN("io_uring engine unavailable for {}, fallback to stdio", file_name);
+    }
+    if (engine_ == config::PERSIST_ENGINE_STRIPED) {
+        return writeStriped(file_name, data, size);
+    }
+    return writeStdio(file_name, data, size);
+}
+
+bool Persistence::writeStdio(std::string &file_name, const void *data, size_t size) {
     auto start_time = std::chrono::high_resolution_clock::now();
 
     auto fp = fopen(file_name.c_str(), "w+"); /* create or write after truncate */
@@ -29,10 +369,23 @@ bool Persistence::WriteToDisk(std::string &file_name, const void *data, size_t s
         return false;
     }
 
-    auto written = fwrite(data, sizeof(char), size, fp);
+    /* write by chunk to be throttled smoothly */
+    size_t written = 0;
+    while (written < size) {
+        auto len = std::min(size - written, config::BANDWIDTH_CHUNK_SIZE);
+        if (!throttle(file_name, len)) {
+            break;
+        }
+        auto n = fwrite(static_cast<const char *>(data) + written, sizeof(char), len, fp);
+        written += n;
+        if (n != len) {
+            break;
+        }
+    }
     if (written != size) {
         LOG_ERROR("write to file {}, expect write {} bytes, return {}, failed: {}",
                   file_name, size, written, strerror(errno));
+        fclose(fp);
         return false;
     }
 
@@ -42,8 +395,806 @@ bool Persistence::WriteToDisk(std::string &file_name, const void *data, size_t s
         return false;
     }
 
+    user_copy_bytes_ << size;
+    report(config::PERSIST_ENGINE_STDIO, file_name, size, start_time);
+    return true;
+}
+
+bool Persistence::writeUring(std::string &file_name, const void *data, size_t size, bool &fallback) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    const size_t align = config::DIRECT_IO_ALIGNMENT;
+    fallback = false;
+
+    /* memfd mapping is page aligned, other callers may not */
+    if (reinterpret_cast<size_t>(data) % align != 0) {
+        LOG_WARN("address {} of {} is not aligned to {} bytes, cannot use O_DIRECT", data, file_name, align);
+        fallback = true;
+        return false;
+    }
+
+    util::IoUring ring(uring_queue_depth_);
+    if (!ring.Valid()) {
+        fallback = true;
+        return false;
+    }
+
+    int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (fd < 0) {
+        if (errno == EINVAL) {
+            LOG_WARN("filesystem of {} does not support O_DIRECT", file_name);
+            fallback = true;
+            return false;
+        }
+        LOG_ERROR("failed to open file {} error: {}, you may not have permission to create it",
+                  file_name, strerror(errno));
+        return false;
+    }
+
+    /* copy the unaligned tail into a zero-padded block, file is truncated to real size at last */
+    auto base = static_cast<const char *>(data);
+    size_t aligned_size = size / align * align;
+    size_t tail = size - aligned_size;
+    void *tail_buf = nullptr;
+    if (tail > 0) {
+        if (posix_memalign(&tail_buf, align, align) != 0) {
+            LOG_ERROR("failed to alloc {} bytes aligned buffer", align);
+            close(fd);
+            return false;
+        }
+        memset(tail_buf, 0, align);
+        memcpy(tail_buf, base + aligned_size, tail);
+    }
+    size_t padded_size = aligned_size + (tail > 0 ? align : 0);
+    auto source = [&](size_t offset) -> const char * {
+        return offset < aligned_size ? base + offset : static_cast<char *>(tail_buf) + (offset - aligned_size);
+    };
+
+    /* in-flight writes, offset -> length, offset is used as user_data */
+    std::map<size_t, size_t> inflight;
+    size_t next_offset = 0;
+    size_t completed = 0;
+    bool ok = true;
+
+    while (ok && completed < padded_size) {
+        /* keep the queue full */
+        while (inflight.size() < uring_queue_depth_ && next_offset < padded_size) {
+            /* never let a block cross the boundary between memfd and tail buffer */
+            size_t len = std::min(uring_block_size_, padded_size - next_offset);
+            if (next_offset < aligned_size) {
+                len = std::min(len, aligned_size - next_offset);
+            }
+            if (!ring.PrepareWrite(fd, source(next_offset), len, next_offset, next_offset)) {
+                break;
+            }
+            inflight[next_offset] = len;
+            next_offset += len;
+            /* charged once the block is queued, an aborted one is drained with the others */
+            if (!throttle(file_name, len)) {
+                ok = false;
+                break;
+            }
+        }
+        if (!ok) {
+            break;
+        }
+        if (auto rc = ring.Submit(); rc < 0) {
+            LOG_ERROR("io_uring submit for {} failed: {}", file_name, strerror(-rc));
+            ok = false;
+            break;
+        }
+
+        uint64_t offset = 0;
+        int res = 0;
+        if (auto rc = ring.WaitCompletion(std::ref(offset), std::ref(res)); rc < 0) {
+            LOG_ERROR("io_uring wait completion for {} failed: {}", file_name, strerror(-rc));
+            ok = false;
+            break;
+        }
+        auto len = inflight[offset];
+        inflight.erase(offset);
+
+        if (res < 0) {
+            /* kernel without IORING_OP_WRITE, or device rejects direct io */
+            if (completed == 0 && (res == -EINVAL || res == -EOPNOTSUPP)) {
+                fallback = true;
+            }
+            LOG_ERROR("io_uring write {} at offset {} length {} failed: {}", file_name, offset, len, strerror(-res));
+            ok = false;
+            break;
+        }
+        /* no progress, resubmitting would loop forever */
+        if (res == 0 && len > 0) {
+            LOG_ERROR("io_uring write {} at offset {} length {} wrote nothing", file_name, offset, len);
+            errno = EIO;
+            ok = false;
+            break;
+        }
+        completed += res;
+
+        /* short write, resubmit the rest */
+        if (static_cast<size_t>(res) < len) {
+            auto rest_offset = offset + res;
+            auto rest_len = len - res;
+            if (!ring.PrepareWrite(fd, source(rest_offset), rest_len, rest_offset, rest_offset)) {
+                LOG_ERROR("io_uring submission queue full when resubmitting short write of {}", file_name);
+                ok = false;
+                break;
+            }
+            inflight[rest_offset] = rest_len;
+        }
+    }
+
+    /* buffers must outlive in-flight requests */
+    while (!inflight.empty()) {
+        if (ring.Submit() < 0) {
+            break;
+        }
+        uint64_t offset = 0;
+        int res = 0;
+        if (ring.WaitCompletion(std::ref(offset), std::ref(res)) < 0) {
+            LOG_FATAL("io_uring cannot drain in-flight writes of {}", file_name);
+        }
+        inflight.erase(offset);
+    }
+
+    if (ok && tail > 0 && ftruncate(fd, size) != 0) {
+        LOG_ERROR("failed to truncate file {} to {} bytes: {}", file_name, size, strerror(errno));
+        ok = false;
+    }
+    if (close(fd) != 0 && ok) {
+        LOG_ERROR("failed to close file {}: {}", file_name, strerror(errno));
+        ok = false;
+    }
+    free(tail_buf);
+
+    if (ok) {
+        direct_io_bytes_ << size;
+        report(config::PERSIST_ENGINE_URING, file_name, size, start_time);
+    }
+    return ok;
+}
+
+bool Persistence::writeZeroCopy(std::string &file_name, int memfd, size_t size, bool &fallback) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    fallback = false;
+
+    if (memfd < 0) {
+        LOG_WARN("no memfd backing {}, cannot copy inside kernel", file_name);
+        fallback = true;
+        return false;
+    }
+
+    int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("failed to open file {} error: {}, you may not have permission to create it",
+                  file_name, strerror(errno));
+        return false;
+    }
+
+    /*
+     * copy_file_range across filesystems is rejected with EXDEV since 5.19, and memfd lives in tmpfs,
+     * so most of the time sendfile does the job, which splices page cache of memfd to the file
+     */
+    const char *method = "copy_file_range";
+    bool use_sendfile = false;
+    loff_t in_offset = 0;
+    loff_t out_offset = 0;
+    bool ok = true;
+    /* bytes before it are charged, so a chunk retried by sendfile, after EINTR or short copy is charged once */
+    size_t charged = 0;
+    while (static_cast<size_t>(in_offset) < size) {
+        ssize_t n;
+        if (static_cast<size_t>(in_offset) >= charged) {
+            auto chunk = std::min(size - in_offset, config::BANDWIDTH_CHUNK_SIZE);
+            if (!throttle(file_name, chunk)) {
+                ok = false;
+                break;
+            }
+            charged = in_offset + chunk;
+        }
+        auto len = charged - in_offset;
+        if (!use_sendfile) {
+            n = copy_file_range(memfd, &in_offset, fd, &out_offset, len, 0);
+            if (n < 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+                LOG_DEBUG("copy_file_range {} unsupported: {}, try sendfile", file_name, strerror(errno));
+                /* sendfile writes at current file offset */
+                if (lseek(fd, out_offset, SEEK_SET) < 0) {
+                    LOG_ERROR("failed to seek {} to {}: {}", file_name, out_offset, strerror(errno));
+                    ok = false;
+                    break;
+                }
+                use_sendfile = true;
+                method = "sendfile";
+                continue;
+            }
+        } else {
+            off_t offset = in_offset;
+            n = sendfile(fd, memfd, &offset, len);
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                LOG_WARN("sendfile {} unsupported: {}", file_name, strerror(errno));
+                fallback = true;
+                ok = false;
+                break;
+            }
+            if (n > 0) {
+                in_offset = offset;
+            }
+        }
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("{} {} at offset {} failed: {}", method, file_name, in_offset, strerror(errno));
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            LOG_ERROR("{} {} reaches end of memfd at {}, expect {} bytes", method, file_name, in_offset, size);
+            ok = false;
+            break;
+        }
+    }
+
+    if (close(fd) != 0 && ok) {
+        LOG_ERROR("failed to close file {}: {}", file_name, strerror(errno));
+        ok = false;
+    }
+    if (!ok) {
+        return false;
+    }
+
+    kernel_copy_bytes_ << size;
+    LOG_DEBUG("persist {} by {}", file_name, method);
+    report(config::PERSIST_ENGINE_ZEROCOPY, file_name, size, start_time);
+    return true;
+}
+
+storage::DevicePlacement &Persistence::placementReader() {
+    if (placement_) {
+        return *placement_;
+    }
+    std::call_once(placement_reader_once_, [this]() {
+        placement_reader_ = std::make_unique<DevicePlacement>(std::vector<std::string>(), 0,
+                                                              config::PERSIST_CONCURRENT_THREADS);
+    });
+    return *placement_reader_;
+}
+
+util::ThreadPool &Persistence::workerPool() {
+    std::call_once(worker_pool_once_, [this]() {
+        worker_pool_ = std::make_unique<util::ThreadPool>(config::PERSIST_CONCURRENT_THREADS);
+    });
+    return *worker_pool_;
+}
+
+bool Persistence::writeIncremental(std::string &file_name, const void *data, size_t size) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto base = static_cast<const char *>(data);
+    size_t chunk_count = (size + chunk_size_ - 1) / chunk_size_;
+    std::vector<unsigned char> digests(chunk_count * SHA256_DIGEST_LENGTH);
+    std::atomic<bool> failed(false);
+    std::atomic<size_t> new_bytes(0);
+
+    /* chunks are not collected until they are referenced by refs of this manifest */
+    int lock_fd = lockChunkStore(LOCK_SH);
+    if (lock_fd < 0) {
+        return false;
+    }
+
+    auto &pool = workerPool();
+    size_t workers = std::min(chunk_count, pool.Size());
+    auto storeChunks = [&](size_t worker) {
+        for (size_t i = worker; i < chunk_count && !failed; i += workers) {
+            size_t offset = i * chunk_size_;
+            size_t len = std::min(chunk_size_, size - offset);
+            auto digest = &digests[i * SHA256_DIGEST_LENGTH];
+            SHA256(reinterpret_cast<const unsigned char *>(base + offset), len, digest);
+
+            /* content addressed, an existing chunk is unchanged since a previous iteration */
+            auto path = chunkPath(chunk_store_dir_, digest);
+            if (access(path.c_str(), F_OK) == 0) {
+                continue;
+            }
+            std::error_code ec;
+            std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+            if (ec) {
+                LOG_ERROR("failed to create directory of chunk {}: {}", path, ec.message());
+                failed = true;
+                return;
+            }
+
+            /* the same chunk may be stored by another file at the same time, use a private temporary name */
+            auto tmp_name = path + config::PERSIST_TMP_SUFFIX + "." + std::to_string(util::Util::GetThreadID());
+            if (!throttle(file_name, len)) {
+                failed = true;
+                return;
+            }
+            if (!writeFile(tmp_name, base + offset, len, true)) {
+                unlink(tmp_name.c_str());
+                failed = true;
+                return;
+            }
+            if (rename(tmp_name.c_str(), path.c_str()) != 0) {
+                LOG_ERROR("failed to rename {} to {}: {}", tmp_name, path, strerror(errno));
+                unlink(tmp_name.c_str());
+                failed = true;
+                return;
+            }
+            new_bytes += len;
+        }
+    };
+
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < workers; i++) {
+        futures.push_back(pool.Submit([&storeChunks, i]() { storeChunks(i); }));
+    }
+    for (auto &f : futures) {
+        f.wait();
+    }
+    if (failed) {
+        LOG_ERROR("failed to store chunks of {}", file_name);
+        close(lock_fd);
+        return false;
+    }
+
+    ChunkManifestHeader header;
+    memcpy(header.magic, config::CHUNK_MANIFEST_MAGIC, sizeof(header.magic));
+    header.size = size;
+    header.chunk_size = chunk_size_;
+    header.chunk_count = chunk_count;
+    header.dir_length = chunk_store_dir_.length();
+    std::string manifest(reinterpret_cast<const char *>(&header), sizeof(header));
+    manifest += chunk_store_dir_;
+    manifest.append(reinterpret_cast<const char *>(digests.data()), digests.size());
+
+    /* reference chunks by hard links, a chunk repeated in the file is referenced once */
+    std::error_code ec;
+    auto owner = std::filesystem::absolute(file_name, ec).lexically_normal().string();
+    auto refs = refDir(owner, manifest);
+    auto tmp_refs = refs + "." + std::to_string(util::Util::GetThreadID()) + config::PERSIST_TMP_SUFFIX;
+    std::filesystem::remove_all(tmp_refs, ec);
+    std::filesystem::create_directories(tmp_refs, ec);
+    bool ok = !ec && writeFile(tmp_refs + "/owner", owner.data(), owner.size(), false);
+    for (size_t i = 0; ok && i < chunk_count; i++) {
+        auto digest = &digests[i * SHA256_DIGEST_LENGTH];
+        auto link_path = tmp_refs + "/" + toHex(digest, SHA256_DIGEST_LENGTH);
+        if (link(chunkPath(chunk_store_dir_, digest).c_str(), link_path.c_str()) != 0 && errno != EEXIST) {
+            LOG_ERROR("failed to reference chunk by {}: {}", link_path, strerror(errno));
+            ok = false;
+        }
+    }
+    /* the same manifest is referenced already if it's persisted again unchanged */
+    if (ok && rename(tmp_refs.c_str(), refs.c_str()) != 0 && errno != ENOTEMPTY && errno != EEXIST) {
+        LOG_ERROR("failed to rename {} to {}: {}", tmp_refs, refs, strerror(errno));
+        ok = false;
+    }
+    std::filesystem::remove_all(tmp_refs, ec);
+
+    /* refs of the manifest being overwritten, released once the new one is published */
+    std::string old_refs;
+    if (std::ifstream in(file_name, std::ios::binary); in) {
+        std::string old_manifest((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        old_refs = refDir(owner, old_manifest);
+    }
+
+    /* chunks are durable and referenced, now publish the manifest */
+    auto tmp_name = file_name + config::PERSIST_TMP_SUFFIX;
+    ok = ok && writeFile(tmp_name, manifest.data(), manifest.size(), true);
+    if (ok && rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+        LOG_ERROR("failed to rename {} to {}: {}", tmp_name, file_name, strerror(errno));
+        ok = false;
+    }
+    close(lock_fd);
+    if (!ok) {
+        /* refs of a manifest never published are released by the next collection */
+        unlink(tmp_name.c_str());
+        return false;
+    }
+    if (!old_refs.empty() && old_refs != refs && (lock_fd = lockChunkStore(LOCK_EX)) >= 0) {
+        releaseRefs(old_refs);
+        close(lock_fd);
+    }
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch())
+                   .count();
+    if (now - last_collect_ >= config::CHUNK_GC_INTERVAL_SECONDS) {
+        last_collect_ = now;
+        collectChunks();
+    }
+
+    chunk_new_bytes_ << new_bytes;
+    chunk_dedup_bytes_ << size - new_bytes;
+    LOG_INFO("incremental persist {}: {} chunks, {} bytes written, {} bytes unchanged",
+             file_name, chunk_count, new_bytes.load(), size - new_bytes);
+    report("incremental", file_name, size, start_time);
+    return true;
+}
+
+int Persistence::lockChunkStore(int operation) {
+    auto path = chunk_store_dir_ + "/.lock";
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("failed to open lock of chunk store {}: {}", path, strerror(errno));
+        return -1;
+    }
+    while (flock(fd, operation) != 0) {
+        if (errno != EINTR) {
+            LOG_ERROR("failed to lock chunk store {}: {}", path, strerror(errno));
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+std::string Persistence::refDir(const std::string &owner, const std::string &manifest) {
+    auto key = owner + '\0' + manifest;
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char *>(key.data()), key.size(), digest);
+    return chunk_store_dir_ + "/refs/" + toHex(digest, SHA256_DIGEST_LENGTH);
+}
+
+void Persistence::releaseRefs(const std::string &dir) {
+    std::error_code ec;
+    for (auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+        auto hex = entry.path().filename().string();
+        unlink(entry.path().c_str());
+        if (hex.size() != SHA256_DIGEST_LENGTH * 2) {
+            continue;
+        }
+        auto path = chunk_store_dir_ + "/" + hex.substr(0, 2) + "/" + hex;
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && st.st_nlink == 1 && unlink(path.c_str()) == 0) {
+            chunk_collected_bytes_ << st.st_size;
+        }
+    }
+    rmdir(dir.c_str());
+}
+
+void Persistence::collectChunks() {
+    std::unique_lock<std::mutex> collect_lock(collect_mut_, std::try_to_lock);
+    if (!collect_lock.owns_lock()) {
+        return;
+    }
+    int lock_fd = lockChunkStore(LOCK_EX);
+    if (lock_fd < 0) {
+        return;
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    int64_t collected = chunk_collected_bytes_.get_value();
+    std::error_code ec;
+
+    /* leftovers of crashed writers, and refs of manifests overwritten, removed by users or never published */
+    std::vector<std::string> released;
+    for (auto &entry : std::filesystem::directory_iterator(chunk_store_dir_ + "/refs", ec)) {
+        auto dir = entry.path().string();
+        std::ifstream owner_in(dir + "/owner");
+        std::string owner((std::istreambuf_iterator<char>(owner_in)), std::istreambuf_iterator<char>());
+        std::ifstream manifest_in(owner, std::ios::binary);
+        std::string manifest((std::istreambuf_iterator<char>(manifest_in)), std::istreambuf_iterator<char>());
+        if (owner.empty() || !manifest_in || refDir(owner, manifest) != dir) {
+            released.push_back(dir);
+        }
+    }
+    for (auto &dir : released) {
+        releaseRefs(dir);
+    }
+
+    /* chunks stored by crashed writers before they were referenced */
+    for (auto &sub : std::filesystem::directory_iterator(chunk_store_dir_, ec)) {
+        if (!sub.is_directory() || sub.path().filename().string().size() != 2) {
+            continue;
+        }
+        for (auto &chunk : std::filesystem::directory_iterator(sub.path(), ec)) {
+            struct stat st;
+            if (stat(chunk.path().c_str(), &st) == 0 && st.st_nlink == 1 && unlink(chunk.path().c_str()) == 0) {
+                chunk_collected_bytes_ << st.st_size;
+            }
+        }
+    }
+    close(lock_fd);
+    auto timeval = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - start_time);
+    LOG_INFO("collect chunk store {}: release {} refs, remove {} bytes of chunks, use {} milliseconds",
+             chunk_store_dir_, released.size(), chunk_collected_bytes_.get_value() - collected, timeval.count());
+}
+
+bool Persistence::ReadFromDisk(const std::string &file_name, void *data, size_t size) {
+    auto path = locate(file_name);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("failed to open file {} error: {}", path, strerror(errno));
+        return false;
+    }
+
+    bool ok;
+    char magic[sizeof(config::CHUNK_MANIFEST_MAGIC)];
+    if (pread(fd, magic, sizeof(magic), 0) == sizeof(magic)
+        && memcmp(magic, config::CHUNK_MANIFEST_MAGIC, sizeof(magic)) == 0) {
+        ok = readManifest(path, fd, data, size);
+    } else if (DevicePlacement::Detect(fd)) {
+        ok = placementReader().Read(path, fd, 0, size, data);
+    } else if (SeekableZstd::Detect(fd)) {
+        /* readable even if compression is turned off afterwards */
+        ok = SeekableZstd::Read(path, fd, 0, size, data, workerPool());
+    } else {
+        ok = readPlain(path, fd, 0, size, data);
+    }
+    close(fd);
+    return ok;
+}
+
+bool Persistence::ReadRangeFromDisk(const std::string &file_name, size_t offset, size_t length, void *data) {
+    auto path = locate(file_name);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("failed to open file {} error: {}", path, strerror(errno));
+        return false;
+    }
+
+    bool ok;
+    char magic[sizeof(config::CHUNK_MANIFEST_MAGIC)];
+    if (pread(fd, magic, sizeof(magic), 0) == sizeof(magic)
+        && memcmp(magic, config::CHUNK_MANIFEST_MAGIC, sizeof(magic)) == 0) {
+        LOG_ERROR("range read of manifest {} is not supported", path);
+        ok = false;
+    } else if (DevicePlacement::Detect(fd)) {
+        ok = placementReader().Read(path, fd, offset, length, data);
+    } else if (SeekableZstd::Detect(fd)) {
+        ok = SeekableZstd::Read(path, fd, offset, length, data, workerPool());
+    } else {
+        ok = readPlain(path, fd, offset, length, data);
+    }
+    close(fd);
+    return ok;
+}
+
+bool Persistence::readPlain(const std::string &file_name, int fd, size_t offset, size_t length, void *data) {
+    auto base = static_cast<char *>(data);
+    std::atomic<bool> failed(false);
+    auto readChunk = [&](size_t begin, size_t end) {
+        if (!util::Util::PreadAll(fd, base + (begin - offset), end - begin, begin)) {
+            LOG_ERROR("read [{}, {}) from file {} failed: {}", begin, end, file_name, strerror(errno));
+            failed = true;
+        }
+    };
+    if (length <= read_chunk_size_) {
+        readChunk(offset, offset + length);
+    } else {
+        std::vector<std::future<void>> futures;
+        for (size_t begin = offset; begin < offset + length; begin += read_chunk_size_) {
+            auto end = std::min(begin + read_chunk_size_, offset + length);
+            futures.push_back(workerPool().Submit([&, begin, end]() {
+                if (!failed) {
+                    readChunk(begin, end);
+                }
+            }));
+        }
+        for (auto &f : futures) {
+            f.wait();
+        }
+    }
+    /* page cache is charged to our cgroup, and the data lives in memfd from now on */
+    posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+    return !failed;
+}
+
+bool Persistence::readManifest(const std::string &file_name, int fd, void *data, size_t size) {
+    ChunkManifestHeader header;
+    if (!util::Util::PreadAll(fd, reinterpret_cast<char *>(&header), sizeof(header), 0)) {
+        LOG_ERROR("failed to read manifest header of {}: {}", file_name, strerror(errno));
+        return false;
+    }
+    if (header.size != size || header.chunk_size == 0
+        || header.chunk_count != (header.size + header.chunk_size - 1) / header.chunk_size) {
+        LOG_ERROR("manifest {} is broken or mismatched, size {}, chunk size {}, chunk count {}, expect size {}",
+                  file_name, header.size, header.chunk_size, header.chunk_count, size);
+        return false;
+    }
+
+    std::string dir(header.dir_length, '\0');
+    std::vector<unsigned char> digests(header.chunk_count * SHA256_DIGEST_LENGTH);
+    if (!util::Util::PreadAll(fd, dir.data(), dir.size(), sizeof(header))
+        || !util::Util::PreadAll(fd, reinterpret_cast<char *>(digests.data()), digests.size(), sizeof(header) + dir.size())) {
+        LOG_ERROR("failed to read manifest {}: {}", file_name, strerror(errno));
+        return false;
+    }
+
+    auto base = static_cast<char *>(data);
+    std::atomic<bool> failed(false);
+    auto &pool = workerPool();
+    size_t workers = std::min(static_cast<size_t>(header.chunk_count), pool.Size());
+    auto loadChunks = [&](size_t worker) {
+        for (size_t i = worker; i < header.chunk_count && !failed; i += workers) {
+            size_t offset = i * header.chunk_size;
+            size_t len = std::min(static_cast<size_t>(header.chunk_size), size - offset);
+            auto expect = &digests[i * SHA256_DIGEST_LENGTH];
+            auto path = chunkPath(dir, expect);
+
+            int chunk_fd = open(path.c_str(), O_RDONLY);
+            if (chunk_fd < 0) {
+                LOG_ERROR("failed to open chunk {} of {}: {}", path, file_name, strerror(errno));
+                failed = true;
+                return;
+            }
+            bool ok = util::Util::PreadAll(chunk_fd, base + offset, len, 0);
+            close(chunk_fd);
+            if (!ok) {
+                LOG_ERROR("failed to read chunk {} of {}: {}", path, file_name, strerror(errno));
+                failed = true;
+                return;
+            }
+
+            unsigned char digest[SHA256_DIGEST_LENGTH];
+            SHA256(reinterpret_cast<const unsigned char *>(base + offset), len, digest);
+            if (memcmp(digest, expect, SHA256_DIGEST_LENGTH) != 0) {
+                LOG_ERROR("chunk {} of {} is corrupted", path, file_name);
+                failed = true;
+                return;
+            }
+        }
+    };
+
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < workers; i++) {
+        futures.push_back(pool.Submit([&loadChunks, i]() { loadChunks(i); }));
+    }
+    for (auto &f : futures) {
+        f.wait();
+    }
+    if (failed) {
+        return false;
+    }
+    LOG_DEBUG("reassemble {} from {} chunks in {}", file_name, header.chunk_count, dir);
+    return true;
+}
+
+const storage::StripeConfig &Persistence::stripeConfig(const std::string &file_name) {
+    std::error_code ec;
+    auto path = std::filesystem::absolute(file_name, ec).lexically_normal().string();
+    for (auto &c : stripe_configs_) {
+        /* match whole path components, /mnt/a must not match /mnt/ab */
+        if (path.compare(0, c.mount.length(), c.mount) == 0
+            && (c.mount.empty() || c.mount.back() == '/' || path.length() == c.mount.length()
+                || path[c.mount.length()] == '/')) {
+            return c;
+        }
+    }
+    return stripe_configs_.back();
+}
+
+bool Persistence::writeStriped(std::string &file_name, const void *data, size_t size) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto &c = stripeConfig(file_name);
+
+    /* write aside and rename at last, rename is atomic within a filesystem */
+    auto tmp_name = file_name + config::PERSIST_TMP_SUFFIX;
+    int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("failed to open file {} error: {}, you may not have permission to create it",
+                  tmp_name, strerror(errno));
+        return false;
+    }
+
+    /* reserve extents up front so that concurrent stripes do not contend on allocation, best effort */
+    if (size > 0 && fallocate(fd, 0, 0, size) != 0) {
+        LOG_DEBUG("fallocate {} bytes for {} failed: {}", size, tmp_name, strerror(errno));
+    }
+
+    /*
+     * stripe i is written by worker i % concurrency, so a file never occupies more than
+     * concurrency threads of the shared pool
+     */
+    auto base = static_cast<const char *>(data);
+    size_t stripes = (size + c.stripe_size - 1) / c.stripe_size;
+    size_t workers = std::min(stripes, c.concurrency);
+    std::atomic<bool> failed(false);
+    auto writeStripes = [&](size_t worker) {
+        for (size_t i = worker; i < stripes && !failed; i += workers) {
+            size_t offset = i * c.stripe_size;
+            size_t len = std::min(c.stripe_size, size - offset);
+            if (!throttle(file_name, len)) {
+                failed = true;
+                return;
+            }
+            if (!util::Util::PwriteAll(fd, base + offset, len, offset)) {
+                LOG_ERROR("pwrite {} at offset {} length {} failed: {}", tmp_name, offset, len, strerror(errno));
+                failed = true;
+                return;
+            }
+        }
+    };
+
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < workers; i++) {
+        futures.push_back(stripe_pool_->Submit([&writeStripes, i]() { writeStripes(i); }));
+    }
+    for (auto &f : futures) {
+        f.wait();
+    }
+
+    bool ok = !failed;
+    if (ok && fsync(fd) != 0) {
+        LOG_ERROR("failed to fsync file {}: {}", tmp_name, strerror(errno));
+        ok = false;
+    }
+    if (close(fd) != 0 && ok) {
+        LOG_ERROR("failed to close file {}: {}", tmp_name, strerror(errno));
+        ok = false;
+    }
+    if (ok && rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+        LOG_ERROR("failed to rename {} to {}: {}", tmp_name, file_name, strerror(errno));
+        ok = false;
+    }
+    if (!ok) {
+        unlink(tmp_name.c_str());
+        return false;
+    }
+
+    LOG_DEBUG("write {} in {} stripes of {} bytes by {} workers", file_name, stripes, c.stripe_size, workers);
+    user_copy_bytes_ << size;
+    report(config::PERSIST_ENGINE_STRIPED, file_name, size, start_time);
+    return true;
+}
+
+void Persistence::report(const char *engine, std::string &file_name, size_t size,
+                         std::chrono::high_resolution_clock::time_point start_time) {
+    auto timeval = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - start_time);
+    double throughput = timeval.count() > 0 ? static_cast<double>(size) / timeval.count() * 1000000 / 1048576 : 0;
+    LOG_INFO("WriteToDisk performance: engine {} write {} bytes to {} use {} milliseconds, {:.2f} MB/s",
+             engine, size, file_name, timeval.count() / 1000, throughput);
+}
+
+std::string Persistence::objectKey(const std::string &file_name) {
+    auto key = sso_prefix_;
+    if (!key.empty() && key.back() != '/') {
+        key += "/";
+    }
+    /* avoid empty path segment between prefix and absolute file name */
+    size_t begin = file_name.find_first_not_of('/');
+    return begin == std::string::npos ? key : key + file_name.substr(begin);
+}
+
+bool Persistence::WriteToSSO(std::string &file_name, const void *data, size_t size) {
+    if (!sso_client_) {
+        LOG_ERROR("object store is not configured");
+        return false;
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    auto key = objectKey(file_name);
+    auto ok = begin(file_name)
+              && sso_client_->Upload(key, data, size, [this, &file_name](size_t len) { return throttle(file_name, len); });
+    end(file_name, ok);
+    if (!ok) {
+        LOG_ERROR("failed to upload {} to object {}", file_name, key);
+        return false;
+    }
+    report("sso", key, size, start_time);
+    return true;
+}
+
+bool Persistence::ReadFromSSO(const std::string &file_name, void *data, size_t size) {
+    if (!sso_client_) {
+        LOG_ERROR("object store is not configured");
+        return false;
+    }
+    auto key = objectKey(file_name);
+    size_t object_size = 0;
+    if (!sso_client_->Head(key, std::ref(object_size))) {
+        LOG_ERROR("object {} not found", key);
+        return false;
+    }
+    if (object_size != size) {
+        LOG_ERROR("object {} has {} bytes, expect {}", key, object_size, size);
+        return false;
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+    if (!sso_client_->Download(key, data, size)) {
+        LOG_ERROR("failed to download object {}", key);
+        return false;
+    }
     auto timeval = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::high_resolution_clock::now() - start_time);
-    LOG_INFO("WriteToDisk performance: write {} bytes use {} milliseconds", size, timeval.count());
+    LOG_INFO("ReadFromSSO performance: read {} bytes from {} use {} milliseconds", size, key, timeval.count());
     return true;
 }
@@ -0,0 +1,344 @@
+/**
+ * @file placement.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "storage/placement.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <future>
+
+#include <openssl/sha.h>
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using storage::DevicePlacement;
+
+static bool writeStripe(const std::string &path, const char *data, size_t size) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("failed to open file {} error: {}", path, strerror(errno));
+        return false;
+    }
+    bool ok = true;
+    if (!util::Util::PwriteAll(fd, data, size, 0)) {
+        LOG_ERROR("write {} bytes to file {} failed: {}", size, path, strerror(errno));
+        ok = false;
+    }
+    if (ok && fdatasync(fd) != 0) {
+        LOG_ERROR("failed to fdatasync file {}: {}", path, strerror(errno));
+        ok = false;
+    }
+    if (close(fd) != 0 && ok) {
+        LOG_ERROR("failed to close file {}: {}", path, strerror(errno));
+        ok = false;
+    }
+    return ok;
+}
+
+static void putU64(std::string &out, uint64_t value) {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+DevicePlacement::DevicePlacement(const std::vector<std::string> &dirs, size_t stripe_size, size_t concurrency) :
+    stripe_size_(stripe_size), fallback_pool_(concurrency) {
+    for (size_t i = 0; i < dirs.size(); i++) {
+        auto d = std::make_unique<Device>();
+        std::error_code ec;
+        /* directories are recorded in indexes, must not depend on cwd */
+        d->dir = std::filesystem::absolute(dirs[i], ec).lexically_normal().string();
+        std::filesystem::create_directories(d->dir, ec);
+        if (ec) {
+            LOG_FATAL("failed to create directory {}: {}", d->dir, ec.message());
+        }
+        d->pool = std::make_unique<util::ThreadPool>(concurrency);
+        auto prefix = "ckpt_engine_persist_device" + std::to_string(i);
+        d->write_bytes.expose_as(prefix, "write_bytes");
+        d->read_bytes.expose_as(prefix, "read_bytes");
+        d->queue_depth.expose_as(prefix, "queue_depth");
+        d->write_throughput = std::make_unique<bvar::PerSecond<bvar::Adder<int64_t>>>(
+            prefix, "write_throughput", &d->write_bytes);
+        d->read_throughput = std::make_unique<bvar::PerSecond<bvar::Adder<int64_t>>>(
+            prefix, "read_throughput", &d->read_bytes);
+        LOG_INFO("persistence device {}: {}", i, d->dir);
+        devices_.push_back(std::move(d));
+    }
+    LOG_INFO("stripe files across {} directories, stripe size {} MB, {} stripes per directory concurrently",
+             devices_.size(), stripe_size_ >> 20, concurrency);
+}
+
+DevicePlacement::Device *DevicePlacement::device(const std::string &dir) {
+    for (auto &d : devices_) {
+        if (d->dir == dir) {
+            return d.get();
+        }
+    }
+    return nullptr;
+}
+
+bool DevicePlacement::Detect(int fd) {
+    char magic[sizeof(config::PLACEMENT_INDEX_MAGIC)];
+    return pread(fd, magic, sizeof(magic), 0) == sizeof(magic)
+           && memcmp(magic, config::PLACEMENT_INDEX_MAGIC, sizeof(magic)) == 0;
+}
+
+bool DevicePlacement::readIndex(const std::string &file_name, int fd, Index &index) {
+    PlacementIndexHeader header;
+    if (!util::Util::PreadAll(fd, reinterpret_cast<char *>(&header), sizeof(header), 0)) {
+        LOG_ERROR("failed to read placement index header of {}: {}", file_name, strerror(errno));
+        return false;
+    }
+    if (header.stripe_size == 0 || header.dir_count == 0
+        || header.stripe_count != (header.size + header.stripe_size - 1) / header.stripe_size) {
+        LOG_ERROR("placement index {} is broken, size {}, stripe size {}, stripe count {}, dir count {}",
+                  file_name, header.size, header.stripe_size, header.stripe_count, header.dir_count);
+        return false;
+    }
+    index.size = header.size;
+    index.stripe_size = header.stripe_size;
+    off_t offset = sizeof(header);
+    index.name.resize(header.name_length);
+    if (!util::Util::PreadAll(fd, index.name.data(), index.name.size(), offset)) {
+        LOG_ERROR("failed to read placement index {}: {}", file_name, strerror(errno));
+        return false;
+    }
+    offset += index.name.size();
+    for (uint64_t i = 0; i < header.dir_count; i++) {
+        uint64_t len = 0;
+        if (!util::Util::PreadAll(fd, reinterpret_cast<char *>(&len), sizeof(len), offset)) {
+            LOG_ERROR("failed to read placement index {}: {}", file_name, strerror(errno));
+            return false;
+        }
+        offset += sizeof(len);
+        std::string dir(len, '\0');
+        if (!util::Util::PreadAll(fd, dir.data(), dir.size(), offset)) {
+            LOG_ERROR("failed to read placement index {}: {}", file_name, strerror(errno));
+            return false;
+        }
+        offset += dir.size();
+        index.dirs.push_back(std::move(dir));
+    }
+    index.placement.resize(header.stripe_count);
+    if (!util::Util::PreadAll(fd, reinterpret_cast<char *>(index.placement.data()),
+                              index.placement.size() * sizeof(uint32_t), offset)) {
+        LOG_ERROR("failed to read placement index {}: {}", file_name, strerror(errno));
+        return false;
+    }
+    for (auto dir_index : index.placement) {
+        if (dir_index >= index.dirs.size()) {
+            LOG_ERROR("placement index {} is broken, directory {} out of range", file_name, dir_index);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DevicePlacement::Write(const std::string &file_name, const void *data, size_t size,
+                            const std::function<bool(size_t)> &throttle) {
+    /* a reader has no directory to place stripes */
+    if (devices_.empty()) {
+        LOG_ERROR("no directory to place stripes of {}", file_name);
+        return false;
+    }
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    /* stripes of an existing index are removed once the new one is in place */
+    Index old_index;
+    bool has_old_index = false;
+    if (int fd = open(file_name.c_str(), O_RDONLY); fd >= 0) {
+        has_old_index = Detect(fd) && readIndex(file_name, fd, std::ref(old_index));
+        close(fd);
+    }
+
+    /* unique and still readable stripe name, the generation keeps stripes of the published index intact until
+     * the new index replaces it */
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char *>(file_name.data()), file_name.size(), digest);
+    char hex[17];
+    for (int i = 0; i < 8; i++) {
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+    auto generation = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+    Index index;
+    index.size = size;
+    index.stripe_size = stripe_size_;
+    index.name = std::string(hex) + "_" + std::filesystem::path(file_name).filename().string() + "."
+                 + std::to_string(generation);
+    for (auto &d : devices_) {
+        index.dirs.push_back(d->dir);
+    }
+    size_t stripes = (size + stripe_size_ - 1) / stripe_size_;
+    uint32_t first = 0;
+    memcpy(&first, digest + 8, sizeof(first));
+    for (size_t i = 0; i < stripes; i++) {
+        index.placement.push_back((first + i) % devices_.size());
+    }
+
+    auto base = static_cast<const char *>(data);
+    std::atomic<bool> failed(false);
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < stripes; i++) {
+        auto &d = *devices_[index.placement[i]];
+        d.queue_depth << 1;
+        futures.push_back(d.pool->Submit([&, i]() {
+            auto &d = *devices_[index.placement[i]];
+            size_t offset = i * stripe_size_;
+            size_t len = std::min(stripe_size_, size - offset);
+            if (!failed && !throttle(len)) {
+                failed = true;
+            }
+            if (!failed) {
+                auto path = index.StripePath(i);
+                auto tmp_name = path + config::PERSIST_TMP_SUFFIX;
+                if (!writeStripe(tmp_name, base + offset, len) || rename(tmp_name.c_str(), path.c_str()) != 0) {
+                    LOG_ERROR("failed to write stripe {} of {}: {}", path, file_name, strerror(errno));
+                    unlink(tmp_name.c_str());
+                    failed = true;
+                } else {
+                    d.write_bytes << len;
+                }
+            }
+            d.queue_depth << -1;
+        }));
+    }
+    for (auto &f : futures) {
+        f.wait();
+    }
+    if (failed) {
+        removeStripes(index);
+        return false;
+    }
+
+    PlacementIndexHeader header;
+    memcpy(header.magic, config::PLACEMENT_INDEX_MAGIC, sizeof(header.magic));
+    header.size = size;
+    header.stripe_size = stripe_size_;
+    header.stripe_count = stripes;
+    header.name_length = index.name.size();
+    header.dir_count = index.dirs.size();
+    std::string content(reinterpret_cast<const char *>(&header), sizeof(header));
+    content += index.name;
+    for (auto &dir : index.dirs) {
+        putU64(content, dir.size());
+        content += dir;
+    }
+    content.append(reinterpret_cast<const char *>(index.placement.data()), index.placement.size() * sizeof(uint32_t));
+
+    auto tmp_name = file_name + config::PERSIST_TMP_SUFFIX;
+    if (!writeStripe(tmp_name, content.data(), content.size()) || rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+        LOG_ERROR("failed to write placement index {}: {}", file_name, strerror(errno));
+        unlink(tmp_name.c_str());
+        removeStripes(index);
+        return false;
+    }
+
+    if (has_old_index && old_index.name != index.name) {
+        removeStripes(old_index);
+    }
+
+    auto timeval = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - start_time);
+    double throughput = timeval.count() > 0 ? static_cast<double>(size) / timeval.count() * 1000000 / 1048576 : 0;
+    LOG_INFO("WriteToDisk performance: placement write {} bytes to {} in {} stripes use {} milliseconds, {:.2f} MB/s",
+             size, file_name, stripes, timeval.count() / 1000, throughput);
+    return true;
+}
+
+void DevicePlacement::removeStripes(const Index &index) {
+    for (size_t i = 0; i < index.placement.size(); i++) {
+        auto path = index.StripePath(i);
+        if (unlink(path.c_str()) != 0 && errno != ENOENT) {
+            LOG_WARN("failed to remove stripe {}: {}", path, strerror(errno));
+        }
+    }
+}
+
+bool DevicePlacement::Remove(const std::string &file_name) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    Index index;
+    bool ok = Detect(fd) && readIndex(file_name, fd, std::ref(index));
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+    /* index goes first, so a crash in between leaves orphan stripes instead of a dangling index */
+    if (unlink(file_name.c_str()) != 0) {
+        LOG_WARN("failed to remove placement index {}: {}", file_name, strerror(errno));
+        return false;
+    }
+    removeStripes(index);
+    return true;
+}
+
+bool DevicePlacement::Read(const std::string &file_name, int fd, size_t offset, size_t length, void *data) {
+    Index index;
+    if (!readIndex(file_name, fd, std::ref(index))) {
+        return false;
+    }
+    if (offset + length > index.size) {
+        LOG_ERROR("read [{}, {}) exceeds size {} of {}", offset, offset + length, index.size, file_name);
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    auto base = static_cast<char *>(data);
+    std::atomic<bool> failed(false);
+    std::vector<std::future<void>> futures;
+    size_t first = offset / index.stripe_size;
+    size_t last = (offset + length - 1) / index.stripe_size;
+    for (size_t i = first; i <= last; i++) {
+        auto d = device(index.dirs[index.placement[i]]);
+        if (d) {
+            d->queue_depth << 1;
+        }
+        auto &pool = d ? *d->pool : fallback_pool_;
+        futures.push_back(pool.Submit([&, d, i]() {
+            /* intersection of stripe and requested range */
+            size_t begin = std::max(offset, i * index.stripe_size);
+            size_t end = std::min(offset + length, (i + 1) * index.stripe_size);
+            auto path = index.StripePath(i);
+            int stripe_fd = open(path.c_str(), O_RDONLY);
+            if (stripe_fd < 0) {
+                LOG_ERROR("failed to open stripe {} of {}: {}", path, file_name, strerror(errno));
+                failed = true;
+            } else {
+                if (!util::Util::PreadAll(stripe_fd, base + (begin - offset), end - begin, begin - i * index.stripe_size)) {
+                    LOG_ERROR("failed to read stripe {} of {}: {}", path, file_name, strerror(errno));
+                    failed = true;
+                } else if (d) {
+                    d->read_bytes << (end - begin);
+                }
+                close(stripe_fd);
+            }
+            if (d) {
+                d->queue_depth << -1;
+            }
+        }));
+    }
+    for (auto &f : futures) {
+        f.wait();
+    }
+    return !failed;
+}
@@ -11,13 +11,28 @@
 
 #include "storage/storage.h"
 
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <tuple>
+
 #include "monitor/monitor.h"
+#include "operator/persist_queue.h"
+#include "storage/cold_tier.h"
 
 using storage::Storage;
 using api::DataEntry;
 using api::Metadata;
 using config::WorldState;
 using monitor::MemoryMonitor;
+using storage::ColdTier;
+
+static int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
 
 /**
  * @brief release all memory
@@ -38,7 +53,16 @@ bool Storage::Save(Metadata metadata, DataEntry entry) {
     }
 
     rw_mutex_.lock();
-    if (metadata.node_rank == WorldState::Instance().NodeRank()) {
+    if (auto old = find(metadata.file_name); old != nullptr && cold(*old)) {
+        ColdTier::Instance().Remove(metadata.file_name);
+    }
+    auto &residency = residency_[metadata.file_name];
+    residency.iteration = operators::PersistTask::ParseIteration(metadata.iteration);
+    residency.size = metadata.size;
+    residency.primary = metadata.node_rank == WorldState::Instance().NodeRank();
+    residency.access_ms = nowMs();
+    residency.accesses++;
+    if (residency.primary) {
         dict_.insert_or_assign(metadata.file_name, entry);
         rw_mutex_.unlock();
         return true;
@@ -61,8 +85,9 @@ bool Storage::Load(Metadata &metadata, DataEntry &entry) {
             return false;
         }
         entry = iter->second;
+        touch(metadata.file_name);
         rw_mutex_.unlock_shared();
-        return true;
+        return cold(entry) ? rehydrate(metadata, entry) : true;
     }
 
     auto iter = backup_dict_.find(metadata.file_name);
@@ -72,8 +97,17 @@ bool Storage::Load(Metadata &metadata, DataEntry &entry) {
         return false;
     }
     entry = iter->second;
+    touch(metadata.file_name);
     rw_mutex_.unlock_shared();
-    return true;
+    return cold(entry) ? rehydrate(metadata, entry) : true;
+}
+
+bool Storage::Contains(const Metadata &metadata) {
+    std::shared_lock<std::shared_mutex> lock(rw_mutex_);
+    if (metadata.node_rank == WorldState::Instance().NodeRank()) {
+        return dict_.count(metadata.file_name) > 0;
+    }
+    return backup_dict_.count(metadata.file_name) > 0;
 }
 
 bool Storage::Delete(api::Metadata &metadata) {
@@ -85,9 +119,13 @@ bool Storage::Delete(api::Metadata &metadata) {
     if (metadata.node_rank == WorldState::Instance().NodeRank()) {
         auto iter = dict_.find(metadata.file_name);
         if (iter != dict_.end()) {
-            close(iter->second.memfd);
-            MemoryMonitor::Instance().memfdFree(std::ref(metadata), std::ref(iter->second));
+            if (cold(iter->second)) {
+                ColdTier::Instance().Remove(metadata.file_name);
+            } else if (!recycle(metadata, iter->second)) {
+                MemoryMonitor::Instance().memfdFree(std::ref(metadata), std::ref(iter->second));
+            }
             dict_.erase(metadata.file_name);
+            residency_.erase(metadata.file_name);
             LOG_INFO("deleted {} from storage complete in dict_", metadata.file_name);
             rw_mutex_.unlock();
             return true;
@@ -95,15 +133,247 @@ bool Storage::Delete(api::Metadata &metadata) {
     }
     auto iter = backup_dict_.find(metadata.file_name);
     if (iter != backup_dict_.end()) {
-        close(iter->second.memfd);
-        MemoryMonitor::Instance().memfdFree(std::ref(metadata), std::ref(iter->second));
+        if (cold(iter->second)) {
+            ColdTier::Instance().Remove(metadata.file_name);
+        } else if (!recycle(metadata, iter->second)) {
+            MemoryMonitor::Instance().memfdFree(std::ref(metadata), std::ref(iter->second));
+        }
         backup_dict_.erase(metadata.file_name);
+        residency_.erase(metadata.file_name);
         LOG_INFO("deleted {} from storage complete in backup_dict_", metadata.file_name);
     }
     rw_mutex_.unlock();
     return true;
 }
 
+bool Storage::recycle(const Metadata &metadata, const api::DataEntry &entry) {
+    /* pool is keyed by checkpoint size as requested, not mapped size of residency */
+    return MemoryMonitor::Instance().Recycle(metadata, entry);
+}
+
+api::DataEntry *Storage::find(const std::string &file_name) {
+    if (auto iter = dict_.find(file_name); iter != dict_.end()) {
+        return &iter->second;
+    }
+    if (auto iter = backup_dict_.find(file_name); iter != backup_dict_.end()) {
+        return &iter->second;
+    }
+    return nullptr;
+}
+
+void Storage::touch(const std::string &file_name) {
+    if (auto iter = residency_.find(file_name); iter != residency_.end()) {
+        iter->second.access_ms = nowMs();
+        iter->second.accesses++;
+    }
+}
+
+bool Storage::Spill(const Metadata &metadata) {
+    if (!ColdTier::Instance().Enabled()) {
+        return false;
+    }
+    return spill(metadata.file_name, false);
+}
+
+size_t Storage::Reclaim(size_t bytes) {
+    if (!ColdTier::Instance().Enabled()) {
+        return 0;
+    }
+    /* oldest iteration first, then least recently used */
+    std::vector<std::tuple<int64_t, int64_t, std::string, size_t>> candidates;
+    rw_mutex_.lock_shared();
+    for (auto &[file_name, residency] : residency_) {
+        auto entry = find(file_name);
+        if (entry != nullptr && !cold(*entry) && !residency.spilling) {
+            candidates.emplace_back(residency.iteration, residency.access_ms.load(), file_name, residency.size);
+        }
+    }
+    rw_mutex_.unlock_shared();
+    std::sort(candidates.begin(), candidates.end());
+
+    auto meta_client = storage::MetadataClientFactory::GetClient();
+    size_t released = 0;
+    for (auto &[iteration, access_ms, file_name, size] : candidates) {
+        if (released >= bytes) {
+            break;
+        }
+        /* only spill what has been backed up, otherwise backup may still be reading it */
+        Metadata metadata(WorldState::Instance().JobName(), file_name);
+        if (!api::IsSuccess(meta_client->Load(std::ref(metadata)))) {
+            continue;
+        }
+        bool settled = metadata.state == api::CheckpointState::BACKED_UP
+                       || metadata.state == api::CheckpointState::PERSISTENT
+                       || (metadata.state == api::CheckpointState::CACHED && WorldState::Instance().WorldSize() < 2);
+        if (settled && spill(file_name, true)) {
+            released += size;
+        }
+    }
+    LOG_INFO("reclaimed {} bytes of {} bytes requested by spilling to cold tier", released, bytes);
+    return released;
+}
+
+std::map<int64_t, size_t> Storage::IterationBytes() {
+    std::map<int64_t, size_t> bytes;
+    std::shared_lock<std::shared_mutex> lock(rw_mutex_);
+    for (auto &[file_name, entry] : dict_) {
+        auto residency = residency_.find(file_name);
+        if (!cold(entry) && residency != residency_.end()) {
+            bytes[residency->second.iteration] += residency->second.size;
+        }
+    }
+    return bytes;
+}
+
+bool Storage::spill(const std::string &file_name, bool idle_only) {
+    DataEntry entry;
+    int64_t iteration;
+    uint64_t accesses;
+    {
+        std::lock_guard<std::shared_mutex> lock(rw_mutex_);
+        auto found = find(file_name);
+        auto residency = residency_.find(file_name);
+        if (found == nullptr || cold(*found) || residency == residency_.end() || residency->second.spilling) {
+            return false;
+        }
+        if (idle_only && nowMs() - residency->second.access_ms < config::COLD_TIER_MIN_IDLE_SECONDS * 1000) {
+            return false;
+        }
+        /* persistence reads memory directly */
+        if (operators::PersistQueue::Instance().Contains(file_name)) {
+            LOG_DEBUG("{} is being persisted, do not spill", file_name);
+            return false;
+        }
+        residency->second.spilling = true;
+        entry = *found;
+        iteration = residency->second.iteration;
+        accesses = residency->second.accesses;
+    }
+
+    /* memfd may have been truncated to a new size by client */
+    struct stat st;
+    bool ok = fstat(entry.memfd, &st) == 0;
+    std::vector<std::string> evicted;
+    ok = ok && ColdTier::Instance().Put(file_name, entry.memfd, st.st_size, iteration, std::ref(evicted));
+
+    std::vector<std::string> obsolete;
+    {
+        std::lock_guard<std::shared_mutex> lock(rw_mutex_);
+        /* evicted from cold tier, they are gone */
+        for (auto &name : evicted) {
+            auto victim = find(name);
+            if (victim == nullptr || !cold(*victim)) {
+                continue;
+            }
+            if (residency_[name].primary) {
+                obsolete.push_back(name);
+                dict_.erase(name);
+            } else {
+                backup_dict_.erase(name);
+            }
+            residency_.erase(name);
+        }
+
+        auto found = find(file_name);
+        auto residency = residency_.find(file_name);
+        if (residency != residency_.end()) {
+            residency->second.spilling = false;
+        }
+        /* loaded or replaced while writing, someone may be using its memory */
+        if (ok && (found == nullptr || residency == residency_.end() || residency->second.accesses != accesses
+                   || found->address != entry.address || operators::PersistQueue::Instance().Contains(file_name))) {
+            LOG_INFO("{} is accessed while spilling, keep it in memory", file_name);
+            ColdTier::Instance().Remove(file_name);
+            ok = false;
+        }
+        if (ok) {
+            Metadata metadata(WorldState::Instance().JobName(), file_name);
+            metadata.size = residency->second.size;
+            MemoryMonitor::Instance().memfdFree(std::ref(metadata), std::ref(*found), true);
+            found->address = 0;
+            found->memfd = -1;
+            residency->second.size = st.st_size;
+        }
+    }
+
+    for (auto &name : obsolete) {
+        LOG_INFO("{} is evicted from cold tier, mark it as {}", name,
+                 api::CheckpointStateString(api::CheckpointState::OBSOLESCENT));
+    }
+    if (!obsolete.empty()) {
+        auto meta_client = storage::MetadataClientFactory::GetClient();
+        if (!api::IsSuccess(meta_client->BatchUpdateState(obsolete, api::CheckpointState::OBSOLESCENT))) {
+            LOG_ERROR("update metadata state of {} evicted files failed", obsolete.size());
+        }
+    }
+    return ok;
+}
+
+bool Storage::rehydrate(Metadata &metadata, DataEntry &entry) {
+    auto &cold_tier = ColdTier::Instance();
+    Metadata spilled(metadata);
+    spilled.size = cold_tier.Size(metadata.file_name);
+    if (spilled.size == 0) {
+        LOG_ERROR("{} is neither in memory nor in cold tier", metadata.file_name);
+        return false;
+    }
+
+    /* charged to the class it was spilled from */
+    auto cls = monitor::MEMORY_OWN;
+    rw_mutex_.lock_shared();
+    if (auto residency = residency_.find(metadata.file_name);
+        residency != residency_.end() && !residency->second.primary) {
+        cls = monitor::MEMORY_BACKUP;
+    }
+    rw_mutex_.unlock_shared();
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    DataEntry loaded;
+    auto rc = MemoryMonitor::Instance().TryMemfdMalloc(std::ref(spilled), std::ref(loaded), cls);
+    if (api::IsOOM(rc) && Reclaim(spilled.size) > 0) {
+        rc = MemoryMonitor::Instance().TryMemfdMalloc(std::ref(spilled), std::ref(loaded), cls);
+    }
+    if (!api::IsSuccess(rc)) {
+        LOG_ERROR("cannot allocate {} bytes to read {} back from cold tier", spilled.size, metadata.file_name);
+        return false;
+    }
+    bool ok = cold_tier.Get(metadata.file_name, reinterpret_cast<char *>(loaded.address), spilled.size);
+
+    std::lock_guard<std::shared_mutex> lock(rw_mutex_);
+    auto found = find(metadata.file_name);
+    if (ok && found != nullptr && cold(*found)) {
+        *found = loaded;
+        auto &residency = residency_[metadata.file_name];
+        residency.size = spilled.size;
+        residency.access_ms = nowMs();
+        residency.accesses++;
+        cold_tier.Remove(metadata.file_name);
+        entry = loaded;
+        auto timeval = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - start_time);
+        LOG_INFO("read {} of {} bytes back from cold tier use {} milliseconds",
+                 metadata.file_name, spilled.size, timeval.count());
+        return true;
+    }
+    /* failed, or read back or deleted by others meanwhile */
+    MemoryMonitor::Instance().memfdFree(std::ref(spilled), std::ref(loaded), true);
+    if (ok && found != nullptr) {
+        entry = *found;
+        return true;
+    }
+    return false;
+}
+
+void Storage::MarkRestored(const std::string &file_name) {
+    std::lock_guard<std::mutex> lock(restored_mut_);
+    restored_.insert(file_name);
+}
+
+bool Storage::Restored(const std::string &file_name) {
+    std::lock_guard<std::mutex> lock(restored_mut_);
+    return restored_.count(file_name) > 0;
+}
+
 const std::map<std::string, api::DataEntry> &Storage::getDict() const {
     return dict_;
 }
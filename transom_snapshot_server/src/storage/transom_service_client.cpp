@@ -0,0 +1,229 @@
+/**
+ * @file transom_service_client.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "brpc/channel.h"
+
+#include "config/config.h"
+#include "config/world.h"
+#include "logger/logger.h"
+#include "storage/metadata.h"
+#include "storage/metadata_service.h"
+#include "util/util.h"
+
+using storage::MetadataOp;
+using storage::TransomServiceClient;
+
+namespace {
+/**
+ * @brief channel to metadata service shared by clients of the process
+ * @details A single connection is kept, where requests of all threads are pipelined. Writes are sent by one of the
+ * writers at a time, taking all writes queued meanwhile into the same request, so writes of the process are
+ * applied in order and concurrent writers share a round trip.
+ */
+class ServiceChannel {
+public:
+    static ServiceChannel &Instance() {
+        static ServiceChannel instance;
+        return instance;
+    }
+
+    brpc::Channel &Channel() {
+        return channel_;
+    }
+
+    const std::string &Job() const {
+        return job_;
+    }
+
+    /**
+     * @brief send ops, batched with concurrent writes
+     */
+    int Write(const std::vector<MetadataOp> &ops) {
+        Pending pending{&ops};
+        std::unique_lock<std::mutex> lock(mut_);
+        queue_.push_back(&pending);
+        while (!pending.done) {
+            if (sending_) {
+                cv_.wait(lock);
+                continue;
+            }
+            sending_ = true;
+            std::vector<Pending *> batch;
+            size_t size = 0;
+            while (!queue_.empty()
+                   && (batch.empty() || size + queue_.front()->ops->size() <= config::META_SERVICE_BATCH_OPS)) {
+                size += queue_.front()->ops->size();
+                batch.push_back(queue_.front());
+                queue_.pop_front();
+            }
+            lock.unlock();
+            auto rc = send(batch);
+            lock.lock();
+            for (auto item : batch) {
+                item->code = rc;
+                item->done = true;
+            }
+            sending_ = false;
+            cv_.notify_all();
+        }
+        return pending.code;
+    }
+
+private:
+    struct Pending {
+        const std::vector<MetadataOp> *ops;
+        int code = api::STATUS_UNKNOWN_ERROR;
+        bool done = false;
+    };
+
+    ServiceChannel() {
+        addr_ = util::Util::GetEnv(config::ENV_KEY_META_SERVICE_ADDR, config::DEFAULT_META_SERVICE_ADDR);
+        job_ = config::WorldState::Instance().JobName();
+        brpc::ChannelOptions options;
+        options.protocol = brpc::PROTOCOL_BAIDU_STD;
+        options.connection_type = "single";
+        options.timeout_ms = config::META_SERVICE_TIMEOUT_MS;
+        options.connect_timeout_ms = config::META_SERVICE_TIMEOUT_MS;
+        options.max_retry = 3;
+        if (channel_.Init(addr_.c_str(), &options) != 0) {
+            LOG_FATAL("failed to init channel to metadata service {}", addr_);
+        }
+        LOG_INFO("metadata service {}, job {}", addr_, job_);
+    }
+
+    int send(const std::vector<Pending *> &batch) {
+        storage::MetadataWriteRequest request;
+        storage::MetadataWriteResponse response;
+        request.set_job(job_);
+        for (auto item : batch) {
+            for (auto &op : *item->ops) {
+                *request.add_ops() = op;
+            }
+        }
+        brpc::Controller cntl;
+        storage::MetadataService_Stub stub(&channel_);
+        stub.Write(&cntl, &request, &response, nullptr);
+        if (cntl.Failed()) {
+            LOG_ERROR("write {} ops to metadata service {} failed: {}", request.ops_size(), addr_, cntl.ErrorText());
+            return api::STATUS_UNKNOWN_ERROR;
+        }
+        LOG_TRACE("write {} ops of {} writers, {} us", request.ops_size(), batch.size(), cntl.latency_us());
+        return response.code();
+    }
+
+    std::string addr_;
+    std::string job_;
+    brpc::Channel channel_;
+
+    std::deque<Pending *> queue_;
+    bool sending_ = false;
+    std::mutex mut_;
+    std::condition_variable cv_;
+};
+
+MetadataOp makeOp(MetadataOp::Type type, const api::Metadata &metadata) {
+    MetadataOp op;
+    op.set_type(type);
+    storage::ToRow(metadata, op.mutable_row());
+    return op;
+}
+} // namespace
+
+int TransomServiceClient::Save(api::Metadata &metadata) {
+    return ServiceChannel::Instance().Write({makeOp(MetadataOp::SAVE, metadata)});
+}
+
+int TransomServiceClient::BatchSave(std::vector<api::Metadata> &vec) {
+    std::vector<MetadataOp> ops;
+    for (auto &metadata : vec) {
+        ops.push_back(makeOp(MetadataOp::SAVE, metadata));
+    }
+    return ServiceChannel::Instance().Write(ops);
+}
+
+int TransomServiceClient::UpdateState(const std::string &file_name, const api::CheckpointState &state) {
+    return BatchUpdateState({file_name}, state);
+}
+
+int TransomServiceClient::BatchUpdateState(const std::vector<std::string> &file_names,
+                                           const api::CheckpointState &state) {
+    std::vector<MetadataOp> ops;
+    for (auto &file_name : file_names) {
+        api::Metadata metadata("", file_name);
+        metadata.state = state;
+        ops.push_back(makeOp(MetadataOp::UPDATE_STATE, metadata));
+    }
+    return ServiceChannel::Instance().Write(ops);
+}
+
+int TransomServiceClient::DeleteByFileName(const std::string &file_name) {
+    return BatchDelete({file_name});
+}
+
+int TransomServiceClient::BatchDelete(const std::vector<std::string> &file_names) {
+    std::vector<MetadataOp> ops;
+    for (auto &file_name : file_names) {
+        ops.push_back(makeOp(MetadataOp::DELETE, api::Metadata("", file_name)));
+    }
+    return ServiceChannel::Instance().Write(ops);
+}
+
+int TransomServiceClient::Load(api::Metadata &metadata) {
+    auto &channel = ServiceChannel::Instance();
+    storage::MetadataLoadRequest request;
+    storage::MetadataLoadResponse response;
+    request.set_job(channel.Job());
+    request.add_file_names(metadata.file_name);
+    brpc::Controller cntl;
+    storage::MetadataService_Stub stub(&channel.Channel());
+    stub.Load(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        LOG_ERROR("load {} from metadata service failed: {}", metadata.file_name, cntl.ErrorText());
+        return api::STATUS_UNKNOWN_ERROR;
+    }
+    if (!api::IsSuccess(response.code())) {
+        return response.code();
+    }
+    if (response.rows_size() == 0) {
+        LOG_WARN("query primary key {}, not found in metadata service", metadata.file_name);
+        return api::STATUS_NOT_FOUND;
+    }
+    storage::FromRow(response.rows(0), metadata);
+    return api::STATUS_SUCCESS;
+}
+
+int TransomServiceClient::BatchLoad(api::BatchLoadFilter &filter, std::vector<api::Metadata> &vec) {
+    auto &channel = ServiceChannel::Instance();
+    storage::MetadataBatchLoadRequest request;
+    storage::MetadataBatchLoadResponse response;
+    request.set_job(channel.Job());
+    request.set_node_rank(filter.node_rank);
+    request.set_iteration(filter.iteration);
+    request.set_state(filter.state);
+    brpc::Controller cntl;
+    storage::MetadataService_Stub stub(&channel.Channel());
+    stub.BatchLoad(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        LOG_ERROR("batch load with condition <{}> from metadata service failed: {}", filter.String(),
+                  cntl.ErrorText());
+        return api::STATUS_UNKNOWN_ERROR;
+    }
+    for (auto &row : response.rows()) {
+        api::Metadata metadata;
+        storage::FromRow(row, metadata);
+        vec.push_back(metadata);
+    }
+    return response.code();
+}
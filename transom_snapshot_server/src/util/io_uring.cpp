@@ -0,0 +1,185 @@
+/**
+ * @file io_uring.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "util/io_uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "logger/logger.h"
+
+using util::IoUring;
+
+static int ioUringSetup(unsigned entries, io_uring_params *p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+IoUring::IoUring(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    /* may fail with ENOSYS on old kernels or EPERM when forbidden by seccomp */
+    int fd = ioUringSetup(entries, &params);
+    if (fd < 0) {
+        LOG_WARN("io_uring_setup with {} entries failed: {}", entries, strerror(errno));
+        return;
+    }
+
+    sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+        LOG_WARN("mmap io_uring submission queue failed: {}", strerror(errno));
+        sq_ptr_ = nullptr;
+        close(fd);
+        return;
+    }
+    if (single_mmap) {
+        cq_ptr_ = sq_ptr_;
+    } else {
+        cq_ptr_ = mmap(nullptr, cq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq_ptr_ == MAP_FAILED) {
+            LOG_WARN("mmap io_uring completion queue failed: {}", strerror(errno));
+            cq_ptr_ = nullptr;
+            munmap(sq_ptr_, sq_size_);
+            sq_ptr_ = nullptr;
+            close(fd);
+            return;
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    auto sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        LOG_WARN("mmap io_uring sqes failed: {}", strerror(errno));
+        if (cq_ptr_ != sq_ptr_) {
+            munmap(cq_ptr_, cq_size_);
+        }
+        munmap(sq_ptr_, sq_size_);
+        sq_ptr_ = cq_ptr_ = nullptr;
+        close(fd);
+        return;
+    }
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+    auto sq = static_cast<char *>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+    auto cq = static_cast<char *>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    entries_ = params.sq_entries;
+    ring_fd_ = fd;
+}
+
+IoUring::~IoUring() {
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+        munmap(cq_ptr_, cq_size_);
+    }
+    if (sq_ptr_) {
+        munmap(sq_ptr_, sq_size_);
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+    }
+}
+
+bool IoUring::PrepareWrite(int fd, const void *buf, unsigned len, off_t offset, uint64_t user_data) {
+    return prepare(IORING_OP_WRITE, fd, buf, len, offset, user_data);
+}
+
+bool IoUring::PrepareRead(int fd, void *buf, unsigned len, off_t offset, uint64_t user_data) {
+    return prepare(IORING_OP_READ, fd, buf, len, offset, user_data);
+}
+
+bool IoUring::prepare(int opcode, int fd, const void *buf, unsigned len, off_t offset, uint64_t user_data) {
+    unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    unsigned tail = *sq_tail_;
+    if (tail - head >= entries_) {
+        return false;
+    }
+
+    unsigned index = tail & *sq_mask_;
+    auto sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+
+    /* make sqe visible to kernel before tail moves */
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    to_submit_++;
+    return true;
+}
+
+int IoUring::Submit() {
+    int submitted = 0;
+    while (to_submit_ > 0) {
+        int ret = ioUringEnter(ring_fd_, to_submit_, 0, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        /* nothing consumed, retrying would spin forever */
+        if (ret == 0) {
+            errno = EIO;
+            return -EIO;
+        }
+        to_submit_ -= ret;
+        submitted += ret;
+    }
+    return submitted;
+}
+
+int IoUring::WaitCompletion(uint64_t &user_data, int &res) {
+    while (true) {
+        unsigned head = *cq_head_;
+        if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+            auto cqe = &cqes_[head & *cq_mask_];
+            user_data = cqe->user_data;
+            res = cqe->res;
+            __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+            return 0;
+        }
+        if (ioUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            return -errno;
+        }
+    }
+}
@@ -0,0 +1,188 @@
+/**
+ * @file numa.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "util/numa.h"
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "util/util.h"
+
+using util::Numa;
+using util::NumaAffinity;
+
+/* nodes supported by masks below */
+constexpr int MAX_NODES = 256;
+
+static const std::string NODE_DIR = "/sys/devices/system/node/";
+
+static std::string readLine(const std::string &file_name) {
+    std::ifstream infile(file_name);
+    std::string line;
+    std::getline(infile, line);
+    return line;
+}
+
+static std::string policy() {
+    static const std::string policy = util::Util::GetEnv(config::ENV_KEY_NUMA_POLICY, config::NUMA_POLICY_PREFERRED);
+    return policy;
+}
+
+bool Numa::Enabled() {
+    return policy() != config::NUMA_POLICY_OFF && Nodes().size() > 1;
+}
+
+const std::vector<int> &Numa::Nodes() {
+    static const std::vector<int> nodes = ParseList(readLine(NODE_DIR + "online"));
+    return nodes;
+}
+
+std::vector<int> Numa::Cpus(int node) {
+    return ParseList(readLine(NODE_DIR + "node" + std::to_string(node) + "/cpulist"));
+}
+
+std::vector<int> Numa::ParseList(const std::string &list) {
+    std::vector<int> ids;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        auto dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int id = first; id <= last; id++) {
+                ids.push_back(id);
+            }
+        } catch (const std::exception &e) {
+            LOG_WARN("unexpected list {}: {}", list, e.what());
+            return {};
+        }
+    }
+    return ids;
+}
+
+int Numa::NodeOfPid(pid_t pid) {
+    if (!Enabled()) {
+        return -1;
+    }
+    std::ifstream infile("/proc/" + std::to_string(pid) + "/status");
+    std::string line;
+    std::vector<int> allowed;
+    while (std::getline(infile, line)) {
+        if (line.rfind("Cpus_allowed_list:", 0) == 0) {
+            auto list = line.substr(line.find(':') + 1);
+            list.erase(std::remove_if(list.begin(), list.end(), [](unsigned char c) {
+                return std::isspace(c);
+            }), list.end());
+            allowed = ParseList(list);
+            break;
+        }
+    }
+    if (allowed.empty()) {
+        return -1;
+    }
+    for (auto node : Nodes()) {
+        auto cpus = Cpus(node);
+        if (std::all_of(allowed.begin(), allowed.end(), [&cpus](int cpu) {
+                return std::find(cpus.begin(), cpus.end(), cpu) != cpus.end();
+            })) {
+            return node;
+        }
+    }
+    return -1;
+}
+
+bool Numa::Bind(void *addr, size_t len, int node, bool move) {
+    if (!Enabled() || node < 0 || node >= MAX_NODES) {
+        return false;
+    }
+    unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    /* preferred falls back to other nodes rather than OOM */
+    int mode = policy() == config::NUMA_POLICY_BIND ? MPOL_BIND : MPOL_PREFERRED;
+    unsigned flags = move ? MPOL_MF_MOVE : 0;
+    if (syscall(SYS_mbind, addr, len, mode, mask, MAX_NODES + 1, flags) != 0) {
+        LOG_WARN("mbind {} bytes at {} to node {} failed: {}", len, addr, node, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool Numa::Meminfo(int node, size_t &total, size_t &free) {
+    std::ifstream infile(NODE_DIR + "node" + std::to_string(node) + "/meminfo");
+    std::string line;
+    int found = 0;
+    while (std::getline(infile, line)) {
+        /* Node 0 MemTotal:       65536 kB */
+        std::stringstream ss(line);
+        std::string word, id, key;
+        size_t kb;
+        if (!(ss >> word >> id >> key >> kb)) {
+            continue;
+        }
+        if (key == "MemTotal:") {
+            total = kb * 1024;
+            found++;
+        } else if (key == "MemFree:") {
+            free = kb * 1024;
+            found++;
+        }
+    }
+    return found == 2;
+}
+
+NumaAffinity::NumaAffinity(int node) {
+    if (node < 0 || node >= MAX_NODES || !Numa::Enabled()) {
+        return;
+    }
+    auto cpus = Numa::Cpus(node);
+    if (cpus.empty() || pthread_getaffinity_np(pthread_self(), sizeof(saved_), &saved_) != 0) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+        LOG_WARN("pin thread to cpus of node {} failed", node);
+        return;
+    }
+    pinned_ = true;
+    /* bounce buffers of the thread */
+    unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, MAX_NODES + 1) != 0) {
+        LOG_DEBUG("set memory policy of thread to node {} failed: {}", node, strerror(errno));
+    }
+}
+
+NumaAffinity::~NumaAffinity() {
+    if (!pinned_) {
+        return;
+    }
+    pthread_setaffinity_np(pthread_self(), sizeof(saved_), &saved_);
+    syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+}
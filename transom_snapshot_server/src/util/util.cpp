@@ -11,12 +11,78 @@
 
 #include "util/util.h"
 
+#include <linux/magic.h>
 #include <linux/memfd.h>
+#include <sys/vfs.h>
+
+#include <fstream>
+#include <limits>
 
 #include "monitor/monitor.h"
 
 using util::Util;
 
+static const std::string &hugePageMode() {
+    static const std::string mode = Util::GetEnv(config::ENV_KEY_HUGE_PAGE, config::DEFAULT_HUGE_PAGE);
+    return mode;
+}
+
+/* value of key in /proc/meminfo, 0 if not found */
+static size_t readMeminfo(const std::string &key) {
+    std::ifstream infile("/proc/meminfo");
+    std::string name;
+    size_t value;
+    while (infile >> name >> value) {
+        if (name == key + ":") {
+            return value;
+        }
+        infile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return 0;
+}
+
+static size_t roundUp(size_t size, size_t align) {
+    return align == 0 ? size : (size + align - 1) / align * align;
+}
+
+/* false if huge pages are not reserved enough, caller should fall back to normal pages */
+static bool memfdCallocHugetlb(const api::Metadata &metadata, api::DataEntry &entry) {
+    auto page_size = Util::HugePageSize();
+    if (page_size == 0) {
+        return false;
+    }
+    size_t size = roundUp(metadata.size, page_size);
+    /* pages reserved by other mappings are not faulted yet, but taken */
+    size_t free_pages = readMeminfo("HugePages_Free") - readMeminfo("HugePages_Rsvd");
+    if (free_pages * page_size < size) {
+        LOG_DEBUG("{} free huge pages are not enough for {} bytes", free_pages, size);
+        return false;
+    }
+    const int memfd = memfd_create(metadata.file_name.c_str(), MFD_HUGETLB);
+    if (memfd < 0) {
+        LOG_DEBUG("memfd_create with MFD_HUGETLB error: {}", strerror(errno));
+        return false;
+    }
+    if (ftruncate(memfd, size) == -1) {
+        LOG_DEBUG("ftruncate hugetlb memfd error: {}", strerror(errno));
+        close(memfd);
+        return false;
+    }
+    /* huge pages are reserved at mmap, it fails if someone else takes them first */
+    size_t localAddr = reinterpret_cast<size_t>(mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0));
+    if (localAddr == reinterpret_cast<size_t>(MAP_FAILED)) {
+        LOG_DEBUG("mmap hugetlb memfd error: {}", strerror(errno));
+        close(memfd);
+        return false;
+    }
+    entry.address = localAddr;
+    entry.pid = getpid();
+    entry.memfd = memfd;
+    LOG_DEBUG("hugetlb memfd localAddr:{} size:{} pid:{} memfd:{}",
+              reinterpret_cast<void *>(localAddr), size, entry.pid, memfd);
+    return true;
+}
+
 std::string Util::GetEnv(std::string &key, const char *defaultVar) {
     return Util::GetEnv(key.c_str(), defaultVar);
 }
@@ -106,8 +172,10 @@ int Util::memfdCalloc(const api::Metadata &metadata, api::DataEntry &entry) {
         LOG_ERROR("request to calloc non-positive size {}", metadata.size);
         return api::STATUS_UNKNOWN_ERROR;
     }
+    if (hugePageMode() == config::HUGE_PAGE_HUGETLB && memfdCallocHugetlb(metadata, entry)) {
+        return api::STATUS_SUCCESS;
+    }
     /* create shared memory */
-    // const int memfd = memfd_create(metadata.FileName.c_str(), MFD_HUGETLB);
     const int memfd = memfd_create(metadata.file_name.c_str(), 0);
     if (memfd < 0) {
         LOG_ERROR("memfd_create error: {}", strerror(errno));
@@ -132,6 +200,7 @@ int Util::memfdCalloc(const api::Metadata &metadata, api::DataEntry &entry) {
         LOG_ERROR("mmap error: {}", strerror(errno));
         return api::STATUS_UNKNOWN_ERROR;
     }
+    AdviseHugePage(reinterpret_cast<void *>(localAddr), metadata.size);
     entry.address = localAddr;
     entry.pid = pid;
     entry.memfd = memfd;
@@ -149,18 +218,86 @@ int Util::memfdFtruncate(api::Metadata &metadata, api::DataEntry &entry) {
     struct stat sb;
     fstat(entry.memfd, &sb);
     size_t old_size = sb.st_size;
-    if (old_size == metadata.size) {
+    /* hugetlbfs only accepts whole huge pages */
+    size_t new_size = MemfdMappedSize(entry.memfd, metadata.size);
+    if (old_size == new_size) {
         return api::STATUS_SUCCESS;
     }
-    if (ftruncate(entry.memfd, metadata.size) == -1) {
+    if (ftruncate(entry.memfd, new_size) == -1) {
         LOG_ERROR("ftruncate error: {}", strerror(errno));
         return api::STATUS_UNKNOWN_ERROR;
     }
-    LOG_DEBUG("ftruncate size: {} → {}", old_size, metadata.size);
+    LOG_DEBUG("ftruncate size: {} → {}", old_size, new_size);
 
     return api::STATUS_SUCCESS;
 }
 
+size_t Util::MemfdReserveSize(size_t size) {
+    if (hugePageMode() == config::HUGE_PAGE_HUGETLB) {
+        return roundUp(size, HugePageSize());
+    }
+    return size;
+}
+
+size_t Util::MemfdMappedSize(int memfd, size_t size) {
+    struct statfs fs;
+    if (fstatfs(memfd, &fs) == 0 && fs.f_type == HUGETLBFS_MAGIC) {
+        return roundUp(size, HugePageSize());
+    }
+    return size;
+}
+
+size_t Util::HugePageSize() {
+    static const size_t size = readMeminfo("Hugepagesize") * 1024;
+    return size;
+}
+
+void Util::AdviseHugePage(void *address, size_t length) {
+    /* pages faulted through the mapping are huge if shmem_enabled of THP is advise or always */
+    if (hugePageMode() != config::HUGE_PAGE_OFF && madvise(address, length, MADV_HUGEPAGE) != 0) {
+        LOG_DEBUG("madvise MADV_HUGEPAGE error: {}", strerror(errno));
+    }
+}
+
+bool Util::PwriteAll(int fd, const char *data, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        auto n = pwrite(fd, data + done, size - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        /* no progress, retrying would loop forever */
+        if (n == 0) {
+            errno = EIO;
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+bool Util::PreadAll(int fd, char *data, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        auto n = pread(fd, data + done, size - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) { /* file is shorter than expected */
+            errno = ENODATA;
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
 std::string Util::base64_encode(std::string const &data) {
     int counter = 0;
     uint32_t bit_stream = 0;
@@ -0,0 +1,131 @@
+/**
+ * @file compression_test.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief round trip of seekable zstd: compress, detect and read ranges across frame boundaries
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config/config.h"
+#include "logger/logger.h"
+#include "storage/compression.h"
+#include "storage/persistence.h"
+#include "util/thread_pool.h"
+
+int main(int argc, char **argv) {
+    logger::Logger::InitLogger();
+    setenv(config::ENV_KEY_COMPRESSION, config::COMPRESSION_ZSTD, 1);
+    setenv(config::ENV_KEY_COMPRESSION_FRAME_MB, "1", 1);
+
+    std::string dir = "/tmp/compression_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    /* compressible but not uniform, 9 frames of 1MB and a short last frame */
+    size_t frame_size = 1024 * 1024;
+    size_t size = 9 * frame_size + 12345;
+    std::vector<char> data(size);
+    srand(42);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (i % 64 < 48) ? static_cast<char>(i >> 12) : static_cast<char>(rand());
+    }
+
+    util::ThreadPool pool(4);
+    storage::SeekableZstd zstd(1, frame_size);
+    std::string compressed = dir + "/direct.zst";
+    if (!zstd.Write(compressed, data.data(), size, pool, [](size_t) { return true; })) {
+        LOG_ERROR("compress failed");
+        return 1;
+    }
+
+    int fd = open(compressed.c_str(), O_RDONLY);
+    if (fd < 0 || !storage::SeekableZstd::Detect(fd)) {
+        LOG_ERROR("seekable footer of {} not detected", compressed);
+        return 1;
+    }
+
+    std::vector<char> loaded(size);
+    if (!storage::SeekableZstd::Read(compressed, fd, 0, size, loaded.data(), pool)
+        || memcmp(data.data(), loaded.data(), size) != 0) {
+        LOG_ERROR("full read mismatch");
+        return 1;
+    }
+
+    /* ranges inside a frame, across frames, at the tail and of the whole last frame */
+    std::vector<std::pair<size_t, size_t>> ranges = {
+        {0, 1},
+        {100, 4096},
+        {frame_size - 10, 20},
+        {frame_size / 2, 3 * frame_size},
+        {9 * frame_size, 12345},
+        {size - 1, 1},
+    };
+    for (auto &range : ranges) {
+        std::vector<char> part(range.second);
+        if (!storage::SeekableZstd::Read(compressed, fd, range.first, range.second, part.data(), pool)
+            || memcmp(data.data() + range.first, part.data(), range.second) != 0) {
+            LOG_ERROR("range read [{}, {}) mismatch", range.first, range.first + range.second);
+            return 1;
+        }
+    }
+
+    /* out of range must be rejected */
+    std::vector<char> beyond(2);
+    if (storage::SeekableZstd::Read(compressed, fd, size - 1, 2, beyond.data(), pool)) {
+        LOG_ERROR("read beyond end not rejected");
+        return 1;
+    }
+    close(fd);
+
+    /* a plain file is not mistaken for compressed one */
+    std::string plain = dir + "/plain";
+    fd = open(plain.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0 || write(fd, data.data(), frame_size) != static_cast<ssize_t>(frame_size)
+        || storage::SeekableZstd::Detect(fd)) {
+        LOG_ERROR("plain file detected as compressed");
+        return 1;
+    }
+    close(fd);
+
+    /* persistence writes beside the checkpoint path and leaves the path itself for plain checkpoints */
+    auto &persistence = storage::Persistence::Instance();
+    std::string file_name = dir + "/rank0.pt";
+    if (!persistence.WriteToDisk(file_name, data.data(), size, -1)) {
+        LOG_ERROR("persist {} failed", file_name);
+        return 1;
+    }
+    if (std::filesystem::exists(file_name)
+        || !std::filesystem::exists(file_name + config::PERSIST_COMPRESSED_SUFFIX)) {
+        LOG_ERROR("compressed checkpoint is not written beside {}", file_name);
+        return 1;
+    }
+    std::fill(loaded.begin(), loaded.end(), 0);
+    if (!persistence.ReadFromDisk(file_name, loaded.data(), size)
+        || memcmp(data.data(), loaded.data(), size) != 0) {
+        LOG_ERROR("read {} back mismatch", file_name);
+        return 1;
+    }
+    std::vector<char> part(3 * frame_size);
+    if (!persistence.ReadRangeFromDisk(file_name, frame_size / 2, part.size(), part.data())
+        || memcmp(data.data() + frame_size / 2, part.data(), part.size()) != 0) {
+        LOG_ERROR("range read {} back mismatch", file_name);
+        return 1;
+    }
+
+    std::filesystem::remove_all(dir);
+    LOG_INFO("compression round trip of {} bytes succeeded", size);
+    return 0;
+}
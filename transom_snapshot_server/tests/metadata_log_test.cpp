@@ -0,0 +1,113 @@
+/**
+ * @file metadata_log_test.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief replay of metadata log with torn tails, left by a crash or by a failed append followed by valid ones
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "logger/logger.h"
+#include "storage/metadata_log.h"
+
+using storage::MetadataLog;
+
+static MetadataLog::Record record(const std::string &file_name) {
+    return {MetadataLog::SAVE, api::Metadata("job", file_name, 0, "iter0")};
+}
+
+static std::vector<std::string> replay(const std::string &path) {
+    std::vector<std::string> file_names;
+    MetadataLog::Replay(path, [&](MetadataLog::Op op, api::Metadata &metadata) {
+        file_names.push_back(metadata.file_name);
+    });
+    return file_names;
+}
+
+int main(int argc, char **argv) {
+    logger::Logger::InitLogger();
+    std::string dir = "/tmp/metadata_log_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::string path = dir + "/metadata.log";
+
+    /* a crash leaves a torn tail, replay cuts it and records appended afterwards are reachable */
+    {
+        MetadataLog log(path);
+        if (!log.Open() || !log.Append({record("a"), record("b")}, true)) {
+            LOG_ERROR("append to {} failed", path);
+            return 1;
+        }
+    }
+    auto size = std::filesystem::file_size(path);
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_APPEND);
+        std::string torn(13, 'x');
+        if (fd < 0 || write(fd, torn.data(), torn.size()) != static_cast<ssize_t>(torn.size())) {
+            LOG_ERROR("failed to tear {}", path);
+            return 1;
+        }
+        close(fd);
+    }
+    if (replay(path) != std::vector<std::string>{"a", "b"} || std::filesystem::file_size(path) != size) {
+        LOG_ERROR("torn tail left by a crash is not cut");
+        return 1;
+    }
+    {
+        MetadataLog log(path);
+        if (!log.Open() || !log.Append({record("c")}, true)) {
+            LOG_ERROR("append to {} failed", path);
+            return 1;
+        }
+    }
+    if (replay(path) != std::vector<std::string>{"a", "b", "c"}) {
+        LOG_ERROR("records appended after a torn tail are lost");
+        return 1;
+    }
+
+    /* an append cut short by file size limit must not hide records acknowledged after it */
+    MetadataLog log(path);
+    if (!log.Open()) {
+        LOG_ERROR("open {} failed", path);
+        return 1;
+    }
+    signal(SIGXFSZ, SIG_IGN);
+    struct rlimit origin;
+    getrlimit(RLIMIT_FSIZE, &origin);
+    struct rlimit limited = origin;
+    limited.rlim_cur = std::filesystem::file_size(path) + 20;
+    setrlimit(RLIMIT_FSIZE, &limited);
+    std::vector<MetadataLog::Record> records;
+    for (int i = 0; i < 100; i++) {
+        records.push_back(record("lost" + std::to_string(i)));
+    }
+    bool appended = log.Append(records, true);
+    setrlimit(RLIMIT_FSIZE, &origin);
+    if (appended) {
+        LOG_ERROR("append beyond file size limit succeeded");
+        return 1;
+    }
+    if (!log.Append({record("d")}, true)) {
+        LOG_ERROR("append after a failed one failed");
+        return 1;
+    }
+    if (replay(path) != std::vector<std::string>{"a", "b", "c", "d"}) {
+        LOG_ERROR("records appended after a failed append are lost");
+        return 1;
+    }
+
+    std::filesystem::remove_all(dir);
+    LOG_INFO("metadata log replay succeeded");
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file metadata_service_test.cpp
+ * @author xial-thu (lovenashbest@126.com)
+ * @brief run metadata service on localhost and drive it by TransomServiceClient
+ * @version 0.1
+ * @date 2026-10-16
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+#include "brpc/server.h"
+
+#include "storage/metadata.h"
+#include "storage/metadata_service.h"
+
+int main(int argc, char **argv) {
+    std::string dir = "/tmp/ckpt_engine_meta_service_test";
+    std::filesystem::remove_all(dir);
+    storage::MetadataServiceImpl service(dir, 4);
+    brpc::Server server;
+    if (server.AddService(&service, brpc::SERVER_DOESNT_OWN_SERVICE) != 0 || server.Start(15399, nullptr) != 0) {
+        LOG_ERROR("cannot start metadata server");
+        return 1;
+    }
+    setenv(config::ENV_KEY_META_CLIENT, config::META_CLIENT_TRANSOM, 1);
+    setenv(config::ENV_KEY_META_SERVICE_ADDR, "127.0.0.1:15399", 1);
+    auto client = storage::MetadataClientFactory::GetDatabaseClient();
+    int rc = -1;
+
+    /* concurrent writers share requests */
+    std::vector<std::thread> threads;
+    std::atomic<int> failures = 0;
+    for (int rank = 0; rank < 8; rank++) {
+        threads.emplace_back([rank, &failures]() {
+            auto client = storage::MetadataClientFactory::GetDatabaseClient();
+            for (int i = 0; i < 100; i++) {
+                api::Metadata metadata("test", "rank" + std::to_string(rank) + "_" + std::to_string(i), rank,
+                                       std::to_string(i / 10), api::PENDING, i);
+                if (!api::IsSuccess(client->Save(metadata))
+                    || !api::IsSuccess(client->UpdateState(metadata.file_name, api::CACHED))) {
+                    failures++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (failures > 0) {
+        LOG_ERROR("{} writes failed", failures.load());
+        return 1;
+    }
+
+    api::Metadata query("test", "rank3_42");
+    rc = client->Load(std::ref(query));
+    if (!api::IsSuccess(rc) || query.node_rank != 3 || query.state != api::CACHED || query.size != 42) {
+        LOG_ERROR("unexpected metadata {}", query.String());
+        return 1;
+    }
+
+    api::BatchLoadFilter filter1(3);
+    std::vector<api::Metadata> vec1;
+    rc = client->BatchLoad(std::ref(filter1), std::ref(vec1));
+    if (!api::IsSuccess(rc) || vec1.size() != 100) {
+        LOG_ERROR("batch load of rank 3 returns {} rows", vec1.size());
+        return 1;
+    }
+
+    api::BatchLoadFilter filter2(-1, "4", api::CACHED);
+    std::vector<api::Metadata> vec2;
+    rc = client->BatchLoad(std::ref(filter2), std::ref(vec2));
+    if (!api::IsSuccess(rc) || vec2.size() != 80) {
+        LOG_ERROR("batch load of iteration 4 returns {} rows", vec2.size());
+        return 1;
+    }
+
+    std::vector<std::string> file_names;
+    for (auto &metadata : vec2) {
+        file_names.push_back(metadata.file_name);
+    }
+    rc = client->BatchDelete(file_names);
+    std::vector<api::Metadata> vec3;
+    if (!api::IsSuccess(rc) || !api::IsNotFound(client->BatchLoad(std::ref(filter2), std::ref(vec3)))) {
+        LOG_ERROR("batch delete failed");
+        return 1;
+    }
+
+    api::Metadata deleted("test", file_names[0]);
+    if (!api::IsNotFound(client->Load(std::ref(deleted)))) {
+        LOG_ERROR("{} is not deleted", file_names[0]);
+        return 1;
+    }
+    LOG_INFO("metadata service test passed");
+    server.Stop(0);
+    return 0;
+}